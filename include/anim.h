@@ -18,13 +18,14 @@
 #include "state.h"
 #include "types.h"
 #include "calcs.h"
+#include "id.h"
 
 // The anim namespace stores objects necessary for animating any sort of value.
 namespace anim {
 
     // How to identify attributes, animations, and states.
     using animation_id = std::string;
-    using attribute_id = std::string;
+    using attribute_id = id::Identifier;
     using state_id = std::string;
 
     // Concepts
@@ -92,6 +93,121 @@ namespace anim {
             }
         }
     }
+    // Returns whether the path is LinearPath.
+    bool IsLinearPath(const Path& path) {
+        auto fn = path.target<void(*)(const std::vector<Point>&, float, types::Value&)>();
+        return fn != nullptr && *fn == LinearPath;
+    }
+
+    // Points compiled for fast sampling. The times, values, and easings of the points are stored contiguously
+    // and the calculator is resolved once. Sampling uses a cursor so sequential playback doesn't search and
+    // seeking is a binary search.
+    class Track {
+    public:
+        using ease_type = float(*)(float);
+
+        // Compiles the points, returns null if they can't be compiled. Points can be compiled when there's
+        // at least one, they are sorted by time, and they all hold trivially copyable values of one type that
+        // has a calculator.
+        static std::shared_ptr<const Track> Compile(const std::vector<Point>& points) {
+            if (points.empty() || !points[0].data.IsValid()) {
+                return nullptr;
+            }
+            auto type = points[0].data.GetType();
+            auto calculator = calc::For(type);
+            if (calculator == nullptr) {
+                return nullptr;
+            }
+            auto track = std::make_shared<Track>();
+            track->m_type = type;
+            track->m_calc = calculator;
+            track->m_stride = type->Size();
+            track->m_values.resize((points.size() * track->m_stride + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t));
+            for (size_t i = 0; i < points.size(); i++) {
+                auto& point = points[i];
+                if (!point.data.IsValid() || !point.data.GetType()->IsTrivial() || !type->IsCompatible(point.data.GetType())) {
+                    return nullptr;
+                }
+                if (i > 0 && point.time < points[i - 1].time) {
+                    return nullptr;
+                }
+                track->m_times.push_back(point.time);
+                memcpy(track->value(i), point.data.Data(), track->m_stride);
+
+                auto ease = point.easing ? point.easing.target<ease_type>() : nullptr;
+                track->m_eases.push_back(ease != nullptr ? *ease : nullptr);
+                if (point.easing && ease == nullptr) {
+                    track->m_customEases.resize(points.size());
+                    track->m_customEases[i] = point.easing;
+                }
+            }
+            return track;
+        }
+
+        // Samples the track at the time like LinearPath. The cursor should start at 0 and be given back on 
+        // each sample of this track. False is returned and out is left unchanged where LinearPath would not set it,
+        // at or past the time of the last point.
+        bool Sample(float time, size_t& cursor, types::Value& out) const {
+            auto i = seek(time, cursor);
+            if (i == 0) {
+                return false;
+            }
+            cursor = i;
+            if (!out.IsValid() || !m_type->IsCompatible(out.GetType())) {
+                return false;
+            }
+            auto prev = i - 1;
+            auto delta = (time - m_times[prev]) / (m_times[i] - m_times[prev]);
+            auto easingDelta = ease(prev, delta);
+            m_calc->LerpN(value(prev), value(i), &easingDelta, out.Data(), 1);
+            return true;
+        }
+        // The number of points on the track.
+        constexpr size_t Size() const noexcept { return m_times.size(); }
+        // The type of values on the track.
+        constexpr types::Type* GetType() const noexcept { return m_type; }
+        // The time of the point at index.
+        constexpr float Time(size_t index) const noexcept { return m_times[index]; }
+
+    private:
+        types::Type* m_type = nullptr;
+        calc::ValueCalculator* m_calc = nullptr;
+        size_t m_stride = 0;
+        std::vector<float> m_times;
+        std::vector<std::max_align_t> m_values;
+        std::vector<ease_type> m_eases;
+        // Easings that are not plain functions, only populated when there are any.
+        std::vector<Easing> m_customEases;
+
+        void* value(size_t index) noexcept { return reinterpret_cast<char*>(m_values.data()) + index * m_stride; }
+        const void* value(size_t index) const noexcept { return reinterpret_cast<const char*>(m_values.data()) + index * m_stride; }
+
+        float ease(size_t index, float delta) const {
+            if (m_eases[index] != nullptr) {
+                return m_eases[index](delta);
+            }
+            if (!m_customEases.empty() && m_customEases[index]) {
+                return m_customEases[index](delta);
+            }
+            return delta;
+        }
+        // Returns the first index after 0 with a time greater than the given time, or 0 if there is none.
+        // The cursor is checked first and then the index after it before searching.
+        size_t seek(float time, size_t cursor) const noexcept {
+            auto n = m_times.size();
+            for (auto i = cursor; i <= cursor + 1 && i < n; i++) {
+                if (i > 0 && time < m_times[i] && (i == 1 || time >= m_times[i - 1])) {
+                    return i;
+                }
+            }
+            if (n < 2) {
+                return 0;
+            }
+            auto found = std::upper_bound(m_times.begin() + 1, m_times.end(), time);
+            return found == m_times.end() ? 0 : size_t(found - m_times.begin());
+        }
+    };
+
     void QuadraticPath(const std::vector<Point>& points, float d1, types::Value& out) {
         auto d2 = d1 * d1;
         auto i1 = 1 - d1;
@@ -258,6 +374,8 @@ namespace anim {
         attribute_id attribute;
         AnimationOptions options;
         std::vector<Point> points;
+        // The compiled points, used instead of LinearPath when set. See Compile.
+        std::shared_ptr<const Track> track;
     };
     struct Animation {
         animation_id name;
@@ -265,6 +383,18 @@ namespace anim {
         std::vector<AnimationAttribute> attributes;
     };
 
+    // Compiles the points of each attribute in the animation into tracks that are sampled when the attribute is
+    // animated with LinearPath (or no path). Returns the number of attributes compiled. Compile again after 
+    // changing points.
+    size_t Compile(Animation& animation) {
+        size_t compiled = 0;
+        for (auto& attr : animation.attributes) {
+            attr.track = Track::Compile(attr.points);
+            compiled += attr.track != nullptr;
+        }
+        return compiled;
+    }
+
     struct AttributeAnimator {
         animation_id animation;
         const AnimationAttribute* attribute;
@@ -282,6 +412,7 @@ namespace anim {
         bool done;
         bool apply;
         float applyDelta;
+        size_t cursor = 0; // where in the attribute's track it was last sampled
 
         AttributeAnimator() = default;
         AttributeAnimator(const animation_id& anim, const AnimationAttribute* attr, const AnimationOptions opts): 
@@ -334,49 +465,161 @@ namespace anim {
             scale = options.scale.Get(1);
         }
     };
+    // Values reused each update of an attribute so updating doesn't allocate. They are prepared for the type of
+    // the attribute's value on first use. Copies start unprepared so attributes never share them.
+    struct AttributeScratch {
+        types::Type* type = nullptr;
+        calc::ValueCalculator* calculator = nullptr;
+        types::Value zero;
+        types::Value sample;
+        types::Value total;
+
+        AttributeScratch() = default;
+        AttributeScratch(const AttributeScratch&) {}
+        AttributeScratch& operator=(const AttributeScratch&) { return *this; }
+
+        // Prepares the values for the type and resets sample & total, returns false if the type can't be animated.
+        bool Prepare(types::Type* valueType) {
+            if (valueType != type) {
+                type = valueType;
+                calculator = calc::For(type);
+                if (calculator != nullptr) {
+                    zero = calculator->Create();
+                    sample = calculator->Create();
+                    total = calculator->Create();
+                }
+            }
+            if (calculator == nullptr) {
+                return false;
+            }
+            sample.Set(zero);
+            total.Set(zero);
+            return true;
+        }
+    };
+    // How much work is done updating an animator or one of its attributes, so things that matter less cost less.
+    struct LevelOfDetail {
+        float interval = 0; // seconds between updates, dt accumulates in between (0=every update)
+        float minScale = 0; // animations with a scale at or below this aren't sampled, see Animator::minEffectiveScale
+        bool frozen = false; // updates are skipped and their dt dropped
+    };
+
+    // Counts of the work done and skipped updating animators.
+    struct UpdateStats {
+        size_t updates = 0; // animator updates requested
+        size_t frozen = 0; // animator updates skipped while frozen
+        size_t throttled = 0; // animator updates skipped waiting for the interval
+        size_t attributes = 0; // attributes updated
+        size_t attributesThrottled = 0; // attribute updates skipped waiting for the interval
+        size_t samples = 0; // animations sampled
+        size_t skippedScale = 0; // animations not sampled because their scale was too small
+
+        UpdateStats& operator+=(const UpdateStats& other) noexcept {
+            updates += other.updates;
+            frozen += other.frozen;
+            throttled += other.throttled;
+            attributes += other.attributes;
+            attributesThrottled += other.attributesThrottled;
+            samples += other.samples;
+            skippedScale += other.skippedScale;
+            return *this;
+        }
+    };
+
+    // Accumulates dt until the interval of the level of detail has passed. Returns true if an update should
+    // happen and sets dt to the time accumulated.
+    bool Throttle(const LevelOfDetail& lod, float& elapsed, float& dt) noexcept {
+        if (lod.interval <= 0) {
+            return true;
+        }
+        elapsed += dt;
+        if (elapsed < lod.interval) {
+            return false;
+        }
+        dt = elapsed;
+        elapsed = 0;
+        return true;
+    }
+
     struct Attribute {
         std::vector<AttributeAnimator> animators;
         long frame;
         long lastUpdatedFrame;
+        AttributeScratch scratch;
+        LevelOfDetail lod;
+        float elapsed = 0; // dt accumulated waiting for the interval of lod
 
         Attribute() = default;
 
         void Update(float dt, types::Value& value) {
-            auto c = calc::For(value.GetType());
-            auto temp1 = c->Create();
-            auto temp2 = c->Create();
+            auto stats = UpdateStats{};
+            Update(dt, value, LevelOfDetail{}, stats);
+        }
+        // Updates with the level of detail of the animator this attribute is on, counting the work in stats.
+        void Update(float dt, types::Value& value, const LevelOfDetail& animatorLOD, UpdateStats& stats) {
+            PROFILE_ZONE("anim::Attribute::Update")
+            if (lod.frozen) {
+                return;
+            }
+            if (!Throttle(lod, elapsed, dt)) {
+                stats.attributesThrottled++;
+                return;
+            }
+            if (!scratch.Prepare(value.GetType())) {
+                return;
+            }
+            auto minScale = std::max(lod.minScale, animatorLOD.minScale);
+            stats.attributes++;
+            auto c = scratch.calculator;
+            auto& sample = scratch.sample;
+            auto& total = scratch.total;
+            auto anyDone = false;
+            [[maybe_unused]] auto samplesBefore = stats.samples;
 
             frame++;
 
-            auto animator = animators.begin();
-            while (animator != animators.end()) {
-                animator->Update(dt);
-                if (animator->apply) {
-                    auto scale = animator->scale;
-                    if (scale > 0) {
-                        auto& path = animator->options.path;
+            for (auto& animator : animators) {
+                animator.Update(dt);
+                if (animator.apply) {
+                    auto scale = animator.scale;
+                    if (scale > 0 && scale <= minScale) {
+                        stats.skippedScale++;
+                    } else if (scale > 0) {
+                        stats.samples++;
+                        auto& path = animator.options.path;
                         if (!path) {
                             path = LinearPath;
                         }
-                        path(animator->attribute->points, animator->applyDelta, temp1);
-                        temp2.Set(c->Adds(temp2, temp1, scale));
+                        auto& track = animator.attribute->track;
+                        if (track && IsLinearPath(path)) {
+                            track->Sample(animator.applyDelta, animator.cursor, sample);
+                        } else {
+                            path(animator.attribute->points, animator.applyDelta, sample);
+                        }
+                        c->AddsN(total.Data(), sample.Data(), &scale, total.Data(), 1);
 
                         lastUpdatedFrame = frame;
                     }
-                    LOG(debug, "Attribute::Update applying for "<<animator->animation<<"."<<animator->attribute->attribute<<" with scale "<<scale)
+                    LOG(debug, "Attribute::Update applying for "<<animator.animation<<"."<<animator.attribute->attribute<<" with scale "<<scale)
                 }
 
-                if (animator->done) {
-                    LOG(info, "Attribute::Update animator for "<<animator->animation<<"."<<animator->attribute->attribute<<" done after "<<animator->time)
+                if (animator.done) {
+                    LOG(info, "Attribute::Update animator for "<<animator.animation<<"."<<animator.attribute->attribute<<" done after "<<animator.time)
 
-                    animators.erase(animator);
-                } else {
-                    animator++;
+                    anyDone = true;
                 }
             }
 
+            // Each sample is a path or track sample and an AddsN on the calculator.
+            PROFILE_COUNT("calc::ValueCalculator", stats.samples - samplesBefore)
+
+            // Finished animators are removed once at the end, keeping the order of the rest.
+            if (anyDone) {
+                std::erase_if(animators, [](const AttributeAnimator& animator) { return animator.done; });
+            }
+
             if (lastUpdatedFrame == frame) {
-                value.Set(temp2);
+                value.Set(total);
             }
         }
         bool WasUpdated() {
@@ -429,8 +672,12 @@ namespace anim {
 
     using AnimateRequest = std::tuple<const Animation&, AnimationOptions>;
 
+    // Values keyed by attribute, stored contiguously in the order the attributes were first added.
+    template<typename V>
+    using AttributeMap = id::DenseMap<V, id::id_t, uint32_t, true>;
+
     struct AttributeSet {
-        std::map<attribute_id, Attribute> set;
+        AttributeMap<Attribute> set;
 
         AttributeSet() = default;
         AttributeSet(const std::vector<AnimateRequest>& requests) {
@@ -440,12 +687,7 @@ namespace anim {
                 
                 for (auto& animAttr : anim.attributes) {
                     auto resolvedOptions = anim.options.Join(animAttr.options).Join(options);
-                    auto existing = GetAttribute(animAttr.attribute);
-                    if (existing == nullptr) {
-                        set[animAttr.attribute] = Attribute{};
-                        existing = GetAttribute(animAttr.attribute);
-                    }
-                    existing->animators.emplace_back(
+                    set.Take(animAttr.attribute).animators.emplace_back(
                         anim.name,
                         &animAttr,
                         resolvedOptions
@@ -453,37 +695,42 @@ namespace anim {
                 }
             }
         }
-        Attribute* GetAttribute(const attribute_id& name) {
-            auto iter = set.find(name);
-            return iter == set.end() ? nullptr : &iter->second;
+        Attribute* GetAttribute(id::IdentifierMaybe name) {
+            return set.Ptr(name);
         }
-        const Attribute* GetAttribute(const attribute_id& name) const {
-            auto iter = set.find(name);
-            return iter == set.end() ? nullptr : &iter->second;
+        const Attribute* GetAttribute(id::IdentifierMaybe name) const {
+            return set.Ptr(name);
         }
         bool IsAnimating(const animation_id& animation) const noexcept {
-            for (auto& attr : set) {
-                if (attr.second.IsAnimating(animation)) {
+            auto& attrs = set.Values();
+            for (size_t i = 0; i < attrs.size(); i++) {
+                if (!set.IsRemoved(i) && attrs[i].IsAnimating(animation)) {
                     return true;
                 }
             }
             return false;
         }
         void Transition(const AttributeSet& attrs, const TransitionOptions& options, const std::unordered_set<animation_id>& outro) {
-            for (auto& attr : attrs.set) {
-                if (attr.second.animators.empty()) {
+            auto& keys = attrs.set.Keys();
+            auto& values = attrs.set.Values();
+            for (size_t i = 0; i < values.size(); i++) {
+                auto& key = keys[i];
+                auto& attr = values[i];
+                if (attrs.set.IsRemoved(i) || attr.animators.empty()) {
                     continue;
                 }
 
-                auto existing = GetAttribute(attr.first);
+                auto existing = GetAttribute(key);
 
-                LOG(info, "AttributeSet::Transition "<<attr.first<<" new animators: "<<attr.second.animators.size())
-                if (existing == nullptr || existing->animators.empty()) {
-                    set[attr.first] = attr.second;
+                LOG(info, "AttributeSet::Transition "<<key<<" new animators: "<<attr.animators.size())
+                if (existing == nullptr) {
+                    set.Take(key) = attr;
+                } else if (existing->animators.empty()) {
+                    existing->animators = attr.animators;
                 } else {
                     auto forOutro = existing->ForAnimations(outro);
                     if (forOutro.size() > 0) {
-                        auto& nextUp = attr.second.animators;
+                        auto& nextUp = attr.animators;
                         float minDelay = nextUp[0].delay;
                         for (int i = 1; i < nextUp.size(); i++) {
                             float animatorDelay = nextUp[i].delay;
@@ -501,14 +748,14 @@ namespace anim {
                     // see: https://github.com/anim8js/anim8js/blob/master/src/AttrimatorMap.js#L269
                     existing->animators.insert(
                         existing->animators.end(), 
-                        attr.second.animators.begin(),
-                        attr.second.animators.end()
+                        attr.animators.begin(),
+                        attr.animators.end()
                     );
                 }
             }
 
             for (auto& attr : set) {
-                auto forOutro = attr.second.ForAnimations(outro);
+                auto forOutro = attr.ForAnimations(outro);
                 for (auto& animator : forOutro) {
                     if (!animator->IsStopping()) {
                         animator->StopIn(0);
@@ -516,32 +763,50 @@ namespace anim {
                 }
             }
         }
-        void Update(float dt, std::map<attribute_id, types::Value>& values) {
-            for (auto& attr : set) {
-                auto value = values.find(attr.first);
-                if (value != values.end()) {
-                    attr.second.Update(dt, value->second);
+        void Update(float dt, AttributeMap<types::Value>& values) {
+            auto stats = UpdateStats{};
+            Update(dt, values, LevelOfDetail{}, stats);
+        }
+        void Update(float dt, AttributeMap<types::Value>& values, const LevelOfDetail& lod, UpdateStats& stats) {
+            auto& keys = set.Keys();
+            auto& attrs = set.Values();
+            for (size_t i = 0; i < attrs.size(); i++) {
+                if (set.IsRemoved(i)) {
+                    continue;
+                }
+                auto value = values.Ptr(keys[i]);
+                if (value != nullptr) {
+                    attrs[i].Update(dt, *value, lod, stats);
                 }
             }
         }
         void ApplyOptions(const animation_id& animation, const AnimationOptions& effect) {
             for (auto& attr : set) {
-                attr.second.ApplyOptions(animation, effect);
+                attr.ApplyOptions(animation, effect);
             }
         }
         void StopIn(const animation_id& animation, float dt) {
             for (auto& attr : set) {
-                attr.second.StopIn(animation, dt);
+                attr.StopIn(animation, dt);
             }
         }
     };
 
+    class AnimatorPool;
+
     struct Animator {
         AttributeSet attributes;
-        std::map<attribute_id, types::Value> values;
+        AttributeMap<types::Value> values;
         float minTotalScale;
         float maxTotalScale;
         float minEffectiveScale;
+        // The pool the animator belongs to, which defers its updates. See AnimatorPool.
+        AnimatorPool* pool = nullptr;
+        size_t poolIndex = 0;
+        // The level of detail of the whole animator, each attribute can have their own as well.
+        LevelOfDetail lod;
+        float lodElapsed = 0;
+        UpdateStats stats;
 
         Animator() = default;
 
@@ -551,15 +816,36 @@ namespace anim {
         void Transition(const std::vector<AnimateRequest>& requests, const TransitionOptions& options, const std::unordered_set<animation_id>& outro) {
             auto transitionAttributes = AttributeSet(requests);
 
-            LOG(info, "Animator::Transition "<<requests.size()<<" to attributes: "<<transitionAttributes.set.size())
+            LOG(info, "Animator::Transition "<<requests.size()<<" to attributes: "<<transitionAttributes.set.Size())
 
             attributes.Transition(transitionAttributes, options, outro);
         }
         void ApplyOptions(const animation_id& animation, const AnimationOptions& effect) {
             attributes.ApplyOptions(animation, effect);
         }
-        void Update(float dt) {
-            attributes.Update(dt, values);
+        // Updates the animator, or if it belongs to a pool defers the update until the pool is flushed.
+        void Update(float dt);
+        // Updates the animator immediately, even if it belongs to a pool.
+        void UpdateNow(float dt) {
+            stats.updates++;
+            if (lod.frozen) {
+                stats.frozen++;
+                return;
+            }
+            if (!Throttle(lod, lodElapsed, dt)) {
+                stats.throttled++;
+                return;
+            }
+            attributes.Update(dt, values, lod, stats);
+        }
+        // Sets the level of detail of an attribute, returns false if the attribute isn't animated yet.
+        bool SetLOD(id::IdentifierMaybe attribute, const LevelOfDetail& attributeLOD) {
+            auto attr = attributes.GetAttribute(attribute);
+            if (attr == nullptr) {
+                return false;
+            }
+            attr->lod = attributeLOD;
+            return true;
         }
         void Play(const AnimateRequest& request) {
             auto requests = std::vector<AnimateRequest>();
@@ -578,23 +864,30 @@ namespace anim {
             attributes.StopIn(animation, dt);
         }
         // Stop/Pause/Resume can be done via animation(s) or attribute(s).
+        // The value is kept on the heap so values returned by Get share its data and see future updates.
         void Set(const attribute_id& attribute, types::Value value) {
-            values[attribute] = value;
+            values.Set(attribute, value.Shared());
         }
         void Init(const attribute_id& attribute, types::Type* type) {
             Set(attribute, type->Create());
         }
-        types::Value Get(const attribute_id& attribute) {
-            auto iter = values.find(attribute);
-            return iter == values.end() ? types::Value::Invalid() : iter->second;
+        // Returns the attribute's current value which shares its data and reflects future updates.
+        types::Value Get(id::IdentifierMaybe attribute) {
+            auto value = values.Ptr(attribute);
+            return value == nullptr ? types::Value::Invalid() : *value;
         }
 
         friend std::ostream& operator<<(std::ostream& os, const Animator& a) {
-            for (auto& attrValue : a.values) {
-                auto point = attrValue.second;
-                os << attrValue.first << "{" << point.ToString() << "}";
+            auto& keys = a.values.Keys();
+            auto& values = a.values.Values();
+            for (size_t i = 0; i < values.size(); i++) {
+                if (a.values.IsRemoved(i)) {
+                    continue;
+                }
+                auto point = values[i];
+                os << keys[i] << "{" << point.ToString() << "}";
 
-                auto attr = a.attributes.GetAttribute(attrValue.first);
+                auto attr = a.attributes.GetAttribute(keys[i]);
                 if (attr != nullptr) {
                     os << " = " << *attr;
                 }
@@ -603,6 +896,162 @@ namespace anim {
         }
     };
 
+    // Owns many animators and updates them together, across a WorkPool if given. Animators with the same 
+    // attributes, types, and animation data are grouped next to each other so threads work through similar data.
+    // An animator is only ever updated by one thread at a time, so results are the same as updating one after another.
+    // Updating a pooled animator (as Apply does for state machines) is deferred until Flush.
+    class AnimatorPool {
+    public:
+        AnimatorPool(WorkPool* work = nullptr, size_t grain = 16): m_work(work), m_grain(grain) {}
+        AnimatorPool(const AnimatorPool&) = delete;
+        AnimatorPool& operator=(const AnimatorPool&) = delete;
+
+        // Adds an animator to the pool. The reference is valid for the life of the pool.
+        Animator& Add() {
+            auto& animator = m_animators.emplace_back();
+            animator.pool = this;
+            animator.poolIndex = m_animators.size() - 1;
+            m_grouped = false;
+            return animator;
+        }
+        size_t Size() const noexcept { return m_animators.size(); }
+        Animator& operator[](size_t index) { return m_animators[index]; }
+        // The stats of every animator in the pool added together.
+        UpdateStats Stats() const noexcept {
+            auto total = UpdateStats{};
+            for (auto& animator : m_animators) {
+                total += animator.stats;
+            }
+            return total;
+        }
+
+        // Groups animators by what they're animating. Call after animators play new animations, Update and Flush
+        // only do this when animators have been added.
+        void Group() {
+            auto count = m_animators.size();
+            auto signatures = std::vector<size_t>(count);
+            for (size_t i = 0; i < count; i++) {
+                signatures[i] = signatureOf(m_animators[i]);
+            }
+            m_order.resize(count);
+            for (size_t i = 0; i < count; i++) {
+                m_order[i] = i;
+            }
+            std::stable_sort(m_order.begin(), m_order.end(), [&](size_t a, size_t b) { return signatures[a] < signatures[b]; });
+            m_rank.resize(count);
+            for (size_t i = 0; i < count; i++) {
+                m_rank[m_order[i]] = i;
+            }
+            m_grouped = true;
+        }
+        // Updates every animator in the pool now.
+        void Update(float dt) {
+            if (!m_grouped) {
+                Group();
+            }
+            forEach(m_order.size(), [this, dt](size_t i) {
+                m_animators[m_order[i]].UpdateNow(dt);
+            });
+        }
+        // Queues an update of the animator for the next Flush. This is what Animator::Update does for pooled animators.
+        // This can be called from multiple threads, like when pooled animators are the subjects of a MachineBatch.
+        void Defer(Animator& animator, float dt) {
+            auto lock = std::unique_lock(m_deferring);
+            m_deferred.push_back(Deferred{&animator, dt, 0});
+        }
+        // Runs the deferred updates in the order they were deferred for each animator, and clears them.
+        void Flush() {
+            if (m_deferred.empty()) {
+                return;
+            }
+            if (!m_grouped) {
+                Group();
+            }
+            for (auto& deferred : m_deferred) {
+                auto index = deferred.animator->poolIndex;
+                auto owned = index < m_animators.size() && &m_animators[index] == deferred.animator;
+                deferred.rank = owned ? m_rank[index] : m_animators.size();
+            }
+            std::stable_sort(m_deferred.begin(), m_deferred.end(), [](const Deferred& a, const Deferred& b) {
+                return a.rank != b.rank ? a.rank < b.rank : std::less<Animator*>()(a.animator, b.animator);
+            });
+            // Each run is every deferred update of one animator.
+            m_runs.clear();
+            for (size_t i = 0; i < m_deferred.size(); i++) {
+                if (i == 0 || m_deferred[i].animator != m_deferred[i - 1].animator) {
+                    m_runs.push_back(i);
+                }
+            }
+            m_runs.push_back(m_deferred.size());
+            forEach(m_runs.size() - 1, [this](size_t run) {
+                for (auto i = m_runs[run]; i < m_runs[run + 1]; i++) {
+                    m_deferred[i].animator->UpdateNow(m_deferred[i].dt);
+                }
+            });
+            m_deferred.clear();
+        }
+
+    private:
+        struct Deferred {
+            Animator* animator;
+            float dt;
+            size_t rank;
+        };
+
+        WorkPool* m_work;
+        size_t m_grain;
+        std::deque<Animator> m_animators;
+        std::vector<size_t> m_order;
+        std::vector<size_t> m_rank;
+        std::vector<Deferred> m_deferred;
+        std::vector<size_t> m_runs;
+        std::mutex m_deferring;
+        bool m_grouped = true;
+
+        template<typename Fn>
+        void forEach(size_t count, Fn&& fn) {
+            if (m_work == nullptr) {
+                for (size_t i = 0; i < count; i++) {
+                    fn(i);
+                }
+                return;
+            }
+            m_work->For(count, m_grain, [&fn](size_t start, size_t end) {
+                for (auto i = start; i < end; i++) {
+                    fn(i);
+                }
+            });
+        }
+        // A hash of the attributes of the animator, their value types, and the animation data they're animated with.
+        static size_t signatureOf(const Animator& animator) {
+            size_t hash = 14695981039346656037ull;
+            auto combine = [&hash](size_t value) {
+                hash = (hash ^ value) * 1099511628211ull;
+            };
+            auto& keys = animator.values.Keys();
+            auto& values = animator.values.Values();
+            for (size_t i = 0; i < values.size(); i++) {
+                combine(keys[i].uid);
+                combine(reinterpret_cast<size_t>(values[i].GetType()));
+                auto attr = animator.attributes.GetAttribute(keys[i]);
+                if (attr != nullptr) {
+                    for (auto& attrAnimator : attr->animators) {
+                        combine(reinterpret_cast<size_t>(attrAnimator.attribute));
+                    }
+                }
+            }
+            return hash;
+        }
+    };
+
+    void Animator::Update(float dt) {
+        if (pool != nullptr) {
+            pool->Defer(*this, dt);
+        } else {
+            UpdateNow(dt);
+        }
+    }
+
     // Animation state machine types
     struct Update {
         static const inline state::UserStateProperty<float> DeltaTime = 0;
@@ -618,6 +1067,7 @@ namespace anim {
     using MachineDefinition = state::MachineDefinition<StateTypes>;
     using MachineOptions = state::MachineOptions<StateTypes>;
     using Transition = state::Transition<StateTypes>;
+    using MachineBatch = state::MachineBatch<StateTypes>;
     
     // Start the given state, and outro the given state (if given).
     // The state could be a single animation or a sub machine with any number of states and sub machines.
@@ -693,7 +1143,7 @@ namespace anim {
             });
         }
         
-        LOG(info, "Apply given "<<active.size()<<" active with "<<subject.attributes.set.size()<<" attributes and dt "<<update.Get(Update::DeltaTime)<<" with total effective scale "<<totalEffectiveScale)
+        LOG(info, "Apply given "<<active.size()<<" active with "<<subject.attributes.set.Size()<<" attributes and dt "<<update.Get(Update::DeltaTime)<<" with total effective scale "<<totalEffectiveScale)
         // Update subject.
         subject.Update(update.Get(Update::DeltaTime));
 
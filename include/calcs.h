@@ -3,6 +3,17 @@
 #include <cmath>
 #include <vector>
 #include <limits>
+#include <cstring>
+#include <cstdint>
+#include <bit>
+
+#if !defined(CALC_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64))
+#include <immintrin.h>
+#define CALC_SIMD_SSE 1
+#elif !defined(CALC_NO_SIMD) && defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define CALC_SIMD_NEON 1
+#endif
 
 #include "debug.h"
 #include "types.h"
@@ -71,6 +82,193 @@ namespace calc {
         return height;
     }
 
+    // A minimal 4 float vector abstraction used by the packed functions. Uses SSE or NEON when available
+    // (and CALC_NO_SIMD is not defined) and plain arrays otherwise.
+    namespace simd {
+#if defined(CALC_SIMD_SSE)
+        using float4 = __m128;
+        using mask4 = __m128;
+
+        inline float4 Load(const float* p) noexcept { return _mm_loadu_ps(p); }
+        inline float4 Set(float a, float b, float c, float d) noexcept { return _mm_setr_ps(a, b, c, d); }
+        inline void Store(float* p, float4 v) noexcept { _mm_storeu_ps(p, v); }
+        inline float4 Splat(float s) noexcept { return _mm_set1_ps(s); }
+        inline float4 Add(float4 a, float4 b) noexcept { return _mm_add_ps(a, b); }
+        inline float4 Sub(float4 a, float4 b) noexcept { return _mm_sub_ps(a, b); }
+        inline float4 Mul(float4 a, float4 b) noexcept { return _mm_mul_ps(a, b); }
+        inline float4 Div(float4 a, float4 b) noexcept { return _mm_div_ps(a, b); }
+        inline float4 Sqrt(float4 a) noexcept { return _mm_sqrt_ps(a); }
+        inline mask4 NotEqual(float4 a, float4 b) noexcept { return _mm_cmpneq_ps(a, b); }
+        inline mask4 And(mask4 a, mask4 b) noexcept { return _mm_and_ps(a, b); }
+        inline float4 Select(mask4 m, float4 a, float4 b) noexcept { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+        inline mask4 Greater(float4 a, float4 b) noexcept { return _mm_cmpgt_ps(a, b); }
+        inline mask4 LessEqual(float4 a, float4 b) noexcept { return _mm_cmple_ps(a, b); }
+        inline uint32_t Bits(mask4 m) noexcept { return uint32_t(_mm_movemask_ps(m)); }
+        inline mask4 Less(float4 a, float4 b) noexcept { return _mm_cmplt_ps(a, b); }
+        inline mask4 GreaterEqual(float4 a, float4 b) noexcept { return _mm_cmpge_ps(a, b); }
+        inline float4 Abs(float4 a) noexcept { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+        inline float Sum(float4 v) noexcept {
+            auto high = _mm_movehl_ps(v, v);
+            auto pairs = _mm_add_ps(v, high);
+            return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, 1)));
+        }
+#elif defined(CALC_SIMD_NEON)
+        using float4 = float32x4_t;
+        using mask4 = uint32x4_t;
+
+        inline float4 Load(const float* p) noexcept { return vld1q_f32(p); }
+        inline float4 Set(float a, float b, float c, float d) noexcept { const float p[4] = {a, b, c, d}; return vld1q_f32(p); }
+        inline void Store(float* p, float4 v) noexcept { vst1q_f32(p, v); }
+        inline float4 Splat(float s) noexcept { return vdupq_n_f32(s); }
+        inline float4 Add(float4 a, float4 b) noexcept { return vaddq_f32(a, b); }
+        inline float4 Sub(float4 a, float4 b) noexcept { return vsubq_f32(a, b); }
+        inline float4 Mul(float4 a, float4 b) noexcept { return vmulq_f32(a, b); }
+        inline float4 Div(float4 a, float4 b) noexcept { return vdivq_f32(a, b); }
+        inline float4 Sqrt(float4 a) noexcept { return vsqrtq_f32(a); }
+        inline mask4 NotEqual(float4 a, float4 b) noexcept { return vmvnq_u32(vceqq_f32(a, b)); }
+        inline mask4 And(mask4 a, mask4 b) noexcept { return vandq_u32(a, b); }
+        inline float4 Select(mask4 m, float4 a, float4 b) noexcept { return vbslq_f32(m, a, b); }
+        inline mask4 Greater(float4 a, float4 b) noexcept { return vcgtq_f32(a, b); }
+        inline mask4 LessEqual(float4 a, float4 b) noexcept { return vcleq_f32(a, b); }
+        inline uint32_t Bits(mask4 m) noexcept {
+            const uint32_t weights[4] = {1, 2, 4, 8};
+            return vaddvq_u32(vandq_u32(m, vld1q_u32(weights)));
+        }
+        inline mask4 Less(float4 a, float4 b) noexcept { return vcltq_f32(a, b); }
+        inline mask4 GreaterEqual(float4 a, float4 b) noexcept { return vcgeq_f32(a, b); }
+        inline float4 Abs(float4 a) noexcept { return vabsq_f32(a); }
+        inline float Sum(float4 v) noexcept { return vaddvq_f32(v); }
+#else
+        struct float4 { float v[4]; };
+        struct mask4 { bool v[4]; };
+
+        inline float4 Load(const float* p) noexcept { return float4{{p[0], p[1], p[2], p[3]}}; }
+        inline float4 Set(float a, float b, float c, float d) noexcept { return float4{{a, b, c, d}}; }
+        inline void Store(float* p, float4 v) noexcept { memcpy(p, v.v, sizeof(v.v)); }
+        inline float4 Splat(float s) noexcept { return float4{{s, s, s, s}}; }
+        inline float4 Add(float4 a, float4 b) noexcept { return float4{{a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3]}}; }
+        inline float4 Sub(float4 a, float4 b) noexcept { return float4{{a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3]}}; }
+        inline float4 Mul(float4 a, float4 b) noexcept { return float4{{a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3]}}; }
+        inline float4 Div(float4 a, float4 b) noexcept { return float4{{a.v[0] / b.v[0], a.v[1] / b.v[1], a.v[2] / b.v[2], a.v[3] / b.v[3]}}; }
+        inline float4 Sqrt(float4 a) noexcept { return float4{{sqrtf(a.v[0]), sqrtf(a.v[1]), sqrtf(a.v[2]), sqrtf(a.v[3])}}; }
+        inline mask4 NotEqual(float4 a, float4 b) noexcept { return mask4{{a.v[0] != b.v[0], a.v[1] != b.v[1], a.v[2] != b.v[2], a.v[3] != b.v[3]}}; }
+        inline mask4 And(mask4 a, mask4 b) noexcept { return mask4{{a.v[0] && b.v[0], a.v[1] && b.v[1], a.v[2] && b.v[2], a.v[3] && b.v[3]}}; }
+        inline float4 Select(mask4 m, float4 a, float4 b) noexcept { return float4{{m.v[0] ? a.v[0] : b.v[0], m.v[1] ? a.v[1] : b.v[1], m.v[2] ? a.v[2] : b.v[2], m.v[3] ? a.v[3] : b.v[3]}}; }
+        inline mask4 Greater(float4 a, float4 b) noexcept { return mask4{{a.v[0] > b.v[0], a.v[1] > b.v[1], a.v[2] > b.v[2], a.v[3] > b.v[3]}}; }
+        inline mask4 LessEqual(float4 a, float4 b) noexcept { return mask4{{a.v[0] <= b.v[0], a.v[1] <= b.v[1], a.v[2] <= b.v[2], a.v[3] <= b.v[3]}}; }
+        inline uint32_t Bits(mask4 m) noexcept { return uint32_t(m.v[0]) | uint32_t(m.v[1]) << 1 | uint32_t(m.v[2]) << 2 | uint32_t(m.v[3]) << 3; }
+        inline mask4 Less(float4 a, float4 b) noexcept { return mask4{{a.v[0] < b.v[0], a.v[1] < b.v[1], a.v[2] < b.v[2], a.v[3] < b.v[3]}}; }
+        inline mask4 GreaterEqual(float4 a, float4 b) noexcept { return mask4{{a.v[0] >= b.v[0], a.v[1] >= b.v[1], a.v[2] >= b.v[2], a.v[3] >= b.v[3]}}; }
+        inline float4 Abs(float4 a) noexcept { return float4{{fabsf(a.v[0]), fabsf(a.v[1]), fabsf(a.v[2]), fabsf(a.v[3])}}; }
+        inline float Sum(float4 v) noexcept { return (v.v[0] + v.v[1]) + (v.v[2] + v.v[3]); }
+#endif
+
+        // a + b * s
+        inline float4 Adds(float4 a, float4 b, float4 s) noexcept { return Add(a, Mul(b, s)); }
+        // a / b where any division by zero is zero.
+        inline float4 DivSafe(float4 a, float4 b) noexcept { return Select(NotEqual(b, Splat(0)), Div(a, b), Splat(0)); }
+        // a < b ? a : b
+        inline float4 Min(float4 a, float4 b) noexcept { return Select(Less(a, b), a, b); }
+        // a > b ? a : b
+        inline float4 Max(float4 a, float4 b) noexcept { return Select(Greater(a, b), a, b); }
+
+        // Loads N (1 to 4) floats, the remaining lanes are zero.
+        template<int N>
+        inline float4 LoadN(const float* p) noexcept {
+            if constexpr (N == 4) {
+                return Load(p);
+            } else {
+                float lanes[4] = {0, 0, 0, 0};
+                memcpy(lanes, p, sizeof(float) * N);
+                return Load(lanes);
+            }
+        }
+        // Stores the first N (1 to 4) lanes.
+        template<int N>
+        inline void StoreN(float* p, float4 v) noexcept {
+            if constexpr (N == 4) {
+                Store(p, v);
+            } else {
+                float lanes[4];
+                Store(lanes, v);
+                memcpy(p, lanes, sizeof(float) * N);
+            }
+        }
+    }
+
+    // Computes QuadraticFormula for four sets of a, b, and c at once without branching.
+    inline simd::float4 QuadraticFormula(simd::float4 a, simd::float4 b, simd::float4 c, simd::float4 none) {
+        auto unset = simd::Splat(std::numeric_limits<float>::min());
+        auto zero = simd::Splat(0);
+        auto epsilon = simd::Splat(EPSILON);
+        auto aZero = simd::Less(simd::Abs(a), epsilon);
+        auto bZero = simd::Less(simd::Abs(b), epsilon);
+        auto cZero = simd::Less(simd::Abs(c), epsilon);
+
+        auto linear = simd::Div(simd::Sub(zero, c), b);
+        auto flat = simd::Select(bZero, simd::Select(cZero, zero, unset), linear);
+
+        auto disc = simd::Sub(simd::Mul(b, b), simd::Mul(simd::Mul(simd::Splat(4.0f), a), c));
+        auto real = simd::GreaterEqual(disc, zero);
+        auto root = simd::Sqrt(simd::Max(disc, zero));
+        auto a2 = simd::Mul(simd::Splat(2.0f), a);
+        auto negB = simd::Sub(zero, b);
+        auto q0 = simd::Select(real, simd::Div(simd::Sub(negB, root), a2), unset);
+        auto q1 = simd::Select(real, simd::Div(simd::Add(negB, root), a2), unset);
+
+        auto t0 = simd::Select(aZero, flat, q0);
+        auto t1 = simd::Select(aZero, flat, q1);
+        auto low = simd::Min(t0, t1);
+        auto t = simd::Select(simd::Less(low, zero), simd::Max(t0, t1), low);
+        auto valid = simd::And(simd::NotEqual(t0, unset), simd::Greater(t, zero));
+
+        return simd::Select(valid, t, none);
+    }
+    // Computes out[i] = QuadraticFormula(a[i], b[i], c[i], none) four at a time.
+    inline void QuadraticFormulaN(const float* a, const float* b, const float* c, float none, float* out, size_t n) {
+        auto none4 = simd::Splat(none);
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            simd::Store(out + i, QuadraticFormula(simd::Load(a + i), simd::Load(b + i), simd::Load(c + i), none4));
+        }
+        for (; i < n; i++) {
+            out[i] = QuadraticFormula(a[i], b[i], c[i], none);
+        }
+    }
+
+    // Specialize this for types made of Size (2 to 4) contiguous floats with no padding, like vectors and 
+    // quaternions, and the functions below will use SIMD on them without any other specializations.
+    // A specialization of a function for the type still takes precedence.
+    // 
+    // template<> struct calc::Packed<Vec3> { static constexpr int Size = 3; };
+    template<typename T>
+    struct Packed {
+        static constexpr int Size = 0;
+    };
+
+    // Whether T has been declared as packed floats.
+    template<typename T>
+    constexpr bool IsPacked = Packed<T>::Size >= 2 && Packed<T>::Size <= 4;
+
+    // Loads and stores packed types.
+    namespace packed {
+        template<typename T>
+        inline simd::float4 Load(const T& a) noexcept {
+            static_assert(sizeof(T) == sizeof(float) * Packed<T>::Size, "a packed type must be exactly Size floats");
+            return simd::LoadN<Packed<T>::Size>(reinterpret_cast<const float*>(&a));
+        }
+        template<typename T>
+        inline T Store(simd::float4 v) noexcept {
+            T out;
+            simd::StoreN<Packed<T>::Size>(reinterpret_cast<float*>(&out), v);
+            return out;
+        }
+        template<typename T>
+        inline const float* Floats(const T& a) noexcept { return reinterpret_cast<const float*>(&a); }
+        template<typename T>
+        inline float* Floats(T& a) noexcept { return reinterpret_cast<float*>(&a); }
+    }
+
     //============================================================================
     // Functions you can specialize per type.
     //============================================================================
@@ -79,24 +277,40 @@ namespace calc {
     // A specialization needs to be specified if + and * operators are not implemented on the type.
     template<typename T>
     constexpr T Adds(const T& a, const T& b, float scale) {
-        return a + b * scale;
+        if constexpr (IsPacked<T>) {
+            return packed::Store<T>(simd::Adds(packed::Load(a), packed::Load(b), simd::Splat(scale)));
+        } else {
+            return a + b * scale;
+        }
     }
     // Returns a * b
     // A specialization needs to be specified if the * operator are not implemented on the type.
     template<typename T>
     constexpr T Mul(const T& a, const T& b) {
-        return a * b;
+        if constexpr (IsPacked<T>) {
+            return packed::Store<T>(simd::Mul(packed::Load(a), packed::Load(b)));
+        } else {
+            return a * b;
+        }
     }
     // Returns a / b
     // A specialization should be specified if the / operator are not implemented on the type.
     template<typename T>
     constexpr T Div(const T& a, const T& b) {
-        return b == 0 ? 0 : a / b;
+        if constexpr (IsPacked<T>) {
+            return packed::Store<T>(simd::DivSafe(packed::Load(a), packed::Load(b)));
+        } else {
+            return b == 0 ? 0 : a / b;
+        }
     }
     // Returns a[n]*b[n] + ...
     template<typename T>
     constexpr float Dot(const T&a, const T& b) {
-        return a * b;
+        if constexpr (IsPacked<T>) {
+            return simd::Sum(simd::Mul(packed::Load(a), packed::Load(b)));
+        } else {
+            return a * b;
+        }
     }
     // Returns a + b
     template<typename T>
@@ -111,12 +325,21 @@ namespace calc {
     // Returns a * scale
     template<typename T>
     constexpr T Scale(const T& a, float scale) {
-        return Adds<T>(a, a, scale - 1.0f);
+        if constexpr (IsPacked<T>) {
+            return packed::Store<T>(simd::Mul(packed::Load(a), simd::Splat(scale)));
+        } else {
+            return Adds<T>(a, a, scale - 1.0f);
+        }
     }
     // Returns a + (b - a) * d
     template<typename T>
     constexpr T Lerp(const T& a, const T& b, float d) {
-        return Adds<T>(a, Adds<T>(b, a, -1.0f), d);
+        if constexpr (IsPacked<T>) {
+            auto va = packed::Load(a);
+            return packed::Store<T>(simd::Adds(va, simd::Sub(packed::Load(b), va), simd::Splat(d)));
+        } else {
+            return Adds<T>(a, Adds<T>(b, a, -1.0f), d);
+        }
     }
     // Returns the squared length of a
     template<typename T>
@@ -142,25 +365,50 @@ namespace calc {
     // Returns a < b
     template<typename T>
     constexpr bool IsLess(const T& a, const T& b) {
-        return a < b;
+        if constexpr (IsPacked<T>) {
+            auto fa = packed::Floats(a);
+            auto fb = packed::Floats(b);
+            for (int i = 0; i < Packed<T>::Size; i++) {
+                if (fa[i] != fb[i]) {
+                    return fa[i] < fb[i];
+                }
+            }
+            return false;
+        } else {
+            return a < b;
+        }
     }
     // Returns the number of components for the given type.
     // A specialization needs to be specified if the type is a non-scalar type.
     template<typename T>
     constexpr int Components() {
-        return 1;
+        if constexpr (IsPacked<T>) {
+            return Packed<T>::Size;
+        } else {
+            return 1;
+        }
     }
     // Returns the value for a component at a given component index.
     // A specialization needs to be specified if the type is a non-scalar type.
     template<typename T>
     constexpr float Get(const T& a, int index) {
-        return static_cast<float>(a);
+        if constexpr (IsPacked<T>) {
+            return index >= 0 && index < Packed<T>::Size ? packed::Floats(a)[index] : 0.0f;
+        } else {
+            return static_cast<float>(a);
+        }
     }
     // Sets the value for a component at a given component index.
     // A specialization needs to be specified if the type is a non-scalar type.
     template<typename T>
     constexpr void Set(T& out, int index, float value) {
-        out = static_cast<T>(value);
+        if constexpr (IsPacked<T>) {
+            if (index >= 0 && index < Packed<T>::Size) {
+                packed::Floats(out)[index] = value;
+            }
+        } else {
+            out = static_cast<T>(value);
+        }
     }
     // Sets all components in out to the given value.
     template<typename T>
@@ -323,6 +571,210 @@ namespace calc {
 
         return IsCircleInView<T>(viewOrigin, viewDirection, fovTan, fovCos, circle, circleRadius, fovType == FieldOfView::full);
     }
+    //============================================================================
+    // Batch view culling. Results are bitmasks where bit i%64 of word i/64 is set when value i is in view,
+    // MaskWords(n) words are written. Each function returns how many values are in view.
+    //============================================================================
+
+    // The number of 64-bit words needed for a mask of n values.
+    constexpr size_t MaskWords(size_t n) {
+        return (n + 63) / 64;
+    }
+    // Writes the indices of the set bits in mask (for n values) into indices and returns how many were written.
+    inline size_t MaskToIndices(const uint64_t* mask, size_t n, uint32_t* indices) {
+        size_t count = 0;
+        for (size_t w = 0; w < MaskWords(n); w++) {
+            auto bits = mask[w];
+            while (bits != 0) {
+                indices[count++] = uint32_t(w * 64 + std::countr_zero(bits));
+                bits &= bits - 1;
+            }
+        }
+        return count;
+    }
+    // Builds the mask by calling inView(i) for every value, a word at a time.
+    template<typename InView>
+    inline size_t buildMask(size_t n, uint64_t* mask, InView&& inView) {
+        size_t count = 0;
+        for (size_t w = 0; w < MaskWords(n); w++) {
+            auto start = w * 64;
+            auto end = std::min(n, start + 64);
+            uint64_t bits = 0;
+            for (auto i = start; i < end; i++) {
+                bits |= uint64_t(inView(i)) << (i - start);
+            }
+            mask[w] = bits;
+            count += std::popcount(bits);
+        }
+        return count;
+    }
+    // Marks which of the points are in the view like IsPointInView.
+    template<typename T>
+    size_t PointsInView(const T& viewOrigin, const T& viewDirection, float fovCos, const T* points, size_t n, uint64_t* mask) {
+        return buildMask(n, mask, [&](size_t i) {
+            return IsPointInView<T>(viewOrigin, viewDirection, fovCos, points[i]);
+        });
+    }
+    // Writes the indices of the points in view like IsPointInView and returns how many there are.
+    template<typename T>
+    size_t PointsInViewIndices(const T& viewOrigin, const T& viewDirection, float fovCos, const T* points, size_t n, uint32_t* indices) {
+        size_t count = 0;
+        for (size_t i = 0; i < n; i++) {
+            indices[count] = uint32_t(i);
+            count += IsPointInView<T>(viewOrigin, viewDirection, fovCos, points[i]);
+        }
+        return count;
+    }
+    // Marks which of the circles (with radii[i]) are in the view like IsCircleInView.
+    template<typename T>
+    size_t CirclesInView(const T& viewOrigin, const T& viewDirection, float fovTan, float fovCos, const T* circles, const float* radii, size_t n, bool entirely, uint64_t* mask) {
+        return buildMask(n, mask, [&](size_t i) {
+            return IsCircleInView<T>(viewOrigin, viewDirection, fovTan, fovCos, circles[i], radii[i], entirely);
+        });
+    }
+    // Marks which of the circles (with radii[i]) are in the view like IsCircleInViewType.
+    template<typename T>
+    size_t CirclesInViewType(const T& viewOrigin, const T& viewDirection, float fovTan, float fovCos, const T* circles, const float* radii, size_t n, FieldOfView fovType, uint64_t* mask) {
+        if (fovType == FieldOfView::ignore) {
+            return buildMask(n, mask, [](size_t) { return true; });
+        }
+        if (fovType == FieldOfView::half) {
+            return buildMask(n, mask, [&](size_t i) {
+                return IsCircleInView<T>(viewOrigin, viewDirection, fovTan, fovCos, circles[i], 0, false);
+            });
+        }
+        return CirclesInView<T>(viewOrigin, viewDirection, fovTan, fovCos, circles, radii, n, true, mask);
+    }
+
+    // Marks which of the points stored as C component arrays (points[c][i]) are in the view, four at a time.
+    // The view origin and direction are C floats.
+    template<int C>
+    size_t PointsInViewN(const float* viewOrigin, const float* viewDirection, float fovCos, const float* const* points, size_t n, uint64_t* mask) {
+        simd::float4 origin[C], direction[C];
+        for (int c = 0; c < C; c++) {
+            origin[c] = simd::Splat(viewOrigin[c]);
+            direction[c] = simd::Splat(viewDirection[c]);
+        }
+        auto cos4 = simd::Splat(fovCos);
+        size_t count = 0;
+        for (size_t w = 0; w < MaskWords(n); w++) {
+            auto start = w * 64;
+            auto end = std::min(n, start + 64);
+            uint64_t bits = 0;
+            auto i = start;
+            for (; i + 4 <= end; i += 4) {
+                auto dot = simd::Mul(simd::Sub(simd::Load(points[0] + i), origin[0]), direction[0]);
+                for (int c = 1; c < C; c++) {
+                    dot = simd::Add(dot, simd::Mul(simd::Sub(simd::Load(points[c] + i), origin[c]), direction[c]));
+                }
+                bits |= uint64_t(simd::Bits(simd::Greater(dot, cos4))) << (i - start);
+            }
+            for (; i < end; i++) {
+                auto dot = (points[0][i] - viewOrigin[0]) * viewDirection[0];
+                for (int c = 1; c < C; c++) {
+                    dot += (points[c][i] - viewOrigin[c]) * viewDirection[c];
+                }
+                bits |= uint64_t(dot > fovCos) << (i - start);
+            }
+            mask[w] = bits;
+            count += std::popcount(bits);
+        }
+        return count;
+    }
+    // Marks which of the circles stored as C component arrays (circles[c][i]) with radii[i] are in the view 
+    // like IsCircleInView, four at a time. The view origin and direction are C floats.
+    template<int C>
+    size_t CirclesInViewN(const float* viewOrigin, const float* viewDirection, float fovTan, float fovCos, const float* const* circles, const float* radii, size_t n, bool entirely, uint64_t* mask) {
+        simd::float4 origin[C], direction[C];
+        for (int c = 0; c < C; c++) {
+            origin[c] = simd::Splat(viewOrigin[c]);
+            direction[c] = simd::Splat(viewDirection[c]);
+        }
+        auto tan4 = simd::Splat(fovTan);
+        auto cos4 = simd::Splat(fovCos);
+        auto zero = simd::Splat(0);
+        auto sign = entirely ? 1.0f : -1.0f;
+        auto radiusSign = simd::Splat(sign);
+        size_t count = 0;
+        for (size_t w = 0; w < MaskWords(n); w++) {
+            auto start = w * 64;
+            auto end = std::min(n, start + 64);
+            uint64_t bits = 0;
+            auto i = start;
+            for (; i + 4 <= end; i += 4) {
+                auto toOrigin = simd::Sub(simd::Load(circles[0] + i), origin[0]);
+                auto along = simd::Mul(toOrigin, direction[0]);
+                auto lengthSq = simd::Mul(toOrigin, toOrigin);
+                for (int c = 1; c < C; c++) {
+                    toOrigin = simd::Sub(simd::Load(circles[c] + i), origin[c]);
+                    along = simd::Add(along, simd::Mul(toOrigin, direction[c]));
+                    lengthSq = simd::Add(lengthSq, simd::Mul(toOrigin, toOrigin));
+                }
+                auto coneRadius = simd::Mul(along, tan4);
+                auto fromAxis = simd::Sqrt(simd::Sub(lengthSq, simd::Mul(along, along)));
+                auto shortest = simd::Mul(simd::Sub(fromAxis, coneRadius), cos4);
+                shortest = simd::Adds(shortest, simd::Load(radii + i), radiusSign);
+                bits |= uint64_t(simd::Bits(simd::LessEqual(shortest, zero))) << (i - start);
+            }
+            for (; i < end; i++) {
+                auto toOrigin = circles[0][i] - viewOrigin[0];
+                auto along = toOrigin * viewDirection[0];
+                auto lengthSq = toOrigin * toOrigin;
+                for (int c = 1; c < C; c++) {
+                    toOrigin = circles[c][i] - viewOrigin[c];
+                    along += toOrigin * viewDirection[c];
+                    lengthSq += toOrigin * toOrigin;
+                }
+                auto shortest = (sqrtf(lengthSq - along * along) - along * fovTan) * fovCos + radii[i] * sign;
+                bits |= uint64_t(shortest <= 0) << (i - start);
+            }
+            mask[w] = bits;
+            count += std::popcount(bits);
+        }
+        return count;
+    }
+
+    // A view for querying many views at once.
+    template<typename T>
+    struct View {
+        T origin;
+        T direction;
+        float fovTan;
+        float fovCos;
+        FieldOfView fovType = FieldOfView::full;
+    };
+    // Runs fn(view) for every view index, in chunks of grain views across the work pool if given.
+    template<typename Fn>
+    void forEachView(size_t viewCount, WorkPool* work, size_t grain, Fn&& fn) {
+        auto run = [&fn](size_t start, size_t end) {
+            for (auto v = start; v < end; v++) {
+                fn(v);
+            }
+        };
+        if (work != nullptr) {
+            work->For(viewCount, grain, run);
+        } else {
+            run(0, viewCount);
+        }
+    }
+    // Marks which points are in each view like IsPointInView. The mask for view v starts at masks[v * MaskWords(n)].
+    template<typename T>
+    void PointsInViews(const View<T>* views, size_t viewCount, const T* points, size_t n, uint64_t* masks, WorkPool* work = nullptr, size_t grain = 1) {
+        auto words = MaskWords(n);
+        forEachView(viewCount, work, grain, [&](size_t v) {
+            PointsInView<T>(views[v].origin, views[v].direction, views[v].fovCos, points, n, masks + v * words);
+        });
+    }
+    // Marks which circles are in each view like IsCircleInViewType. The mask for view v starts at masks[v * MaskWords(n)].
+    template<typename T>
+    void CirclesInViews(const View<T>* views, size_t viewCount, const T* circles, const float* radii, size_t n, uint64_t* masks, WorkPool* work = nullptr, size_t grain = 1) {
+        auto words = MaskWords(n);
+        forEachView(viewCount, work, grain, [&](size_t v) {
+            auto& view = views[v];
+            CirclesInViewType<T>(view.origin, view.direction, view.fovTan, view.fovCos, circles, radii, n, view.fovType, masks + v * words);
+        });
+    }
+
     // Calculates the value on the cubic curve given a delta between 0 and 1, the 4 control points, the matrix weights, and if its an inverse.
     template<typename T>
     T CubicCurve(float delta, const T& p0, const T& p1, const T& p2, const T& p3, float matrix[4][4], bool inverse) {
@@ -370,6 +822,84 @@ namespace calc {
         auto scaled = Scale<T>(out, weight);
         return scaled;
     }
+    // A ParametricCubicCurve with the matrix and weight multiplied into polynomial coefficients for each segment
+    // ahead of time, so evaluating a point is finding its segment and a Horner evaluation of a cubic.
+    template<typename T>
+    class CompiledCurve {
+    public:
+        CompiledCurve() = default;
+        CompiledCurve(const T* points, size_t count, float matrix[4][4], float weight, bool inverse, bool loop) {
+            Compile(points, count, matrix, weight, inverse, loop);
+        }
+        CompiledCurve(const std::vector<T>& points, float matrix[4][4], float weight, bool inverse, bool loop) {
+            Compile(points.data(), points.size(), matrix, weight, inverse, loop);
+        }
+
+        // Computes the coefficients of each segment of the curve through the given points.
+        void Compile(const T* points, size_t count, float matrix[4][4], float weight, bool inverse, bool loop) {
+            m_coefficients.clear();
+            if (count < 2) {
+                m_coefficients.push_back(count == 1 ? Scale<T>(points[0], weight) : Create<T>());
+                m_segments = 0;
+                return;
+            }
+            auto n = count - 1;
+            m_segments = n;
+            m_coefficients.reserve(n * 4);
+            for (size_t index = 0; index < n; index++) {
+                const T& p0 = index == 0
+                    ? loop ? points[n] : points[0]
+                    : points[index - 1];
+                const T& p1 = points[index];
+                const T& p2 = points[index + 1];
+                const T& p3 = index == n - 1
+                    ? !loop ? points[n] : points[0]
+                    : points[index + 2];
+
+                // CubicCurve weighs row i of the matrix by delta^i, or delta^(3-i) when inversed.
+                T rows[4];
+                for (int i = 0; i < 4; i++) {
+                    auto row = Scale<T>(p0, matrix[i][0]);
+                    row = Adds<T>(row, p1, matrix[i][1]);
+                    row = Adds<T>(row, p2, matrix[i][2]);
+                    row = Adds<T>(row, p3, matrix[i][3]);
+                    rows[i] = Scale<T>(row, weight);
+                }
+                for (int power = 0; power < 4; power++) {
+                    m_coefficients.push_back(rows[inverse ? 3 - power : power]);
+                }
+            }
+        }
+        // Returns the point on the curve at delta (0 to 1), matching ParametricCubicCurve.
+        T Evaluate(float delta) const noexcept {
+            if (m_segments == 0) {
+                return m_coefficients.empty() ? Create<T>() : m_coefficients[0];
+            }
+            auto a = delta * (float)m_segments;
+            auto i = Clamp<float>(floorf(a), 0, (float)(m_segments - 1));
+            auto d = a - i;
+            auto k = &m_coefficients[size_t(i) * 4];
+            auto out = Adds<T>(k[2], k[3], d);
+            out = Adds<T>(k[1], out, d);
+            return Adds<T>(k[0], out, d);
+        }
+        // Computes out[i] = Evaluate(deltas[i]).
+        void EvaluateN(const float* deltas, T* out, size_t n) const noexcept {
+            for (size_t i = 0; i < n; i++) {
+                out[i] = Evaluate(deltas[i]);
+            }
+        }
+        // The number of segments in the curve.
+        constexpr size_t Segments() const noexcept { return m_segments; }
+        // Whether the curve was compiled with any points.
+        constexpr bool Empty() const noexcept { return m_coefficients.empty(); }
+
+    private:
+        // 4 coefficients per segment, from the constant to the cubic term.
+        std::vector<T> m_coefficients;
+        size_t m_segments = 0;
+    };
+
     // Calculates the time an interceptor could intercept a target given the interceptors
     // position and possible speed and the targets current position and velocity. If no
     // intercept exists based on the parameters then -1 is returned. Otherwise a value is
@@ -384,6 +914,121 @@ namespace calc {
 
         return QuadraticFormula(a, b, c, -1);
     }
+    //============================================================================
+    // Structure of arrays functions over C component arrays, where a[c][i] is component c of value i.
+    //============================================================================
+
+    // out[i] = Dot(a[i], b[i])
+    template<int C>
+    void DotN(const float* const* a, const float* const* b, float* out, size_t n) {
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            auto sum = simd::Mul(simd::Load(a[0] + i), simd::Load(b[0] + i));
+            for (int c = 1; c < C; c++) {
+                sum = simd::Add(sum, simd::Mul(simd::Load(a[c] + i), simd::Load(b[c] + i)));
+            }
+            simd::Store(out + i, sum);
+        }
+        for (; i < n; i++) {
+            auto sum = a[0][i] * b[0][i];
+            for (int c = 1; c < C; c++) {
+                sum += a[c][i] * b[c][i];
+            }
+            out[i] = sum;
+        }
+    }
+    // Normalizes every value like Normalize and stores what it returns in lengths if it's not null.
+    template<int C>
+    void NormalizeN(float* const* v, float* lengths, size_t n) {
+        size_t i = 0;
+        auto zero = simd::Splat(0);
+        auto one = simd::Splat(1);
+        for (; i + 4 <= n; i += 4) {
+            auto lengthSq = simd::Mul(simd::Load(v[0] + i), simd::Load(v[0] + i));
+            for (int c = 1; c < C; c++) {
+                lengthSq = simd::Add(lengthSq, simd::Mul(simd::Load(v[c] + i), simd::Load(v[c] + i)));
+            }
+            auto change = simd::And(simd::NotEqual(lengthSq, zero), simd::NotEqual(lengthSq, one));
+            auto length = simd::Select(change, simd::Sqrt(lengthSq), lengthSq);
+            auto scale = simd::Select(change, simd::Div(one, length), one);
+            for (int c = 0; c < C; c++) {
+                simd::Store(v[c] + i, simd::Mul(simd::Load(v[c] + i), scale));
+            }
+            if (lengths != nullptr) {
+                simd::Store(lengths + i, length);
+            }
+        }
+        for (; i < n; i++) {
+            auto d = v[0][i] * v[0][i];
+            for (int c = 1; c < C; c++) {
+                d += v[c][i] * v[c][i];
+            }
+            if (d != 0 && d != 1) {
+                d = sqrtf(d);
+                for (int c = 0; c < C; c++) {
+                    v[c][i] *= 1 / d;
+                }
+            }
+            if (lengths != nullptr) {
+                lengths[i] = d;
+            }
+        }
+    }
+
+    // Computes out[i] = InterceptTime(interceptors[i], interceptorSpeeds[i], targetPositions[i], targetVelocities[i])
+    // solving the quadratics four at a time.
+    template<typename T>
+    void InterceptTimes(const T* interceptors, const float* interceptorSpeeds, const T* targetPositions, const T* targetVelocities, float* out, size_t n) {
+        const size_t block = 64;
+        float as[block], bs[block], cs[block];
+        for (size_t start = 0; start < n; start += block) {
+            auto count = std::min(block, n - start);
+            for (size_t k = 0; k < count; k++) {
+                auto i = start + k;
+                auto tvec = Sub<T>(targetPositions[i], interceptors[i]);
+                as[k] = LengthSq<T>(targetVelocities[i]) - (interceptorSpeeds[i] * interceptorSpeeds[i]);
+                bs[k] = 2 * Dot<T>(targetVelocities[i], tvec);
+                cs[k] = LengthSq<T>(tvec);
+            }
+            QuadraticFormulaN(as, bs, cs, -1, out + start, count);
+        }
+    }
+    // InterceptTimes over C component arrays (interceptors[c][i] etc) four at a time.
+    template<int C>
+    void InterceptTimeN(const float* const* interceptors, const float* interceptorSpeeds, const float* const* targetPositions, const float* const* targetVelocities, float* out, size_t n) {
+        auto none = simd::Splat(-1);
+        auto two = simd::Splat(2);
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            auto velocity = simd::Load(targetVelocities[0] + i);
+            auto tvec = simd::Sub(simd::Load(targetPositions[0] + i), simd::Load(interceptors[0] + i));
+            auto velocitySq = simd::Mul(velocity, velocity);
+            auto dot = simd::Mul(velocity, tvec);
+            auto c = simd::Mul(tvec, tvec);
+            for (int k = 1; k < C; k++) {
+                velocity = simd::Load(targetVelocities[k] + i);
+                tvec = simd::Sub(simd::Load(targetPositions[k] + i), simd::Load(interceptors[k] + i));
+                velocitySq = simd::Add(velocitySq, simd::Mul(velocity, velocity));
+                dot = simd::Add(dot, simd::Mul(velocity, tvec));
+                c = simd::Add(c, simd::Mul(tvec, tvec));
+            }
+            auto speed = simd::Load(interceptorSpeeds + i);
+            auto a = simd::Sub(velocitySq, simd::Mul(speed, speed));
+            auto b = simd::Mul(two, dot);
+            simd::Store(out + i, QuadraticFormula(a, b, c, none));
+        }
+        for (; i < n; i++) {
+            float velocitySq = 0, dot = 0, c = 0;
+            for (int k = 0; k < C; k++) {
+                auto tvec = targetPositions[k][i] - interceptors[k][i];
+                velocitySq += targetVelocities[k][i] * targetVelocities[k][i];
+                dot += targetVelocities[k][i] * tvec;
+                c += tvec * tvec;
+            }
+            out[i] = QuadraticFormula(velocitySq - interceptorSpeeds[i] * interceptorSpeeds[i], 2 * dot, c, -1);
+        }
+    }
+
     // Reflects the direction across a given normal. Imagine the normal is on a plane
     // pointing away from it and a reflection is a ball with the given direction bouncing off of it.
     template<typename T>
@@ -399,6 +1044,20 @@ namespace calc {
         return Sub<T>(Scale<T>(normal, scale), dir);
     }
 
+    // A CompiledCurve of values of a type.
+    class ValueCurve {
+    public:
+        virtual ~ValueCurve() = default;
+        // Returns the point on the curve at delta (0 to 1).
+        virtual types::Value Evaluate(float delta) const = 0;
+        // Sets out to the point on the curve at delta without allocating, returns false if out is not compatible.
+        virtual bool Evaluate(float delta, types::Value& out) const = 0;
+        // Writes n points into out, an array of the curve's type.
+        virtual void EvaluateN(const float* deltas, void* out, size_t n) const = 0;
+        // The number of segments in the curve.
+        virtual size_t Segments() const = 0;
+    };
+
     // A calculator for types::Value but calls the functions and specializations above.
     class ValueCalculator {
     public:
@@ -439,6 +1098,54 @@ namespace calc {
         virtual float InterceptTime(const types::Value& interceptor, float interceptorSpeed, const types::Value& targetPosition, const types::Value& targetVelocity) = 0;
         virtual types::Value CubicCurve(float delta, const types::Value& p0, const types::Value& p1, const types::Value& p2, const types::Value& p3, float matrix[4][4], bool inverse) = 0;
         virtual types::Value ParametricCubicCurve(float delta, const std::vector<types::Value>& points, float matrix[4][4], float weight, bool inverse, bool loop) = 0;
+        // Compiles the points into a curve that evaluates like ParametricCubicCurve.
+        virtual std::unique_ptr<ValueCurve> CompileCurve(const std::vector<types::Value>& points, float matrix[4][4], float weight, bool inverse, bool loop) = 0;
+
+        // Batched operations over contiguous arrays of n values of the calculator's type. The out array may be
+        // one of the inputs but may not otherwise overlap them.
+
+        // out[i] = Lerp(a[i], b[i], t[i])
+        virtual void LerpN(const void* a, const void* b, const float* t, void* out, size_t n) = 0;
+        // out[i] = Adds(a[i], b[i], scale[i])
+        virtual void AddsN(const void* a, const void* b, const float* scale, void* out, size_t n) = 0;
+        // out[i] = Scale(a[i], scale[i])
+        virtual void ScaleN(const void* a, const float* scale, void* out, size_t n) = 0;
+        // Normalizes each value in place and stores the previous length in lengths if it's not null.
+        virtual void NormalizeN(void* values, float* lengths, size_t n) = 0;
+        // out[i] = Distance(a[i], b[i])
+        virtual void DistanceN(const void* a, const void* b, float* out, size_t n) = 0;
+        // out[i] = InterceptTime(interceptors[i], interceptorSpeeds[i], targetPositions[i], targetVelocities[i])
+        virtual void InterceptTimeN(const void* interceptors, const float* interceptorSpeeds, const void* targetPositions, const void* targetVelocities, float* out, size_t n) = 0;
+    };
+
+    // A ValueCurve for the given type.
+    template<typename T>
+    class TypedCurve : public ValueCurve {
+    public:
+        TypedCurve(types::Type* type, CompiledCurve<T> curve): m_type(type), m_curve(std::move(curve)) {}
+
+        types::Value Evaluate(float delta) const {
+            return types::ValueOf(m_curve.Evaluate(delta), m_type);
+        }
+        bool Evaluate(float delta, types::Value& out) const {
+            auto p = out.Ptr<T>();
+            if (p == nullptr) {
+                return false;
+            }
+            *p = m_curve.Evaluate(delta);
+            return true;
+        }
+        void EvaluateN(const float* deltas, void* out, size_t n) const {
+            m_curve.EvaluateN(deltas, static_cast<T*>(out), n);
+        }
+        size_t Segments() const {
+            return m_curve.Segments();
+        }
+        // The typed curve.
+        constexpr const CompiledCurve<T>& Curve() const noexcept { return m_curve; }
+    private:
+        types::Type* m_type;
+        CompiledCurve<T> m_curve;
     };
 
     // A ValueCalculator for the given type.
@@ -575,6 +1282,59 @@ namespace calc {
             }
             return types::ValueOf(calc::ParametricCubicCurve(delta, converted, matrix, weight, inverse, loop), m_type);
         }
+        std::unique_ptr<ValueCurve> CompileCurve(const std::vector<types::Value>& points, float matrix[4][4], float weight, bool inverse, bool loop) {
+            auto converted = std::vector<T>();
+            converted.reserve(points.size());
+            for (auto& pt : points) {
+                converted.push_back(pt.Get<T>());
+            }
+            return std::make_unique<TypedCurve<T>>(m_type, CompiledCurve<T>(converted, matrix, weight, inverse, loop));
+        }
+        void LerpN(const void* a, const void* b, const float* t, void* out, size_t n) {
+            auto pa = static_cast<const T*>(a);
+            auto pb = static_cast<const T*>(b);
+            auto po = static_cast<T*>(out);
+            for (size_t i = 0; i < n; i++) {
+                po[i] = calc::Lerp<T>(pa[i], pb[i], t[i]);
+            }
+        }
+        void AddsN(const void* a, const void* b, const float* scale, void* out, size_t n) {
+            auto pa = static_cast<const T*>(a);
+            auto pb = static_cast<const T*>(b);
+            auto po = static_cast<T*>(out);
+            for (size_t i = 0; i < n; i++) {
+                po[i] = calc::Adds<T>(pa[i], pb[i], scale[i]);
+            }
+        }
+        void ScaleN(const void* a, const float* scale, void* out, size_t n) {
+            auto pa = static_cast<const T*>(a);
+            auto po = static_cast<T*>(out);
+            for (size_t i = 0; i < n; i++) {
+                po[i] = calc::Scale<T>(pa[i], scale[i]);
+            }
+        }
+        void NormalizeN(void* values, float* lengths, size_t n) {
+            auto pv = static_cast<T*>(values);
+            if (lengths != nullptr) {
+                for (size_t i = 0; i < n; i++) {
+                    lengths[i] = calc::Normalize<T>(pv[i]);
+                }
+            } else {
+                for (size_t i = 0; i < n; i++) {
+                    calc::Normalize<T>(pv[i]);
+                }
+            }
+        }
+        void DistanceN(const void* a, const void* b, float* out, size_t n) {
+            auto pa = static_cast<const T*>(a);
+            auto pb = static_cast<const T*>(b);
+            for (size_t i = 0; i < n; i++) {
+                out[i] = calc::Distance<T>(pa[i], pb[i]);
+            }
+        }
+        void InterceptTimeN(const void* interceptors, const float* interceptorSpeeds, const void* targetPositions, const void* targetVelocities, float* out, size_t n) {
+            calc::InterceptTimes<T>(static_cast<const T*>(interceptors), interceptorSpeeds, static_cast<const T*>(targetPositions), static_cast<const T*>(targetVelocities), out, n);
+        }
     private:
         types::Type* m_type;
     };
@@ -9,6 +9,13 @@
 #include <vector>
 #include <memory>
 #include <variant>
+#include <string_view>
+#include <cstdint>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <atomic>
 
 #include "debug.h"
 
@@ -41,7 +48,13 @@ const std::string lowercase(std::string x) {
     return x;
 }
 
-// A map & list combo for named values. A list for fast in-order traversal and a map for infrequent return by name.
+// Lowercases a character regardless of the sign of char.
+constexpr char lowercaseChar(char c) noexcept {
+    return (c >= 'A' && c <= 'Z') ? char(c - 'A' + 'a') : c;
+}
+
+// A map & list combo for named values. A list for fast in-order traversal and a hash index for return by name.
+// Keys are case folded once when a value is added so looking up a name never allocates.
 // Not required for the type system, but a useful type to store all types & store all the props for a type.
 template<typename T>
 class NameMap {
@@ -49,25 +62,24 @@ public:
     using name_type = std::string;
     using nameof_type = std::function<const name_type(const T&)>;
     using iterator_type = typename std::vector<T>::iterator;
+    using const_iterator_type = typename std::vector<T>::const_iterator;
     
     NameMap(const nameof_type& nameOf, bool insensitive, bool ordered):
         m_nameOf(nameOf), m_insensitive(insensitive), m_ordered(ordered) {}
     
     // Returns the index of the value with the given name or -1 if a value with that name does not exist.
-    constexpr int IndexOf(const name_type& name) const noexcept { return indexOf(toKey(name)); }
+    constexpr int IndexOf(std::string_view name) const noexcept { return indexOf(name, hashOf(name)); }
     // Returns whether a value exists in this map with the given name.
-    constexpr bool Has(const name_type& name) const noexcept { return IndexOf(name) != -1; }
+    constexpr bool Has(std::string_view name) const noexcept { return IndexOf(name) != -1; }
     // Returns the number of items in the map.
     constexpr int Size() const noexcept { return m_values.size(); }
     // Adds a named value to the map and returns true on success. False is returned
     // if a value with the given name already exists.
     bool Add(const T& value) {
         auto key = keyOf(value);
-        auto missing = !m_indices.count(key);
+        auto missing = indexOf(key, hashOf(key)) == -1;
         if (missing) {
-            auto i = m_values.size();
-            m_values.push_back(value);
-            m_indices[key] = i;
+            push(value, std::move(key));
         }
         return missing;
     }
@@ -75,109 +87,318 @@ public:
     // already the existing value is replaced.
     void Set(const T& value) {
         auto key = keyOf(value);
-        auto index = indexOf(key);
+        auto index = indexOf(key, hashOf(key));
         if (index != -1) {
             m_values[index] = value;
         } else {
-            auto i = m_values.size();
-            m_values.push_back(value);
-            m_indices[key] = i;
+            push(value, std::move(key));
         }
     }
     // Removes the value from the map.
-    constexpr bool Remove(const T& value) noexcept {
-        return RemoveName(keyOf(value));
+    bool Remove(const T& value) noexcept {
+        return RemoveName(m_nameOf(value));
     }
-    // Removes the value with the name from the map.
-    bool RemoveName(const name_type& name) noexcept {
-        auto key = toKey(name);
-        auto index = indexOf(key);
+    // Removes the value with the name from the map. If the map is ordered the values after it
+    // are shifted down, otherwise the last value takes its place.
+    bool RemoveName(std::string_view name) noexcept {
+        auto index = IndexOf(name);
         auto exists = index != -1;
         if (exists) {
-            auto last = m_values.size() - 1;
-            auto notLast = index < last;
-            if (m_ordered && !notLast) {
+            auto last = int(m_values.size()) - 1;
+            if (m_ordered) {
                 m_values.erase(m_values.begin() + index);
-                m_indices.erase(key);
-                for (auto& pair : m_indices) {
-                    if (pair.second > index) {
-                        pair.second--;
-                    }
-                }
+                m_keys.erase(m_keys.begin() + index);
+                m_hashes.erase(m_hashes.begin() + index);
             } else {
-                if (!notLast) {
-                    auto lastKey = keyOf(m_values[last]);
-                    m_indices[lastKey] = index;
-                    m_values[index] = m_values[last];
+                if (index < last) {
+                    m_values[index] = std::move(m_values[last]);
+                    m_keys[index] = std::move(m_keys[last]);
+                    m_hashes[index] = m_hashes[last];
                 }
                 m_values.pop_back();
-                m_indices.erase(key);
+                m_keys.pop_back();
+                m_hashes.pop_back();
             }
+            reindex();
         }
         return exists;
     }
     // Gets a value with the name from the map and whether it exists at all.
-    constexpr T Get(const name_type& name) const noexcept {
-        auto key = toKey(name);
-        auto index = indexOf(key);
-        if (index != -1) {
-            return m_values[index];
-        }
-        return T();
+    constexpr T Get(std::string_view name) const noexcept {
+        auto ptr = Ptr(name);
+        return ptr != nullptr ? *ptr : T();
+    }
+    // Returns a pointer to the value with the name or null if it does not exist. The pointer is valid until
+    // the map is modified.
+    constexpr const T* Ptr(std::string_view name) const noexcept {
+        auto index = IndexOf(name);
+        return index != -1 ? &m_values[index] : nullptr;
     }
+    // Returns the value at the index returned by IndexOf.
+    constexpr const T& At(int index) const noexcept { return m_values[index]; }
     // Clears the map of all values.
     void Clear() noexcept {
         m_values.clear();
-        m_indices.clear();
+        m_keys.clear();
+        m_hashes.clear();
+        m_table.clear();
     }
     // Handles the value being renamed given the old name. If the old name
     // does not exist a rebuild is performed.
     void Rename(name_type oldName) noexcept {
-        auto oldKey = toKey(oldName);
-        auto index = indexOf(oldKey);
+        auto index = IndexOf(oldName);
         if (index != -1) {
-            auto value = m_values[index];
-            auto newKey = keyOf(value);
-            m_indices.erase(oldKey);
-            m_indices[newKey] = index;
+            m_keys[index] = keyOf(m_values[index]);
+            m_hashes[index] = hashOf(m_keys[index]);
+            reindex();
         } else {
             Rebuild();
         }
     }
-    // Handles the value being renamed given the old name. If the old name
-    // does not exist a rebuild is performed.
+    // Recomputes the keys of all values, needed when values were renamed. 
     void Rebuild() noexcept {
-        m_indices.clear();
         for (int i = 0; i < m_values.size(); i++) {
-            auto key = keyOf(m_values[i]);
-            m_indices[key] = i;
+            m_keys[i] = keyOf(m_values[i]);
+            m_hashes[i] = hashOf(m_keys[i]);
         }
+        reindex();
     }
 
     // Iteration
     iterator_type begin() noexcept { return m_values.begin(); }
     iterator_type end() noexcept { return m_values.end(); }
+    const_iterator_type begin() const noexcept { return m_values.begin(); }
+    const_iterator_type end() const noexcept { return m_values.end(); }
 private:
     std::vector<T> m_values;
-    std::map<name_type, int> m_indices;
+    // The case folded key of each value.
+    std::vector<name_type> m_keys;
+    // The hash of each key.
+    std::vector<uint32_t> m_hashes;
+    // Open addressing table of value indices, -1 is an empty slot. The size is a power of 2.
+    std::vector<int> m_table;
     nameof_type m_nameOf;
     bool m_insensitive;
     bool m_ordered;
 
-    // Converts the name to a key used in the index map.
-    constexpr const name_type toKey(const name_type& x) const noexcept {
+    // Converts the value to a key used in the index.
+    const name_type keyOf(const T& item) const noexcept {
+        auto key = m_nameOf(item);
         if (m_insensitive) {
-            return lowercase(x);
+            transform(key.begin(), key.end(), key.begin(), lowercaseChar);
+        }
+        return key;
+    }
+    // The FNV-1a hash of the name folded like the keys are.
+    constexpr uint32_t hashOf(std::string_view name) const noexcept {
+        uint32_t hash = 2166136261u;
+        for (auto c : name) {
+            hash ^= uint8_t(m_insensitive ? lowercaseChar(c) : c);
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+    // Whether the name folded matches the key.
+    constexpr bool matches(const name_type& key, std::string_view name) const noexcept {
+        if (key.size() != name.size()) {
+            return false;
+        }
+        if (!m_insensitive) {
+            return key == name;
+        }
+        for (size_t i = 0; i < name.size(); i++) {
+            if (key[i] != lowercaseChar(name[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+    constexpr int indexOf(std::string_view name, uint32_t hash) const noexcept {
+        if (m_table.empty()) {
+            return -1;
+        }
+        auto mask = m_table.size() - 1;
+        for (auto slot = hash & mask;; slot = (slot + 1) & mask) {
+            auto index = m_table[slot];
+            if (index == -1) {
+                return -1;
+            }
+            if (m_hashes[index] == hash && matches(m_keys[index], name)) {
+                return index;
+            }
+        }
+    }
+    void push(const T& value, name_type&& key) {
+        m_hashes.push_back(hashOf(key));
+        m_keys.push_back(std::move(key));
+        m_values.push_back(value);
+        if (m_values.size() * 2 > m_table.size()) {
+            reindex();
+        } else {
+            insert(m_values.size() - 1);
+        }
+    }
+    void insert(int index) noexcept {
+        auto mask = m_table.size() - 1;
+        auto slot = m_hashes[index] & mask;
+        while (m_table[slot] != -1) {
+            slot = (slot + 1) & mask;
+        }
+        m_table[slot] = index;
+    }
+    // Rebuilds the table from the hashes, keeping at most half of it occupied.
+    void reindex() noexcept {
+        size_t size = 8;
+        while (size < m_values.size() * 2) {
+            size <<= 1;
+        }
+        m_table.assign(size, -1);
+        for (int i = 0; i < m_values.size(); i++) {
+            insert(i);
+        }
+    }
+};
+
+// A pool of threads that run ranges of work together. A range is split into chunks that are dealt out in
+// contiguous spans to a queue per thread, and a thread that runs out of chunks steals from the back of the others.
+// The thread calling For works on its own queue too.
+class WorkPool {
+public:
+    // Creates a pool with the given number of threads including the caller, 0 for the hardware concurrency.
+    WorkPool(size_t threads = 0) {
+        if (threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        for (size_t t = 0; t < threads; t++) {
+            m_queues.push_back(std::make_unique<Queue>());
+        }
+        for (size_t t = 1; t < threads; t++) {
+            m_workers.emplace_back([this, t]() { work(t); });
         }
-        return x;
     }
-    // Converts the value to a key used in the index map.
-    constexpr const name_type keyOf(const T& item) const noexcept {
-        auto name = m_nameOf(item);
-        return toKey(name);
+    WorkPool(const WorkPool&) = delete;
+    WorkPool& operator=(const WorkPool&) = delete;
+    ~WorkPool() {
+        {
+            auto lock = std::unique_lock(m_mutex);
+            m_stop = true;
+        }
+        m_wake.notify_all();
+        for (auto& worker : m_workers) {
+            worker.join();
+        }
     }
-    constexpr int indexOf(const name_type& key) const noexcept {
-        auto it = m_indices.find(key);
-        return it != m_indices.end() ? it->second : -1;
+
+    // The number of threads that run work, including the caller.
+    size_t Threads() const noexcept { return m_queues.size(); }
+
+    // Calls fn(start, end) for chunks of at most grain indices covering [0, count) and returns once they've all run.
+    // Any thread can run any chunk, so fn should only depend on its range for the results to be deterministic.
+    template<typename Fn>
+    void For(size_t count, size_t grain, Fn&& fn) {
+        grain = std::max(size_t(1), grain);
+        auto chunks = (count + grain - 1) / grain;
+        auto runChunk = [&fn, count, grain](size_t chunk) {
+            auto start = chunk * grain;
+            fn(start, std::min(count, start + grain));
+        };
+        if (chunks <= 1 || Threads() == 1) {
+            for (size_t chunk = 0; chunk < chunks; chunk++) {
+                runChunk(chunk);
+            }
+            return;
+        }
+        auto running = std::unique_lock(m_running);
+        {
+            // Workers still searching queues from the previous call need to be done before they're reused.
+            auto lock = std::unique_lock(m_mutex);
+            m_done.wait(lock, [this]() { return m_active == 0; });
+
+            auto threads = Threads();
+            auto perThread = (chunks + threads - 1) / threads;
+            for (size_t t = 0; t < threads; t++) {
+                auto& queue = *m_queues[t];
+                auto queueLock = std::unique_lock(queue.mutex);
+                for (auto chunk = t * perThread; chunk < std::min(chunks, (t + 1) * perThread); chunk++) {
+                    queue.chunks.push_back(chunk);
+                }
+            }
+            m_job = runChunk;
+            m_remaining = chunks;
+            m_generation++;
+        }
+        m_wake.notify_all();
+        run(0);
+
+        auto lock = std::unique_lock(m_mutex);
+        m_done.wait(lock, [this]() { return m_remaining == 0; });
+        m_job = nullptr;
     }
-};
\ No newline at end of file
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<size_t> chunks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> m_queues;
+    std::vector<std::thread> m_workers;
+    std::function<void(size_t)> m_job;
+    std::atomic<size_t> m_remaining = 0;
+    // Guards the generation, active count, and stopping, and a job being set up.
+    std::mutex m_mutex;
+    // Only one For runs on the pool at a time.
+    std::mutex m_running;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    size_t m_generation = 0;
+    size_t m_active = 0;
+    bool m_stop = false;
+
+    void work(size_t thread) {
+        size_t seen = 0;
+        auto lock = std::unique_lock(m_mutex);
+        while (true) {
+            m_wake.wait(lock, [&]() { return m_stop || m_generation != seen; });
+            if (m_stop) {
+                return;
+            }
+            seen = m_generation;
+            m_active++;
+            lock.unlock();
+            run(thread);
+            lock.lock();
+            m_active--;
+            m_done.notify_all();
+        }
+    }
+    void run(size_t thread) {
+        size_t chunk;
+        while (take(thread, chunk)) {
+            m_job(chunk);
+            if (m_remaining.fetch_sub(1) == 1) {
+                auto lock = std::unique_lock(m_mutex);
+                m_done.notify_all();
+            }
+        }
+    }
+    // Takes the next chunk from the thread's queue, or steals the last chunk of another.
+    bool take(size_t thread, size_t& chunk) {
+        auto threads = m_queues.size();
+        for (size_t i = 0; i < threads; i++) {
+            auto& queue = *m_queues[(thread + i) % threads];
+            auto lock = std::unique_lock(queue.mutex);
+            if (!queue.chunks.empty()) {
+                if (i == 0) {
+                    chunk = queue.chunks.front();
+                    queue.chunks.pop_front();
+                } else {
+                    chunk = queue.chunks.back();
+                    queue.chunks.pop_back();
+                }
+                return true;
+            }
+        }
+        return false;
+    }
+};
@@ -1,5 +1,12 @@
 #pragma once
 #include <iostream>
+#include <chrono>
+#include <mutex>
+#include <vector>
+#include <memory>
+#include <map>
+#include <string>
+#include <cstdint>
 
 // To see logging you need to: `#define LOG_ENABLED true` before any included file you want logging in. 
 // Then you can set LogLevel to control while the application runs.
@@ -10,6 +17,12 @@
 // To have assert logic run you need to: `#define ASSERT_ENABLED true` before any included file you want validation in. 
 // Then you can set AssertLevel to control while the application runs.
 
+// To have profiling run you need to: `#define PROFILE_ENABLED true` before any included file you want profiled.
+// Then you can set Profiling to control while the application runs. PROFILE_ZONE(name) times the rest of the scope
+// and PROFILE_COUNT(name, amount) counts something, names must be string literals. Events are recorded in a ring
+// buffer per thread, see ProfileTrace & ProfileTotals. If PROFILE_TRACY is also defined the zones & counts are sent
+// to Tracy instead (include Tracy yourself).
+
 int DebugFilenameMaxLength = 12;
 
 #define ECHO(message) std::cout << std::string(__FILE__).substr(std::string(__FILE__).size() - DebugFilenameMaxLength) << " (" << __LINE__ << ") " << message << std::endl;
@@ -56,4 +69,177 @@ if (level >= AssertLevel && !(condition)) { \
 #else
 #define ASSERT(level, condition, message)
 #define ASSERT_THROW(level, condition, message)
-#endif
\ No newline at end of file
+#endif
+
+bool Profiling = false;
+
+// A zone timed or an amount counted on a thread.
+struct ProfileEvent {
+    const char* name;
+    // Nanoseconds since the profiler started.
+    int64_t start;
+    // Nanoseconds the zone took, or the amount counted.
+    int64_t value;
+    bool count;
+};
+
+// The total of all events recorded with a name.
+struct ProfileTotal {
+    const char* name;
+    // How many zones or counts were recorded.
+    size_t events;
+    // The nanoseconds in the zones or the sum of the counts.
+    int64_t total;
+    bool count;
+};
+
+// The most recent events of a thread. Only the thread writes to it, read it when profiled code isn't running.
+class ProfileBuffer {
+public:
+    ProfileBuffer(size_t capacity, uint32_t thread): m_events(capacity), m_next(0), m_thread(thread) {}
+
+    // Records the event, overwriting the oldest when full.
+    inline void Add(const ProfileEvent& event) noexcept {
+        m_events[m_next % m_events.size()] = event;
+        m_next++;
+    }
+    // Calls fn with each event from oldest to newest.
+    template<typename Fn>
+    void Each(Fn&& fn) const {
+        auto count = std::min(m_next, m_events.size());
+        for (auto i = m_next - count; i < m_next; i++) {
+            fn(m_events[i % m_events.size()]);
+        }
+    }
+    // Removes all events.
+    void Clear() noexcept { m_next = 0; }
+    // The number of the thread, in the order threads first recorded an event.
+    uint32_t Thread() const noexcept { return m_thread; }
+    // The number of events recorded, including those overwritten.
+    size_t Recorded() const noexcept { return m_next; }
+
+private:
+    std::vector<ProfileEvent> m_events;
+    size_t m_next;
+    uint32_t m_thread;
+};
+
+// How many events each thread keeps.
+size_t ProfileCapacity = 1 << 14;
+
+// The buffers of every thread that recorded an event, they're kept when threads end.
+class Profiler {
+public:
+    // Nanoseconds since the profiler started.
+    static inline int64_t Now() noexcept {
+        static const auto start = std::chrono::steady_clock::now();
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+    // The buffer of the calling thread.
+    static inline ProfileBuffer& Thread() {
+        thread_local auto buffer = add();
+        return *buffer;
+    }
+    // Calls fn with each thread's buffer.
+    template<typename Fn>
+    static void Each(Fn&& fn) {
+        auto lock = std::lock_guard(mutex());
+        for (auto& buffer : buffers()) {
+            fn(*buffer);
+        }
+    }
+
+private:
+    static std::mutex& mutex() {
+        static std::mutex m;
+        return m;
+    }
+    static std::vector<std::shared_ptr<ProfileBuffer>>& buffers() {
+        static std::vector<std::shared_ptr<ProfileBuffer>> b;
+        return b;
+    }
+    static std::shared_ptr<ProfileBuffer> add() {
+        auto lock = std::lock_guard(mutex());
+        auto buffer = std::make_shared<ProfileBuffer>(ProfileCapacity, uint32_t(buffers().size()));
+        buffers().push_back(buffer);
+        return buffer;
+    }
+};
+
+// Times the scope it's in, see PROFILE_ZONE.
+class ProfileZone {
+public:
+    inline ProfileZone(const char* name) noexcept: m_name(name), m_start(Profiling ? Profiler::Now() : -1) {}
+    inline ~ProfileZone() {
+        if (m_start >= 0) {
+            Profiler::Thread().Add(ProfileEvent{m_name, m_start, Profiler::Now() - m_start, false});
+        }
+    }
+private:
+    const char* m_name;
+    int64_t m_start;
+};
+
+// Counts an amount, see PROFILE_COUNT.
+inline void ProfileCount(const char* name, int64_t amount) {
+    if (Profiling) {
+        Profiler::Thread().Add(ProfileEvent{name, Profiler::Now(), amount, true});
+    }
+}
+
+// Removes the events of every thread.
+inline void ProfileClear() {
+    Profiler::Each([](ProfileBuffer& buffer) { buffer.Clear(); });
+}
+
+// The totals of the recorded events by name, in order of name.
+inline std::vector<ProfileTotal> ProfileTotals() {
+    auto totals = std::map<std::string, ProfileTotal>();
+    Profiler::Each([&totals](ProfileBuffer& buffer) {
+        buffer.Each([&totals](const ProfileEvent& event) {
+            auto& total = totals.try_emplace(event.name, ProfileTotal{event.name, 0, 0, event.count}).first->second;
+            total.events++;
+            total.total += event.value;
+        });
+    });
+    auto list = std::vector<ProfileTotal>();
+    for (auto& [name, total] : totals) {
+        list.push_back(total);
+    }
+    return list;
+}
+
+// Writes the recorded events as Chrome trace JSON, which chrome://tracing and Perfetto load. Zones are complete 
+// events and counts are counter events of the running total on each thread. Returns the number of events written.
+inline size_t ProfileTrace(std::ostream& out) {
+    auto written = size_t(0);
+    out << "{\"traceEvents\":[";
+    Profiler::Each([&out, &written](ProfileBuffer& buffer) {
+        auto running = std::map<const char*, int64_t>();
+        buffer.Each([&](const ProfileEvent& event) {
+            out << (written++ == 0 ? "\n" : ",\n");
+            out << "{\"name\":\"" << event.name << "\",\"pid\":0,\"tid\":" << buffer.Thread() << ",\"ts\":" << (double(event.start) / 1000.0);
+            if (event.count) {
+                out << ",\"ph\":\"C\",\"args\":{\"value\":" << (running[event.name] += event.value) << "}}";
+            } else {
+                out << ",\"ph\":\"X\",\"dur\":" << (double(event.value) / 1000.0) << "}";
+            }
+        });
+    });
+    out << "\n],\"displayTimeUnit\":\"ns\"}\n";
+    return written;
+}
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#if defined(PROFILE_ENABLED) && defined(PROFILE_TRACY)
+#define PROFILE_ZONE(name) ZoneScopedN(name);
+#define PROFILE_COUNT(name, amount) TracyPlot(name, int64_t(amount));
+#elif defined(PROFILE_ENABLED)
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name);
+#define PROFILE_COUNT(name, amount) ProfileCount(name, int64_t(amount));
+#else
+#define PROFILE_ZONE(name)
+#define PROFILE_COUNT(name, amount)
+#endif
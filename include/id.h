@@ -7,6 +7,31 @@
 #include <ranges>
 #include <iterator>
 #include <cstddef>
+#include <string_view>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <bit>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <new>
+#include <cstdio>
+#include <algorithm>
+#if defined(__SSE2__) || defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "debug.h"
 
 // Strings aren't the best for games. Their data is scattered, divided, leaderless!
 // Games like contiguous data with constant time operations. 
@@ -47,138 +72,780 @@ namespace id {
     // Declare these ahead of time
     class Identifier;
 
+    // Hashes character data for the identifier index. This is FNV-1a which is simple, fast for
+    // short strings, and constexpr so the same hash can be computed at compile time.
+    constexpr uint32_t Hash(std::string_view chars) noexcept {
+        uint32_t hash = 2166136261u;
+        for (auto c : chars) {
+            hash ^= uint8_t(c);
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    // An append-only array with stable element addresses. Segment k holds 2^(BasePower+k) elements
+    // so a fixed table of segment pointers can address every id without ever moving data. Reading
+    // an element that was published (see Memory) is lock-free, only growing requires the caller
+    // to hold a lock.
+    template<typename T, size_t BasePower>
+    class Segments {
+        static constexpr size_t Max = 32;
+
+        std::atomic<T*> m_segments[Max];
+        size_t m_capacity;
+        // a bit for each segment that was allocated here and not adopted.
+        uint32_t m_owned;
+
+    public:
+        Segments(): m_capacity(0), m_owned(0) {
+            for (auto& segment : m_segments) {
+                segment.store(nullptr, std::memory_order_relaxed);
+            }
+        }
+        ~Segments() {
+            Reset();
+        }
+        Segments(const Segments&) = delete;
+        Segments& operator=(const Segments&) = delete;
+
+        // Returns the element at the given index, it must be within the capacity.
+        inline T& operator[](size_t index) const noexcept {
+            auto v = (index >> BasePower) + 1;
+            auto k = std::bit_width(v) - 1;
+            auto offset = index - (((size_t(1) << k) - 1) << BasePower);
+            return m_segments[k].load(std::memory_order_acquire)[offset];
+        }
+        // Allocates segments until the given number of elements fit.
+        void Grow(size_t size) {
+            while (m_capacity < size) {
+                auto k = std::bit_width((m_capacity >> BasePower) + 1) - 1;
+                auto n = size_t(1) << (BasePower + k);
+                m_segments[k].store(new T[n](), std::memory_order_release);
+                m_owned |= uint32_t(1) << k;
+                m_capacity += n;
+            }
+        }
+        // Uses the given external elements as the first segments, the size must be a Fit value.
+        // The elements are never freed here and must live longer than these segments.
+        void Adopt(T* data, size_t size) {
+            Reset();
+            while (m_capacity < size) {
+                auto k = std::bit_width((m_capacity >> BasePower) + 1) - 1;
+                m_segments[k].store(data + m_capacity, std::memory_order_release);
+                m_capacity += size_t(1) << (BasePower + k);
+            }
+        }
+        // Frees the owned segments and returns to having no capacity.
+        void Reset() {
+            for (size_t k = 0; k < Max; k++) {
+                auto segment = m_segments[k].exchange(nullptr, std::memory_order_relaxed);
+                if (m_owned & (uint32_t(1) << k)) {
+                    delete[] segment;
+                }
+            }
+            m_owned = 0;
+            m_capacity = 0;
+        }
+        // Returns the capacity of whole segments it takes to fit the given number of elements.
+        static constexpr size_t Fit(size_t size) noexcept {
+            size_t capacity = 0;
+            while (capacity < size) {
+                capacity += size_t(1) << (BasePower + std::bit_width((capacity >> BasePower) + 1) - 1);
+            }
+            return capacity;
+        }
+        // Returns how many elements fit without growing.
+        constexpr size_t Capacity() const noexcept { return m_capacity; }
+    };
+
+    // Memory is sharded by hash to let concurrent Translate calls lock only part of the index.
+    // The user can define this to override the default of 16 shards.
+    #ifndef MEMORY_SHARD_POWER
+    #define MEMORY_SHARD_POWER 4
+    #endif
+
+    // Whether the global memory starts in concurrent mode. The user can define this to true
+    // or call `memory.Concurrent(true)` before any other threads use identifiers.
+    #ifndef MEMORY_CONCURRENT
+    #define MEMORY_CONCURRENT false
+    #endif
+
     // Memory keeps all the character data and keeps track of all identifiers created.
+    // In concurrent mode identifiers can be created and resolved from any thread:
+    // - LookupChars & Storage never lock, character data and offsets are never moved once published.
+    // - Peek & Translate take a shared lock on one shard of the index, and only a Translate that
+    //   creates an identifier takes an exclusive shard lock and the short lock around storage.
     class Memory {
+        // A slot in the open-addressing index. The hash is kept next to the storage offset
+        // so most probes are rejected without touching the character data, and a match
+        // only needs to compare the characters once.
+        struct Slot {
+            uint32_t hash;
+            storage_t storage;
+            // 0 is an empty slot, the empty identifier is never placed in the index.
+            id_t uid;
+        };
+
+        // A part of the index, which part an identifier goes in is decided by its hash.
+        struct alignas(64) Shard {
+            // Guards the slots of this shard in concurrent mode.
+            mutable std::shared_mutex lock;
+            // a content hashed index of character data to the unique id.
+            Slot* slots;
+            // the number of slots, always a power of 2.
+            size_t capacity;
+            // the number of used slots in the index.
+            size_t count;
+            // whether the slots were allocated here, otherwise they're in a snapshot.
+            bool owned;
+        };
+
+        // The start of a snapshot file. The sections follow it, each starting on an 8 byte boundary:
+        // - the offset of each page in the file (uint64)
+        // - the storage of each id, padded to whole storage segments so they can be adopted
+        // - a SnapshotShard for each shard, then the slots of each shard
+        // - the character data of each page
+        struct SnapshotHeader {
+            char magic[8];
+            uint32_t version;
+            uint32_t pagePower;
+            uint32_t shardPower;
+            uint32_t count;
+            uint32_t storageEnd;
+            uint32_t pageCount;
+            uint64_t pagesOffset;
+            uint64_t storageOffset;
+            uint64_t shardsOffset;
+            uint64_t size;
+        };
+        struct SnapshotShard {
+            uint64_t offset;
+            uint64_t capacity;
+            uint64_t count;
+        };
+
+        static constexpr char SnapshotMagic[8] = "NAGEIDS";
+        // Bump when the layout of a snapshot or the storage segments change.
+        static constexpr uint32_t SnapshotVersion = 1;
+
+        static constexpr size_t ShardPower = MEMORY_SHARD_POWER;
+        static constexpr size_t ShardCount = size_t(1) << ShardPower;
+
         // The power passed to memory to compute mask & shift for page related operations.
         const id_t m_pagePower;
         const id_t m_pageMask;
         const id_t m_pageSize;
 
-        // a global map of const char* to the unique id.
-        std::map<const char*, id_t> m_ids;
+        // Whether locks are taken, single threaded applications don't pay for them.
+        bool m_concurrent;
+        // The index split into shards.
+        Shard m_shards[ShardCount];
+        // Guards storing new character data and generating the next uid in concurrent mode. It's always taken after
+        // any shard locks, never before.
+        std::mutex m_storeLock;
         // pages of where character data is stored for the ids.
-        std::vector<const char*> m_pages;
-        // the list of offsets into the pages given the unique id is the index into this vector.
-        std::vector<storage_t> m_storage;
+        Segments<const char*, 6> m_pages;
+        // the number of pages allocated.
+        size_t m_pageCount;
+        // the list of offsets into the pages given the unique id is the index into these segments.
+        Segments<storage_t, 10> m_storage;
+        // the number of published ids, every uid below this can be looked up without locking.
+        std::atomic<id_t> m_count;
         // the end of the last id placed in storage.
         storage_t m_storageEnd;
+        // the number of pages at the start which are in a loaded snapshot and not allocated here.
+        size_t m_snapshotPages;
+        // the loaded snapshot, either mapped or read into one allocation.
+        void* m_snapshot;
+        size_t m_snapshotSize;
+        bool m_snapshotMapped;
 
     public:
-        // Creates memory given a page size expressed as a power of 2 exponent.
-        Memory(size_t pagePower): 
+        // Creates memory given a page size expressed as a power of 2 exponent and whether
+        // it will be used from multiple threads.
+        Memory(size_t pagePower, bool concurrent = false): 
             m_pagePower(pagePower),
             m_pageMask((1 << pagePower) - 1),
             m_pageSize(1 << pagePower),
-            m_ids(),
-            m_pages(),
-            m_storage(),
-            m_storageEnd()
+            m_concurrent(concurrent),
+            m_pageCount(0),
+            m_count(0),
+            m_storageEnd(),
+            m_snapshotPages(0),
+            m_snapshot(nullptr),
+            m_snapshotSize(0),
+            m_snapshotMapped(false)
         {
+            for (auto& shard : m_shards) {
+                shard.capacity = 1024 / ShardCount < 16 ? 16 : 1024 / ShardCount;
+                shard.slots = new Slot[shard.capacity]();
+                shard.count = 0;
+                shard.owned = true;
+            }
             // Automatically add in identifier for null/empty identifiers.
-            m_ids[empty] = 0;
-            m_storage.push_back(0);
+            m_storage.Grow(1);
+            m_storage[0] = 0;
+            m_count.store(1, std::memory_order_release);
             m_storageEnd = 1;
-            m_pages.emplace_back(new char[m_pageSize]);
+            addPage(m_pageSize);
             memcpy((void*)m_pages[0], (void*)empty, 1);
         }
         ~Memory() {
-            for (auto page : m_pages) {
-                delete(page);
+            for (size_t i = m_snapshotPages; i < m_pageCount; i++) {
+                delete[] m_pages[i];
             }
+            for (auto& shard : m_shards) {
+                if (shard.owned) {
+                    delete[] shard.slots;
+                }
+            }
+            m_storage.Reset();
+            releaseSnapshot();
         }
 
         // Quick access to all defined identifiers.
         auto All();
+
+        // Returns whether memory is guarding itself against use from multiple threads.
+        constexpr bool IsConcurrent() const noexcept { return m_concurrent; }
+        // Sets whether memory guards itself against use from multiple threads. This 
+        // must be set before other threads start using memory.
+        void Concurrent(bool concurrent) noexcept { m_concurrent = concurrent; }
+
+        // Prepares memory for the given total number of identifiers so interning them
+        // does not need to grow the index or storage along the way.
+        void Reserve(size_t count) {
+            for (auto& shard : m_shards) {
+                auto shardLock = lock(shard.lock);
+                auto capacity = shard.capacity;
+                while (capacity < count * 2 / ShardCount) {
+                    capacity <<= 1;
+                }
+                if (capacity != shard.capacity) {
+                    rehash(shard, capacity);
+                }
+            }
+            auto storeLock = lock(m_storeLock);
+            m_storage.Grow(count);
+        }
     
         // Converts the unique id to the character data.
         // The unique id must be valid, otherwise unexpected behavior.
-        const char* LookupChars(id_t uid) {
-            auto pageIndex = m_storage[uid];
-            auto page = m_pages[pageIndex >> m_pagePower];
-            return page + (pageIndex & m_pageMask);
+        const char* LookupChars(id_t uid) const noexcept {
+            return charsAt(m_storage[uid]);
         }
 
         // Returns the unique id for the character data if it exists,
         // otherwise -1 is returned.
-        const int32_t Peek(const char* chars) {
-            if (chars == nullptr || *chars == '\0') {
+        const int32_t Peek(std::string_view chars) const noexcept {
+            return Peek(chars, Hash(chars));
+        }
+
+        // Returns the unique id for the character data with an already computed Hash if it exists,
+        // otherwise -1 is returned.
+        const int32_t Peek(std::string_view chars, uint32_t hash) const noexcept {
+            if (chars.empty()) {
                 return 0;
             }
-            auto found = m_ids.find(chars);
-            return found == m_ids.end() ? -1 : found->second;
+            auto& shard = shardOf(hash);
+            auto shardLock = lockShared(shard.lock);
+            auto& slot = shard.slots[find(shard, chars, hash)];
+            return slot.uid == 0 ? -1 : int32_t(slot.uid);
+        }
+
+        // Returns the unique id for the character data if it exists,
+        // otherwise -1 is returned.
+        const int32_t Peek(const char* chars) const noexcept {
+            return chars == nullptr ? 0 : Peek(std::string_view(chars));
+        }
+
+        // Returns the unique id for the string if it exists, otherwise -1 is returned.
+        const int32_t Peek(const std::string& str) const noexcept {
+            return Peek(std::string_view(str));
         }
 
         // Generates an Identifier for the given input. 
         // If the identifier already exists then it is returned.
         // Otherwise the data given here is copied into internal character data
         // storage and its referenced by the identifier that's returned.
-        // This should be used sparingly since it involves a map lookup.
+        // This should be used sparingly since it involves a hash lookup.
         // During the lifecycle of an application try to call this early on
         // and avoid it after that to get the best performance.
-        const id_t Translate(const char* chars) {
-            if (chars == nullptr || *chars == '\0') {
+        const id_t Translate(std::string_view chars) {
+            return Translate(chars, Hash(chars));
+        }
+
+        // Converts characters with an already computed Hash to an Identifier, like identifier literals
+        // hashed at compile time. See the `std::string_view` documentation.
+        const id_t Translate(std::string_view chars, uint32_t hash) {
+            PROFILE_ZONE("id::Memory::Translate")
+            if (chars.empty()) {
                 return 0;
             }
-            auto found = m_ids.find(chars);
-            if (found == m_ids.end()) {
-                // Include the terminating character
-                auto n = strlen(chars) + 1;
-                // Where the new end would be.
-                auto end = m_storageEnd + n;
-                // Where the max end is based on the pages allocated.
-                auto pageEnd = m_pages.size() * m_pageSize;
-                // Do we need another page?
-                if (end > pageEnd) {
-                    // This is required if they have an identifier over the page size.
-                    // We create a special page size for it to avoid error.
-                    auto pageSize = n > m_pageSize ? n : m_pageSize;
-
-                    m_pages.emplace_back(new char[pageSize]);
-                    m_storageEnd = pageEnd;
-                }
-                // Which page?
-                auto pageIndex = m_storageEnd >> m_pagePower;
-                // How many characters into the page?
-                auto pageOffset = m_storageEnd & m_pageMask;
-                // The location in memory to the start of the page.
-                auto page = m_pages[pageIndex];
-                // The location in memory of where the character data will be stored.
-                auto pagePtr = (void*)(page + pageOffset);
-                // Copy the data into character storage.
-                memcpy(pagePtr, chars, n);
+            auto& shard = shardOf(hash);
+            if (m_concurrent) {
+                // Most translations are for existing identifiers, those only need a shared lock.
+                auto shardLock = lockShared(shard.lock);
+                auto& slot = shard.slots[find(shard, chars, hash)];
+                if (slot.uid != 0) {
+                    return slot.uid;
+                }
+            }
+            auto shardLock = lock(shard.lock);
+            auto index = find(shard, chars, hash);
+            if (shard.slots[index].uid != 0) {
+                return shard.slots[index].uid;
+            }
+
+            storage_t storage;
+            id_t uid;
+            {
+                auto storeLock = lock(m_storeLock);
+                storage = store(chars);
 
                 // The next uuid is simply generated by looking at how many have been so far.
-                auto uid = m_storage.size();
+                uid = m_count.load(std::memory_order_relaxed);
 
                 // Add the place in storage where the character data will be stored.
-                m_storage.push_back(m_storageEnd);
-                // Add the map for later lookups of the same identifier.
-                m_ids[chars] = uid;
+                m_storage.Grow(size_t(uid) + 1);
+                m_storage[uid] = storage;
+                m_count.store(uid + 1, std::memory_order_release);
+            }
 
-                // Move the place to store the next identifier to after this one.
-                // We compare n to page size in the event the identifier is larger. 
-                // We store really large identifiers in a custom page size.
-                m_storageEnd += n > m_pageSize ? m_pageSize : n;
+            // Add to the index for later lookups of the same identifier.
+            shard.slots[index] = Slot{hash, storage, uid};
+            shard.count++;
 
-                return uid;
-            } else {
-                return found->second;
+            // Keep the index at most half full so probes stay short.
+            if (shard.count * 2 > shard.capacity) {
+                rehash(shard, shard.capacity << 1);
             }
+
+            return uid;
+        }
+
+        // Converts characters to an Identifier. See the `std::string_view` documentation.
+        const id_t Translate(const char* chars) {
+            return chars == nullptr ? 0 : Translate(std::string_view(chars));
         }
 
-        // Converts a string to an Identifier. See the `const char*` documentation.
-        const id_t Translate(std::string str) {
-            return Translate(str.c_str());
+        // Converts a string to an Identifier. See the `std::string_view` documentation.
+        const id_t Translate(const std::string& str) {
+            return Translate(std::string_view(str));
         }   
 
         // Converts a uid to a storage location.
-        const storage_t Storage(id_t uid) {
+        const storage_t Storage(id_t uid) const noexcept {
             return m_storage[uid];
         }   
+
+        // Returns the number of identifiers defined, including the empty identifier.
+        inline id_t Count() const noexcept {
+            return m_count.load(std::memory_order_acquire);
+        }
+
+        // Saves every identifier to a snapshot file that Load can use in place, without copying
+        // character data or rehashing. Returns whether the whole file was written.
+        bool Save(const char* path) {
+            std::unique_lock<std::shared_mutex> shardLocks[ShardCount];
+            for (size_t s = 0; s < ShardCount; s++) {
+                shardLocks[s] = lock(m_shards[s].lock);
+            }
+            auto storeLock = lock(m_storeLock);
+
+            auto count = m_count.load(std::memory_order_relaxed);
+            auto storageSize = Segments<storage_t, 10>::Fit(count);
+
+            SnapshotHeader header{};
+            memcpy(header.magic, SnapshotMagic, sizeof(header.magic));
+            header.version = SnapshotVersion;
+            header.pagePower = m_pagePower;
+            header.shardPower = ShardPower;
+            header.count = count;
+            header.storageEnd = m_storageEnd;
+            header.pageCount = m_pageCount;
+
+            // Lay out the sections before writing anything.
+            uint64_t offset = snapshotAlign(sizeof(SnapshotHeader));
+            header.pagesOffset = offset;
+            offset = snapshotAlign(offset + m_pageCount * sizeof(uint64_t));
+            header.storageOffset = offset;
+            offset = snapshotAlign(offset + storageSize * sizeof(storage_t));
+            header.shardsOffset = offset;
+            offset = snapshotAlign(offset + ShardCount * sizeof(SnapshotShard));
+            SnapshotShard shards[ShardCount];
+            for (size_t s = 0; s < ShardCount; s++) {
+                shards[s] = SnapshotShard{offset, m_shards[s].capacity, m_shards[s].count};
+                offset = snapshotAlign(offset + m_shards[s].capacity * sizeof(Slot));
+            }
+            std::vector<uint64_t> pageOffsets(m_pageCount);
+            for (size_t i = 0; i < m_pageCount; i++) {
+                pageOffsets[i] = offset;
+                offset += pageSizeOf(i);
+            }
+            header.size = offset;
+
+            auto file = std::fopen(path, "wb");
+            if (file == nullptr) {
+                return false;
+            }
+            uint64_t written = 0;
+            bool ok = true;
+            auto write = [&](const void* data, size_t size) {
+                ok = ok && std::fwrite(data, 1, size, file) == size;
+                written += size;
+            };
+            auto pad = [&](uint64_t end) {
+                static const char zeros[64] = {};
+                while (ok && written < end) {
+                    write(zeros, end - written < sizeof(zeros) ? end - written : sizeof(zeros));
+                }
+            };
+
+            write(&header, sizeof(header));
+            pad(header.pagesOffset);
+            write(pageOffsets.data(), pageOffsets.size() * sizeof(uint64_t));
+            pad(header.storageOffset);
+            for (size_t start = 0, k = 0; start < count; k++) {
+                auto segmentSize = size_t(1) << (10 + k);
+                auto n = count - start < segmentSize ? count - start : segmentSize;
+                write(&m_storage[start], n * sizeof(storage_t));
+                start += segmentSize;
+            }
+            pad(header.storageOffset + storageSize * sizeof(storage_t));
+            pad(header.shardsOffset);
+            write(shards, sizeof(shards));
+            for (size_t s = 0; s < ShardCount; s++) {
+                pad(shards[s].offset);
+                write(m_shards[s].slots, m_shards[s].capacity * sizeof(Slot));
+            }
+            for (size_t i = 0; i < m_pageCount; i++) {
+                pad(pageOffsets[i]);
+                write(m_pages[i], pageSizeOf(i));
+            }
+
+            return std::fclose(file) == 0 && ok;
+        }
+
+        // Loads a snapshot made by Save. This must be done before any identifiers are created,
+        // ideally at startup. The file is mapped privately so ids, the index, and character data are
+        // used where they are and only the parts changed by new identifiers are ever copied.
+        // The index is rebuilt if the snapshot was saved with a different MEMORY_SHARD_POWER.
+        // Every offset in the file is checked against its size before it's used, so a damaged file is rejected.
+        // Returns whether the snapshot was loaded, otherwise memory is unchanged.
+        bool Load(const char* path) {
+            if (Count() != 1 || m_snapshot != nullptr || !openSnapshot(path)) {
+                return false;
+            }
+            auto base = (char*)m_snapshot;
+            auto size = m_snapshotSize;
+            auto fits = [size](uint64_t offset, uint64_t bytes) {
+                return offset <= size && bytes <= size - offset && offset % 8 == 0;
+            };
+
+            SnapshotHeader header;
+            bool valid = size >= sizeof(header);
+            if (valid) {
+                memcpy(&header, base, sizeof(header));
+                valid = memcmp(header.magic, SnapshotMagic, sizeof(header.magic)) == 0 &&
+                    header.version == SnapshotVersion &&
+                    header.pagePower == m_pagePower &&
+                    header.size == size &&
+                    header.count >= 1 &&
+                    header.pageCount >= 1 &&
+                    header.storageEnd <= uint64_t(header.pageCount) << m_pagePower &&
+                    fits(header.pagesOffset, uint64_t(header.pageCount) * sizeof(uint64_t)) &&
+                    fits(header.storageOffset, Segments<storage_t, 10>::Fit(header.count) * sizeof(storage_t));
+            }
+            // Every page must hold at least a page and end in a terminated identifier.
+            auto pageOffsets = (const uint64_t*)(base + header.pagesOffset);
+            for (size_t i = 0; valid && i < header.pageCount; i++) {
+                valid = pageOffsets[i] <= size && m_pageSize <= size - pageOffsets[i] &&
+                    memchr(base + pageOffsets[i], 0, size - pageOffsets[i]) != nullptr;
+            }
+            // Every id must be stored in a page, before the end of storage, and be terminated in the file.
+            auto storage = (const storage_t*)(base + header.storageOffset);
+            for (size_t uid = 0; valid && uid < header.count; uid++) {
+                auto page = storage[uid] >> m_pagePower;
+                auto start = valid && page < header.pageCount ? pageOffsets[page] + (storage[uid] & m_pageMask) : size;
+                valid = storage[uid] < header.storageEnd && start < size && memchr(base + start, 0, size - start) != nullptr;
+            }
+            // Every slot must refer to an id and where it's stored, and the counts must match the slots.
+            auto sameShards = valid && header.shardPower == ShardPower;
+            auto shards = (const SnapshotShard*)(base + header.shardsOffset);
+            if (sameShards) {
+                valid = fits(header.shardsOffset, ShardCount * sizeof(SnapshotShard));
+                uint64_t total = 0;
+                for (size_t s = 0; valid && s < ShardCount; s++) {
+                    valid = std::has_single_bit(shards[s].capacity) &&
+                        shards[s].count * 2 <= shards[s].capacity &&
+                        fits(shards[s].offset, shards[s].capacity * sizeof(Slot));
+                    auto slots = (const Slot*)(base + shards[s].offset);
+                    uint64_t used = 0;
+                    for (size_t i = 0; valid && i < shards[s].capacity; i++) {
+                        if (slots[i].uid != 0) {
+                            valid = slots[i].uid < header.count && slots[i].storage == storage[slots[i].uid];
+                            used++;
+                        }
+                    }
+                    valid = valid && used == shards[s].count;
+                    total += used;
+                }
+                valid = valid && total == header.count - 1;
+            }
+            if (!valid) {
+                releaseSnapshot();
+                return false;
+            }
+
+            // Shard locks are always taken before the store lock, like Translate.
+            std::unique_lock<std::shared_mutex> shardLocks[ShardCount];
+            for (size_t s = 0; s < ShardCount; s++) {
+                shardLocks[s] = lock(m_shards[s].lock);
+            }
+            auto storeLock = lock(m_storeLock);
+            delete[] m_pages[0];
+            m_pages.Grow(header.pageCount);
+            for (size_t i = 0; i < header.pageCount; i++) {
+                m_pages[i] = base + pageOffsets[i];
+            }
+            m_pageCount = header.pageCount;
+            m_snapshotPages = header.pageCount;
+            m_storage.Adopt((storage_t*)(base + header.storageOffset), Segments<storage_t, 10>::Fit(header.count));
+            m_storageEnd = header.storageEnd;
+
+            for (size_t s = 0; s < ShardCount; s++) {
+                auto& shard = m_shards[s];
+                if (sameShards) {
+                    if (shard.owned) {
+                        delete[] shard.slots;
+                    }
+                    shard.slots = (Slot*)(base + shards[s].offset);
+                    shard.capacity = shards[s].capacity;
+                    shard.count = shards[s].count;
+                    shard.owned = false;
+                }
+            }
+            if (!sameShards) {
+                for (id_t uid = 1; uid < header.count; uid++) {
+                    auto chars = std::string_view(LookupChars(uid));
+                    auto hash = Hash(chars);
+                    auto& shard = shardOf(hash);
+                    shard.slots[find(shard, chars, hash)] = Slot{hash, m_storage[uid], uid};
+                    shard.count++;
+                    if (shard.count * 2 > shard.capacity) {
+                        rehash(shard, shard.capacity << 1);
+                    }
+                }
+            }
+            m_count.store(header.count, std::memory_order_release);
+
+            return true;
+        }
+
+    private:
+        // Sections of a snapshot start on 8 byte boundaries.
+        static constexpr uint64_t snapshotAlign(uint64_t offset) noexcept {
+            return (offset + 7) & ~uint64_t(7);
+        }
+
+        // Returns the size of the page, larger than the page size when it holds one large identifier.
+        size_t pageSizeOf(size_t pageIndex) const noexcept {
+            auto n = strlen(m_pages[pageIndex]) + 1;
+            return n > m_pageSize ? n : m_pageSize;
+        }
+
+        // Maps the snapshot file into memory, or reads it into one allocation when mapping isn't available.
+        bool openSnapshot(const char* path) {
+        #if defined(__unix__) || defined(__APPLE__)
+            auto fd = ::open(path, O_RDONLY);
+            if (fd < 0) {
+                return false;
+            }
+            struct stat info;
+            if (::fstat(fd, &info) != 0 || info.st_size <= 0) {
+                ::close(fd);
+                return false;
+            }
+            auto data = ::mmap(nullptr, size_t(info.st_size), PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+            ::close(fd);
+            if (data == MAP_FAILED) {
+                return false;
+            }
+            m_snapshot = data;
+            m_snapshotSize = size_t(info.st_size);
+            m_snapshotMapped = true;
+            return true;
+        #else
+            auto file = std::fopen(path, "rb");
+            if (file == nullptr) {
+                return false;
+            }
+            std::fseek(file, 0, SEEK_END);
+            auto size = std::ftell(file);
+            std::fseek(file, 0, SEEK_SET);
+            if (size <= 0) {
+                std::fclose(file);
+                return false;
+            }
+            auto data = new uint64_t[(size_t(size) + 7) / 8];
+            auto read = std::fread(data, 1, size_t(size), file);
+            std::fclose(file);
+            if (read != size_t(size)) {
+                delete[] data;
+                return false;
+            }
+            m_snapshot = data;
+            m_snapshotSize = size_t(size);
+            m_snapshotMapped = false;
+            return true;
+        #endif
+        }
+
+        // Unmaps or frees the loaded snapshot.
+        void releaseSnapshot() {
+            if (m_snapshot == nullptr) {
+                return;
+            }
+        #if defined(__unix__) || defined(__APPLE__)
+            if (m_snapshotMapped) {
+                ::munmap(m_snapshot, m_snapshotSize);
+            } else {
+                delete[] (uint64_t*)m_snapshot;
+            }
+        #else
+            delete[] (uint64_t*)m_snapshot;
+        #endif
+            m_snapshot = nullptr;
+            m_snapshotSize = 0;
+        }
+
+        // Locks the mutex when in concurrent mode.
+        template<typename M>
+        inline std::unique_lock<M> lock(M& mutex) const {
+            auto l = std::unique_lock<M>(mutex, std::defer_lock);
+            if (m_concurrent) {
+                l.lock();
+            }
+            return l;
+        }
+        // Locks the mutex for reading when in concurrent mode.
+        inline std::shared_lock<std::shared_mutex> lockShared(std::shared_mutex& mutex) const {
+            auto l = std::shared_lock<std::shared_mutex>(mutex, std::defer_lock);
+            if (m_concurrent) {
+                l.lock();
+            }
+            return l;
+        }
+
+        // Returns the shard for the given hash. The high bits pick the shard
+        // and the low bits pick the slot within it.
+        inline Shard& shardOf(uint32_t hash) noexcept {
+            return m_shards[ShardPower == 0 ? 0 : hash >> (32 - ShardPower)];
+        }
+        inline const Shard& shardOf(uint32_t hash) const noexcept {
+            return m_shards[ShardPower == 0 ? 0 : hash >> (32 - ShardPower)];
+        }
+
+        // Returns the character data at the given storage location.
+        inline const char* charsAt(storage_t storage) const noexcept {
+            return m_pages[storage >> m_pagePower] + (storage & m_pageMask);
+        }
+
+        // Returns the slot index in the shard where the given chars are stored, or the empty
+        // slot where they would be placed.
+        size_t find(const Shard& shard, std::string_view chars, uint32_t hash) const noexcept {
+            auto mask = shard.capacity - 1;
+            auto i = hash & mask;
+            while (true) {
+                auto& slot = shard.slots[i];
+                if (slot.uid == 0) {
+                    return i;
+                }
+                if (slot.hash == hash) {
+                    auto stored = charsAt(slot.storage);
+                    if (strncmp(stored, chars.data(), chars.size()) == 0 && stored[chars.size()] == '\0') {
+                        return i;
+                    }
+                }
+                i = (i + 1) & mask;
+            }
+        }
+
+        // Rebuilds the shard index with the given capacity (a power of 2). The hashes are
+        // kept in the slots so character data is never rehashed.
+        void rehash(Shard& shard, size_t capacity) {
+            auto previous = shard.slots;
+            auto previousCapacity = shard.capacity;
+            shard.slots = new Slot[capacity]();
+            shard.capacity = capacity;
+            auto mask = capacity - 1;
+            for (size_t k = 0; k < previousCapacity; k++) {
+                auto& slot = previous[k];
+                if (slot.uid != 0) {
+                    auto i = slot.hash & mask;
+                    while (shard.slots[i].uid != 0) {
+                        i = (i + 1) & mask;
+                    }
+                    shard.slots[i] = slot;
+                }
+            }
+            if (shard.owned) {
+                delete[] previous;
+            }
+            shard.owned = true;
+        }
+
+        // Allocates a page of the given size at the end of the pages.
+        void addPage(size_t pageSize) {
+            m_pages.Grow(m_pageCount + 1);
+            // Zeroed so unused page space is saved to snapshots the same way every time.
+            m_pages[m_pageCount] = new char[pageSize]();
+            m_pageCount++;
+        }
+
+        // Copies the chars and a terminating character into the pages and returns where they're stored.
+        storage_t store(std::string_view chars) {
+            // Include the terminating character
+            auto n = chars.size() + 1;
+            // Where the new end would be.
+            auto end = m_storageEnd + n;
+            // Where the max end is based on the pages allocated.
+            auto pageEnd = m_pageCount * m_pageSize;
+            // Do we need another page?
+            if (end > pageEnd) {
+                // This is required if they have an identifier over the page size.
+                // We create a special page size for it to avoid error.
+                auto pageSize = n > m_pageSize ? n : m_pageSize;
+
+                addPage(pageSize);
+                m_storageEnd = pageEnd;
+            }
+            // Which page?
+            auto pageIndex = m_storageEnd >> m_pagePower;
+            // How many characters into the page?
+            auto pageOffset = m_storageEnd & m_pageMask;
+            // The location in memory to the start of the page.
+            auto page = (char*)m_pages[pageIndex];
+            // The location in memory of where the character data will be stored.
+            auto pagePtr = page + pageOffset;
+            // Copy the data into character storage.
+            memcpy(pagePtr, chars.data(), chars.size());
+            pagePtr[chars.size()] = '\0';
+
+            auto storage = m_storageEnd;
+
+            // Move the place to store the next identifier to after this one.
+            // We compare n to page size in the event the identifier is larger. 
+            // We store really large identifiers in a custom page size.
+            m_storageEnd += n > m_pageSize ? m_pageSize : n;
+
+            return storage;
+        }
     };
 
     // Stores the character data.
-    Memory memory(PAGE_POWER);
+    Memory memory(PAGE_POWER, MEMORY_CONCURRENT);
     
     // An identifier simply holds an integer which uniquely identifies it.
     // It can be constructed from a constant or a string. There are utility
@@ -190,13 +857,15 @@ namespace id {
         id_t uid;
 
         // Creates an identifier to an empty set of chars
-        Identifier(): uid(0) {}
+        constexpr Identifier(): uid(0) {}
         // Creates an identifier with a known unique id.
-        Identifier(id_t u): uid(u) {}
+        constexpr Identifier(id_t u): uid(u) {}
         // Creates an identifier given `const char*`, generating one and saving this data if required.
         Identifier(const char* chars): uid(memory.Translate(chars)) {} 
         // Creates an identifier given `std::string`, generating one and saving this data if required.
         Identifier(const std::string& str): uid(memory.Translate(str)) {}
+        // Creates an identifier given `std::string_view`, generating one and saving this data if required.
+        Identifier(std::string_view chars): uid(memory.Translate(chars)) {}
 
         // Returns the chars for this identifier.
         inline const char* Chars() const noexcept { return memory.LookupChars(uid); }
@@ -242,7 +911,9 @@ namespace id {
         // Creates an identifier given `const char*`, generating one and saving this data if required.
         IdentifierMaybe(const char* chars): uid(memory.Peek(chars)) {} 
         // Creates an identifier given `std::string`, generating one and saving this data if required.
-        IdentifierMaybe(const std::string& str): uid(memory.Peek(str.c_str())) {}
+        IdentifierMaybe(const std::string& str): uid(memory.Peek(str)) {}
+        // Creates an identifier given `std::string_view` if it exists.
+        IdentifierMaybe(std::string_view chars): uid(memory.Peek(chars)) {}
 
         // If this points to an already defined identifier
         constexpr bool Exists() const noexcept { return uid != -1; }
@@ -273,10 +944,45 @@ namespace id {
         }
     };
 
+    // Character data known at compile time, used to make identifier literals.
+    template<size_t N>
+    struct Literal {
+        char chars[N];
+        // The hash of the characters (without the terminator) computed at compile time.
+        uint32_t hash;
+
+        consteval Literal(const char (&str)[N]): chars(), hash(0) {
+            for (size_t i = 0; i < N; i++) {
+                chars[i] = str[i];
+            }
+            hash = Hash(View());
+        }
+
+        // Returns the characters without the terminator.
+        constexpr std::string_view View() const noexcept { return std::string_view(chars, N - 1); }
+    };
+
+    // The identifier for a literal. The characters are hashed at compile time and the uid
+    // is resolved once on first use, every use after that is a load of a static.
+    template<Literal L>
+    inline Identifier Static() {
+        static const id_t uid = memory.Translate(L.View(), L.hash);
+        return Identifier(uid);
+    }
+
+    namespace literals {
+        // An identifier literal, ie. `"Speed"_id`, which is like `Identifier("Speed")` except no
+        // hashing or lookup is done after the first time the literal is used. This is the way to
+        // use identifiers known at compile time in hot code instead of caching them in statics.
+        template<Literal L>
+        inline Identifier operator""_id() {
+            return Static<L>();
+        }
+    }
+
     // Quick access to all defined identifiers.
     auto Memory::All() {
-        return m_ids | 
-            std::views::values | 
+        return std::views::iota(id_t(0), Count()) | 
             std::views::transform(
                 [](const id_t& uid) -> Identifier { 
                     return Identifier(uid); 
@@ -300,19 +1006,24 @@ namespace id {
     class Area {
         // A translation from to tos where the from is the index into the vector.
         std::vector<To> m_tos;
+        // The reverse translation, the from of each to where to - 1 is the index into the vector.
+        // A to is a hole when its from no longer translates back to it (see Release).
+        std::vector<From> m_froms;
         // The next to (area id)
         To m_next;
+        // The number of tos released and waiting for Compact.
+        To m_holes;
         // When we need to grow the internal translation buffer, how far should we go beyond the last request to reduce
         // to much resizing.
         size_t m_resizeBuffer;
 
     public:
         // Creates an area the grows only as much as it needs to and takes the minimum amount of memory.
-        Area(): m_resizeBuffer(0), m_tos(0), m_next(0) {}
+        Area(): m_resizeBuffer(0), m_tos(0), m_next(0), m_holes(0) {}
         // Creates an area with the given grow power and an initial capacity of 1^growPower.
-        Area(size_t resizeBuffer): m_resizeBuffer(resizeBuffer), m_tos(resizeBuffer), m_next(0) {}
+        Area(size_t resizeBuffer): m_resizeBuffer(resizeBuffer), m_tos(resizeBuffer), m_next(0), m_holes(0) {}
         // Creates an area with the given grow power & override initial capacity.
-        Area(size_t resizeBuffer, size_t initialCapacity): m_resizeBuffer(resizeBuffer), m_tos(initialCapacity), m_next(0) {}
+        Area(size_t resizeBuffer, size_t initialCapacity): m_resizeBuffer(resizeBuffer), m_tos(initialCapacity), m_next(0), m_holes(0) {}
         
         // Returns or generates the area id for the given unique id.
         To Translate(From from) {
@@ -322,6 +1033,7 @@ namespace id {
             }
             if (m_tos[from] == 0) {
                 m_tos[from] = ++m_next;
+                m_froms.push_back(from);
             }
             return m_tos[from] - 1;
         }
@@ -333,14 +1045,23 @@ namespace id {
         inline int Peek(From from) const noexcept {
             return int(from) < m_tos.size() ? int(m_tos[from]) - 1 : -1;
         }
+        // Returns the unique id translated to the given area id, the area id must be below End and not a hole.
+        inline From Reverse(To to) const noexcept {
+            return m_froms[to];
+        }
+        // Returns true if the area id was released and is waiting for Compact.
+        inline bool IsHole(To to) const noexcept {
+            return m_tos[m_froms[to]] != to + 1;
+        }
         // Removes the From from the area, optionally maintaining the order
         // of the translation vector.
         // If order needs to be maintained:
         // - After this operation all tos > the the to mapped to the given from
-        //   will have their tos be decreased by 1.
+        //   will have their tos be decreased by 1. This is O(n) where n is 
+        //   the number of tos after the removed one.
         // If order does not need to be maintained:
         // - After this operation only the returned to will need to will
-        //   be what was removed infavor of the from.
+        //   be what was removed infavor of the from. This is O(1).
         // If we didn't remove anything then -1 is returned.
         int Remove(From from, bool maintainOrder) {
             if (from >= m_tos.size() || m_tos[from] == 0) {
@@ -350,38 +1071,79 @@ namespace id {
             auto removedTo = m_tos[from];
             m_tos[from] = 0;
 
-            if (removedTo == m_next) {
-                return int(removedTo) - 1;
-            }
-
             if (maintainOrder) {
-                for (auto& to : m_tos) {
-                    if (to > removedTo) {
-                        to--;
+                for (size_t i = removedTo; i <= m_next; i++) {
+                    auto moved = m_froms[i];
+                    if (m_tos[moved] == i + 1) {
+                        m_tos[moved]--;
                     }
+                    m_froms[i - 1] = moved;
                 }
-            } else {
-                for (int i = m_tos.size() - 1; i >= 0; --i) {
-                    if (m_tos[i] == m_next) {
-                        m_tos[i] = removedTo;
-                        break;
-                    }
+            } else if (removedTo != m_next + 1) {
+                // The last to takes the place of the removed one.
+                auto moved = m_froms[m_next];
+                if (m_tos[moved] == m_next + 1) {
+                    m_tos[moved] = removedTo;
                 }
+                m_froms[removedTo - 1] = moved;
             }
+            m_froms.pop_back();
+
             return int(removedTo) - 1;
         }
+        // Removes the From from the area without changing any other tos. The returned to 
+        // becomes a hole until Compact is called, which keeps it for as long as the caller
+        // needs to keep data for it. If we didn't remove anything then -1 is returned.
+        int Release(From from) {
+            if (from >= m_tos.size() || m_tos[from] == 0) {
+                return -1;
+            }
+            auto releasedTo = m_tos[from];
+            m_tos[from] = 0;
+            m_holes++;
+            return int(releasedTo) - 1;
+        }
+        // Removes all holes left by Release while maintaining the order of the tos.
+        // A caller with data for each to can pack it the same way by keeping what
+        // isn't a hole before calling this. This is O(n) where n is End.
+        void Compact() noexcept {
+            if (m_holes == 0) {
+                return;
+            }
+            To kept = 0;
+            for (size_t i = 0; i < m_next; i++) {
+                auto from = m_froms[i];
+                if (m_tos[from] == i + 1) {
+                    m_tos[from] = ++kept;
+                    m_froms[kept - 1] = from;
+                }
+            }
+            m_froms.resize(kept);
+            m_next = kept;
+            m_holes = 0;
+        }
         // Clears out the area.
         void Clear() noexcept {
             m_tos.clear();
+            m_froms.clear();
             m_next = 0;
+            m_holes = 0;
         }
         // Returns the number of ids in this area.
         auto Size() const noexcept {
-            return m_tos.size();
+            return size_t(m_next - m_holes);
+        }
+        // Returns the number of tos including holes, every to is below this.
+        auto End() const noexcept {
+            return size_t(m_next);
+        }
+        // Returns the number of holes waiting for Compact.
+        auto Holes() const noexcept {
+            return size_t(m_holes);
         }
         // Returns true if there are no ids in this area.
         auto Empty() const noexcept {
-            return m_tos.empty();
+            return Size() == 0;
         } 
     };
 
@@ -513,35 +1275,145 @@ namespace id {
     template<typename V>
     using SparseMap32 = SparseMap<V, uint32_t>;
 
+    // The translation shared by dense containers from identifiers to local ids (indices into
+    // the container's contiguous data). It optionally translates through an area first,
+    // and it tracks the holes left by Release so containers can remove in order lazily.
+    template<typename aid_t, typename lid_t>
+    class DenseIndex {
+        // An area to use for translation, otherwise use the raw unique id as the id into the local area.
+        // If no area is specified and there are many identifiers in the system then a dense container
+        // may have a local area the size of the number of identifiers defined.
+        Area<id_t, aid_t>* m_area;
+        // A local area that maps area/unique ids to an index into the container's data.
+        Area<aid_t, lid_t> m_local;
+
+    public:
+        // Creates an index that can grow based on the number of global identifiers.
+        DenseIndex(): m_area(nullptr), m_local(0) {}
+        // Creates an index that can grow based on the number of identifiers in the given area.
+        DenseIndex(Area<id_t, aid_t>* area): m_area(area), m_local(0) {}
+
+        // Returns the local id of the identifier or -1 if it isn't in the index.
+        int Peek(IdentifierMaybe id) const noexcept {
+            if (!id.Exists()) {
+                return -1;
+            }
+            auto areaID = m_area == nullptr ? id.uid : m_area->Peek(id.uid);
+            if (areaID < 0) {
+                return -1;
+            }
+            return m_local.Peek(areaID);
+        }
+        // Returns or generates the local id of the identifier. When generated it's equal to the
+        // value End returned before this call and the container needs to add data for it.
+        size_t Translate(Identifier id) {
+            auto areaID = m_area == nullptr ? id.uid : m_area->Translate(id.uid);
+            return m_local.Translate(areaID);
+        }
+        // Removes the identifier, see Area::Remove. Returns the removed local id or -1.
+        int Remove(IdentifierMaybe id, bool maintainOrder) {
+            auto areaID = peekArea(id);
+            return areaID == -1 ? -1 : m_local.Remove(areaID, maintainOrder);
+        }
+        // Removes the identifier leaving a hole, see Area::Release. Returns the released local id or -1.
+        int Release(IdentifierMaybe id) {
+            auto areaID = peekArea(id);
+            return areaID == -1 ? -1 : m_local.Release(areaID);
+        }
+        // Returns true if the local id was released and is waiting for Compact.
+        inline bool IsHole(size_t localID) const noexcept {
+            return m_local.IsHole(localID);
+        }
+        // Returns the area id (or unique id when there's no area) of the local id, it must not be a hole.
+        inline aid_t Reverse(size_t localID) const noexcept {
+            return m_local.Reverse(localID);
+        }
+        // Removes the holes left by Release while maintaining order. For every local id that's kept
+        // and has a new place move(from, to) is called so the container can move its data, 
+        // and the number of local ids kept is returned.
+        template<typename Move>
+        size_t Compact(Move&& move) {
+            if (m_local.Holes() == 0) {
+                return m_local.End();
+            }
+            size_t kept = 0;
+            for (size_t i = 0; i < m_local.End(); i++) {
+                if (!m_local.IsHole(i)) {
+                    if (kept != i) {
+                        move(i, kept);
+                    }
+                    kept++;
+                }
+            }
+            m_local.Compact();
+            return kept;
+        }
+        // Clears every identifier from the index.
+        void Clear() noexcept {
+            m_local.Clear();
+        }
+        // Returns the number of identifiers in the index.
+        inline size_t Size() const noexcept { return m_local.Size(); }
+        // Returns the number of local ids including holes, the size of the container's data.
+        inline size_t End() const noexcept { return m_local.End(); }
+        // Returns whether any holes are waiting for Compact.
+        inline bool NeedsCompact() const noexcept { return m_local.Holes() != 0; }
+
+    private:
+        int peekArea(IdentifierMaybe id) const noexcept {
+            if (!id.Exists()) {
+                return -1;
+            }
+            return m_area == nullptr ? id.uid : m_area->Peek(id.uid);
+        }
+    };
+
     // A dense map has all values stored in initial set order in contiguous memory.
     // It achieves this by having its own local area where it translates unique/area ids
     // to local ids (index into the values vector). When you need to store your data close
     // together and iterate only over the set values this is the map to use.
     // Identifiers can be removed from this map, and optionally the order can be maintained
     // or it does not matter. A remove operation where order doesn't matter is O(1) where
-    // a remove operation where order needs to be preserved is O(n) where n is the size
-    // of the map.
-    template<typename V, typename aid_t, typename lid_t>
+    // a remove operation where order needs to be preserved is O(n) where n is the number
+    // of values after the removed one. When many removes need to preserve order use RemoveLater
+    // which is O(1) and Compact once after them.
+    // A keyed dense map also keeps the key of every value in a parallel vector, so keys & values
+    // can be iterated together without any lookups (see Keys & Pairs).
+    template<typename V, typename aid_t, typename lid_t, bool Keyed = false>
     class DenseMap {
-        // An area to use for translation, otherwise use the raw unique id as the id into the local area.
-        // If no area is specified and there are many identifiers in the system then a dense map
-        // may have a local area the size of the number of identifiers defined.
-        Area<id_t, aid_t>* m_area;
-        // A local area that maps area/unique ids to an index into the values vector.
-        Area<aid_t, lid_t> m_local;
+        // Translates identifiers to the index into the values vector.
+        DenseIndex<aid_t, lid_t> m_index;
         // Where the value data is stored.
         std::vector<V> m_values;
+        // The keys paired with the values when keyed.
+        struct NoKeys {};
+        [[no_unique_address]] std::conditional_t<Keyed, std::vector<Identifier>, NoKeys> m_keys;
 
     public:
         // Creates an empty map that can grow based on the number of global identifiers.
         // The local area will only grow to fit the largest identifier used.
-        DenseMap(): m_area(nullptr), m_local(0), m_values() {}
+        DenseMap(): m_index(), m_values() {}
         // Creates an empty map that can grow based on the number of identifiers in the given area.
         // The local area only grow to fit the largest area id used.
-        DenseMap(Area<id_t, aid_t>* area): m_area(area), m_local(0), m_values() {}
+        DenseMap(Area<id_t, aid_t>* area): m_index(area), m_values() {}
 
         // The values in the map, added in order (unless a remove has been performed that didn't preserve order).
+        // Values removed with RemoveLater are here until Compact, see IsRemoved.
         inline std::vector<V>& Values() { return m_values; }
+        inline const std::vector<V>& Values() const { return m_values; }
+
+        // The keys in the map in the same order as the values.
+        // Keys of values removed with RemoveLater are here until Compact, see IsRemoved.
+        inline std::vector<Identifier>& Keys() requires Keyed { return m_keys; }
+        inline const std::vector<Identifier>& Keys() const requires Keyed { return m_keys; }
+
+        // The keys & values in the map as pairs of an identifier and a reference to the value.
+        // Values removed with RemoveLater are skipped.
+        auto Pairs() requires Keyed {
+            return std::views::iota(size_t(0), m_values.size()) |
+                std::views::filter([this](size_t i) { return !m_index.IsHole(i); }) |
+                std::views::transform([this](size_t i) { return std::pair<Identifier, V&>(m_keys[i], m_values[i]); });
+        }
 
         // Adds or updates the value in the map with the given identifier.
         inline void Set(Identifier id, V value) noexcept {
@@ -555,14 +1427,14 @@ namespace id {
         // Returns the pointer to value in the map set with the identifier.
         // If the identifier was never set or taken then nullptr is returned.
         V* Ptr(IdentifierMaybe id) noexcept {
-            if (!id.Exists()) {
-                return nullptr;
-            }
-            auto areaID = m_area == nullptr ? id.uid : m_area->Peek(id.uid);
-            if (areaID < 0) {
+            auto localID = m_index.Peek(id);
+            if (localID < 0 || localID >= m_values.size()) {
                 return nullptr;
             }
-            auto localID = m_local.Peek(areaID);
+            return &m_values[localID];
+        }
+        const V* Ptr(IdentifierMaybe id) const noexcept {
+            auto localID = m_index.Peek(id);
             if (localID < 0 || localID >= m_values.size()) {
                 return nullptr;
             }
@@ -571,10 +1443,13 @@ namespace id {
         // Returns or creates and returns the reference to the value with the given identifier.
         // Consider Take a variation on Set.
         V& Take(Identifier id) {
-            auto areaID = m_area == nullptr ? id.uid : m_area->Translate(id.uid);
-            auto localID = m_local.Translate(areaID);
+            PROFILE_ZONE("id::DenseMap::Take")
+            auto localID = m_index.Translate(id);
             if (localID == m_values.size()) {
                 m_values.emplace_back();
+                if constexpr (Keyed) {
+                    m_keys.push_back(id);
+                }
             }
             return m_values[localID];
         }
@@ -582,40 +1457,78 @@ namespace id {
         // If it does not exist false is returned.
         // You can control whether order in the map should be maintained or not.
         // When order should be maintained the operation will take O(n) where n
-        // is the current size of the map. When order does not need to be maintained
-        // it performs O(1).
+        // is the number of values after the removed one. When order does not need 
+        // to be maintained it performs O(1).
         bool Remove(IdentifierMaybe id, bool maintainOrder) {
-            if (!id.Exists()) {
-                return false;
-            }
-            auto areaID = m_area == nullptr ? id.uid : m_area->Peek(id.uid);
-            if (areaID == -1) {
-                return false;
-            }
-            auto localID = m_local.Remove(areaID, maintainOrder);
+            PROFILE_ZONE("id::DenseMap::Remove")
+            auto localID = m_index.Remove(id, maintainOrder);
             if (localID == -1) {
                 return false;
             }
             if (maintainOrder) {
                 m_values.erase(m_values.begin() + localID);
+                if constexpr (Keyed) {
+                    m_keys.erase(m_keys.begin() + localID);
+                }
             } else {
                 m_values[localID] = std::move(m_values.back());
                 m_values.pop_back();
+                if constexpr (Keyed) {
+                    m_keys[localID] = m_keys.back();
+                    m_keys.pop_back();
+                }
             }
             return true;
         }
+        // Removes the value in the map with the given identifier while maintaining order
+        // in O(1). The value is reset and left in Values (see IsRemoved) until Compact
+        // is called, which is best done once at a frame boundary after many removes.
+        // If it does not exist false is returned.
+        bool RemoveLater(IdentifierMaybe id) {
+            auto localID = m_index.Release(id);
+            if (localID == -1) {
+                return false;
+            }
+            m_values[localID] = V();
+            return true;
+        }
+        // Returns true if the value at the given index in Values was removed with RemoveLater
+        // and is waiting for Compact.
+        inline bool IsRemoved(size_t index) const noexcept {
+            return m_index.IsHole(index);
+        }
+        // Returns whether any values removed with RemoveLater are waiting for Compact.
+        inline bool NeedsCompact() const noexcept {
+            return m_index.NeedsCompact();
+        }
+        // Packs the values left by RemoveLater in one pass, maintaining their order.
+        void Compact() {
+            auto kept = m_index.Compact([this](size_t from, size_t to) {
+                m_values[to] = std::move(m_values[from]);
+                if constexpr (Keyed) {
+                    m_keys[to] = m_keys[from];
+                }
+            });
+            m_values.resize(kept);
+            if constexpr (Keyed) {
+                m_keys.resize(kept);
+            }
+        }
         // Clears all values from this map.
         void Clear() noexcept {
-            m_local.Clear();
+            m_index.Clear();
             m_values.clear();
+            if constexpr (Keyed) {
+                m_keys.clear();
+            }
         }
-        // Returns the number of values in this map.
+        // Returns the number of values in this map, not including values waiting for Compact.
         auto Size() const noexcept {
-            return m_values.size();
+            return m_index.Size();
         }
         // Returns true if there are no values in this map.
         auto Empty() const noexcept {
-            return m_values.empty();
+            return Size() == 0;
         } 
         // Access the reference to the value identified with the characters.
         // Using this may generate the identifier. 
@@ -632,7 +1545,7 @@ namespace id {
             return Take(str);
         }
     
-        // Returns iterators for all the values in the map.
+        // Returns iterators for all the values in the map, including values waiting for Compact.
         auto begin() { return m_values.begin(); }
         auto end()   { return m_values.end(); }
     };
@@ -649,141 +1562,182 @@ namespace id {
     template<typename V>
     using DenseMap32 = DenseMap<V, id_t, uint32_t>;
 
+    // An allocator of memory aligned to the given number of bytes, so vectors of 
+    // values can be loaded with aligned SIMD instructions.
+    template<typename T, size_t Alignment = 64>
+    struct AlignedAllocator {
+        using value_type = T;
 
-    // A dense key map has all keys & values stored in initial set order in contiguous memory.
-    // It achieves this by having its own local area where it translates unique/area ids
-    // to local ids (index into the values vector). When you need to store your data close
-    // together and iterate only over the set values this is the map to use.
-    // Identifiers can be removed from this map, and optionally the order can be maintained
-    // or it does not matter. A remove operation where order doesn't matter is O(1) where
-    // a remove operation where order needs to be preserved is O(n) where n is the size
-    // of the map.
-    template<typename V, typename aid_t, typename lid_t>
-    class DenseKeyMap {
-        // An area to use for translation, otherwise use the raw unique id as the id into the local area.
-        // If no area is specified and there are many identifiers in the system then a dense map
-        // may have a local area the size of the number of identifiers defined.
-        Area<id_t, aid_t>* m_area;
-        // A local area that maps area/unique ids to an index into the values vector.
-        Area<aid_t, lid_t> m_local;
-        // Where the value data is stored.
-        std::vector<V> m_values;
-        // The keys paired with the value
-        std::vector<Identifier> m_keys;
+        template<typename U>
+        struct rebind { using other = AlignedAllocator<U, Alignment>; };
 
-    public:
-        // Creates an empty map that can grow based on the number of global identifiers.
-        // The local area will only grow to fit the largest identifier used.
-        DenseKeyMap(): m_area(nullptr), m_local(0), m_values() {}
-        // Creates an empty map that can grow based on the number of identifiers in the given area.
-        // The local area only grow to fit the largest area id used.
-        DenseKeyMap(Area<id_t, aid_t>* area): m_area(area), m_local(0), m_values() {}
+        AlignedAllocator() noexcept = default;
+        template<typename U>
+        AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept {}
 
-        // The values in the map, added in order (unless a remove has been performed that didn't preserve order).
-        inline std::vector<V>& Values() { return m_values; }
+        T* allocate(size_t n) {
+            return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+        }
+        void deallocate(T* p, size_t n) noexcept {
+            ::operator delete(p, n * sizeof(T), std::align_val_t(Alignment));
+        }
 
-        // The keys in the map, added in order (unless a remove has been performed that didn't preserve order).
-        inline std::vector<Identifier>& Keys() { return m_keys; }
+        template<typename U>
+        bool operator==(const AlignedAllocator<U, Alignment>&) const noexcept { return true; }
+    };
 
-        // Adds or updates the value in the map with the given identifier.
-        inline void Set(Identifier id, V value) noexcept {
-            Take(id) = std::move(value);
+    // A vector with its data aligned for SIMD.
+    template<typename T>
+    using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+    // A dense map that stores the fields of its values in their own contiguous, aligned arrays
+    // (struct of arrays). It's translated like a DenseMap but code that only needs one or two
+    // fields of every value can loop over just those fields with Field<I>().
+    // Removes work like they do in DenseMap.
+    template<typename aid_t, typename lid_t, typename... Fields>
+    class DenseSoAMap {
+        // Translates identifiers to the index into the field arrays.
+        DenseIndex<aid_t, lid_t> m_index;
+        // Every field in its own array.
+        std::tuple<AlignedVector<Fields>...> m_fields;
+
+        static constexpr auto Indices = std::index_sequence_for<Fields...>();
+
+    public:
+        // The type of the field at the given index.
+        template<size_t I>
+        using FieldType = std::tuple_element_t<I, std::tuple<Fields...>>;
+
+        // Creates an empty map that can grow based on the number of global identifiers.
+        DenseSoAMap(): m_index(), m_fields() {}
+        // Creates an empty map that can grow based on the number of identifiers in the given area.
+        DenseSoAMap(Area<id_t, aid_t>* area): m_index(area), m_fields() {}
+
+        // Returns every value of the field at the given index, in the same order as every other field.
+        // Values removed with RemoveLater are here until Compact, see IsRemoved.
+        template<size_t I>
+        inline std::span<FieldType<I>> Field() noexcept { return std::span(std::get<I>(m_fields)); }
+        template<size_t I>
+        inline std::span<const FieldType<I>> Field() const noexcept { return std::span(std::get<I>(m_fields)); }
+
+        // Adds or updates all fields of the value with the given identifier.
+        void Set(Identifier id, Fields... values) {
+            setAll(Take(id), Indices, std::move(values)...);
         }
-        // Returns the value at the given identifier or a value created using the empty constructor if it doesn't exist.
-        inline V Get(IdentifierMaybe id) noexcept {
-            auto p = Ptr(id);
-            return p == nullptr ? V() : *p;
+        // Returns the index of the value with the given identifier into every field, or -1 if it doesn't exist.
+        inline int Index(IdentifierMaybe id) const noexcept {
+            return m_index.Peek(id);
         }
-        // Returns the pointer to value in the map set with the identifier.
-        // If the identifier was never set or taken then nullptr is returned.
-        V* Ptr(IdentifierMaybe id) noexcept {
-            if (!id.Exists()) {
-                return nullptr;
-            }
-            auto areaID = m_area == nullptr ? id.uid : m_area->Peek(id.uid);
-            if (areaID < 0) {
-                return nullptr;
-            }
-            auto localID = m_local.Peek(areaID);
-            if (localID < 0 || localID >= m_values.size()) {
-                return nullptr;
-            }
-            return &m_values[localID];
+        // Returns the pointer to the field of the value with the given identifier or nullptr if it doesn't exist.
+        template<size_t I>
+        FieldType<I>* Ptr(IdentifierMaybe id) noexcept {
+            auto localID = m_index.Peek(id);
+            return localID < 0 ? nullptr : &std::get<I>(m_fields)[localID];
         }
-        // Returns or creates and returns the reference to the value with the given identifier.
-        // Consider Take a variation on Set.
-        V& Take(Identifier id) {
-            auto areaID = m_area == nullptr ? id.uid : m_area->Translate(id.uid);
-            auto localID = m_local.Translate(areaID);
-            if (localID == m_values.size()) {
-                m_values.emplace_back();
-                m_keys.push_back(id);
+        // Returns the field of the value at the given identifier or a value created using the empty constructor if it doesn't exist.
+        template<size_t I>
+        FieldType<I> Get(IdentifierMaybe id) noexcept {
+            auto p = Ptr<I>(id);
+            return p == nullptr ? FieldType<I>() : *p;
+        }
+        // Returns the index of the value with the given identifier into every field, 
+        // adding a value with empty fields if it doesn't exist.
+        size_t Take(Identifier id) {
+            auto localID = m_index.Translate(id);
+            if (localID == size()) {
+                std::apply([](auto&... fields) { (fields.emplace_back(), ...); }, m_fields);
             }
-            return m_values[localID];
+            return localID;
         }
-        // Removes the value in the map with the given identifier.
-        // If it does not exist false is returned.
-        // You can control whether order in the map should be maintained or not.
-        // When order should be maintained the operation will take O(n) where n
-        // is the current size of the map. When order does not need to be maintained
-        // it performs O(1).
+        // Removes the value with the given identifier, see DenseMap::Remove.
         bool Remove(IdentifierMaybe id, bool maintainOrder) {
-            if (!id.Exists()) {
-                return false;
-            }
-            auto areaID = m_area == nullptr ? id.uid : m_area->Peek(id.uid);
-            if (areaID == -1) {
+            auto localID = m_index.Remove(id, maintainOrder);
+            if (localID == -1) {
                 return false;
             }
-            auto localID = m_local.Remove(areaID, maintainOrder);
+            std::apply([localID, maintainOrder](auto&... fields) {
+                auto remove = [localID, maintainOrder](auto& field) {
+                    if (maintainOrder) {
+                        field.erase(field.begin() + localID);
+                    } else {
+                        field[localID] = std::move(field.back());
+                        field.pop_back();
+                    }
+                };
+                (remove(fields), ...);
+            }, m_fields);
+            return true;
+        }
+        // Removes the value with the given identifier in O(1) while maintaining order, see DenseMap::RemoveLater.
+        bool RemoveLater(IdentifierMaybe id) {
+            auto localID = m_index.Release(id);
             if (localID == -1) {
                 return false;
             }
-            if (maintainOrder) {
-                m_values.erase(m_values.begin() + localID);
-                m_keys.erase(m_keys.begin() + localID);
-            } else {
-                m_values[localID] = std::move(m_values.back());
-                m_values.pop_back();
-                m_keys[localID] = m_keys.back();
-                m_keys.pop_back();
-            }
+            std::apply([localID](auto&... fields) { ((fields[localID] = {}), ...); }, m_fields);
             return true;
         }
-        // Clears all keys and values from this map.
+        // Returns true if the value at the given index was removed with RemoveLater and is waiting for Compact.
+        inline bool IsRemoved(size_t index) const noexcept {
+            return m_index.IsHole(index);
+        }
+        // Returns whether any values removed with RemoveLater are waiting for Compact.
+        inline bool NeedsCompact() const noexcept {
+            return m_index.NeedsCompact();
+        }
+        // Packs the values left by RemoveLater in one pass, maintaining their order.
+        void Compact() {
+            auto kept = m_index.Compact([this](size_t from, size_t to) {
+                std::apply([from, to](auto&... fields) { ((fields[to] = std::move(fields[from])), ...); }, m_fields);
+            });
+            std::apply([kept](auto&... fields) { (fields.resize(kept), ...); }, m_fields);
+        }
+        // Clears all values from this map.
         void Clear() noexcept {
-            m_local.Clear();
-            m_values.clear();
-            m_keys.clear();
+            m_index.Clear();
+            std::apply([](auto&... fields) { (fields.clear(), ...); }, m_fields);
+        }
+        // Prepares every field for the given number of values.
+        void Reserve(size_t count) {
+            std::apply([count](auto&... fields) { (fields.reserve(count), ...); }, m_fields);
         }
-        // Returns the number of values in this map.
+        // Returns the number of values in this map, not including values waiting for Compact.
         auto Size() const noexcept {
-            return m_values.size();
+            return m_index.Size();
         }
         // Returns true if there are no values in this map.
         auto Empty() const noexcept {
-            return m_values.empty();
-        } 
-        // Access the reference to the value identified with the characters.
-        // Using this may generate the identifier. 
-        inline V& operator [](const char* chars) {
-            return Take(chars);
+            return Size() == 0;
         }
-        // Access the reference to the value identified with the identifier.
-        inline V& operator [](const Identifier id) {
-            return Take(id);
+
+    private:
+        inline size_t size() const noexcept {
+            return std::get<0>(m_fields).size();
         }
-        // Access the reference to the value identified with the string.
-        // Using this may generate the identifier.
-        inline V& operator [](const std::string& str) {
-            return Take(str);
+        template<size_t... I>
+        inline void setAll(size_t localID, std::index_sequence<I...>, Fields&&... values) {
+            ((std::get<I>(m_fields)[localID] = std::move(values)), ...);
         }
-    
-        // Returns iterators for all the values in the map.
-        auto begin() { return m_values.begin(); }
-        auto end()   { return m_values.end(); }
     };
 
+    // A struct of arrays dense map that can fit no more than 2^8-1 values.
+    template<typename... Fields>
+    using DenseSoAMap8 = DenseSoAMap<id_t, uint8_t, Fields...>;
+
+    // A struct of arrays dense map that can fit no more than 2^16-1 values.
+    template<typename... Fields>
+    using DenseSoAMap16 = DenseSoAMap<id_t, uint16_t, Fields...>;
+
+    // A struct of arrays dense map that can fit no more than 2^32-1 values.
+    template<typename... Fields>
+    using DenseSoAMap32 = DenseSoAMap<id_t, uint32_t, Fields...>;
+
+
+    // A dense key map has all keys & values stored in initial set order in contiguous memory.
+    // It's a keyed DenseMap, see DenseMap.
+    template<typename V, typename aid_t, typename lid_t>
+    using DenseKeyMap = DenseMap<V, aid_t, lid_t, true>;
+
     // A dense key map that can fit no more than 2^8-1 values.
     template<typename V>
     using DenseKeyMap8 = DenseKeyMap<V, id_t, uint8_t>;
@@ -800,6 +1754,8 @@ namespace id {
     // This will potentially grow to the larget identifier added to it (in bits).
     // This is ideal for holding a large number of identifiers and would perform better the longer
     // it exists given that the underlying data can be large if you have a high number of identifiers.
+    // Operations on whole sets (Union, Intersect, Difference, Count, Any) work on many words at a time
+    // with AVX2 or NEON when the compiler targets them, and iteration jumps between set bits.
     class Set {
         // The presence of an identifier in the set is kept track of with a bit.
         std::vector<uint64_t> m_bits;
@@ -819,11 +1775,11 @@ namespace id {
                 m_bits.resize(bitBucket + 1);
             }
             auto bitIndex = id.uid & 63;
-            uint64_t bitShift = 1 << bitIndex;
+            uint64_t bitShift = uint64_t(1) << bitIndex;
             m_bits[bitBucket] |= bitShift;
         }
         // Returns true if the identifier exists in the set.
-        bool Has(IdentifierMaybe id) {
+        bool Has(IdentifierMaybe id) const {
             if (!id.Exists()) {
                 return false;
             }
@@ -832,7 +1788,7 @@ namespace id {
                 return false;
             }
             auto bitIndex = id.uid & 63;
-            uint64_t bitShift = 1 << bitIndex;
+            uint64_t bitShift = uint64_t(1) << bitIndex;
             return (m_bits[bitBucket] & bitShift) != 0;
         }
         // Removes the identifier from the map if it exists.
@@ -845,25 +1801,76 @@ namespace id {
                 return;
             }
             auto bitIndex = id.uid & 63;
-            uint64_t bitMask = ~(1 << bitIndex);
+            uint64_t bitMask = ~(uint64_t(1) << bitIndex);
             m_bits[bitBucket] &= bitMask;
         }
+        // Removes all identifiers from the set, keeping its capacity.
+        void Clear() noexcept {
+            std::fill(m_bits.begin(), m_bits.end(), 0);
+        }
+
+        // Adds all identifiers in the other set to this set.
+        void Union(const Set& other) {
+            if (other.m_bits.size() > m_bits.size()) {
+                m_bits.resize(other.m_bits.size());
+            }
+            orWords(m_bits.data(), other.m_bits.data(), other.m_bits.size());
+        }
+        // Removes all identifiers from this set which are not in the other set.
+        void Intersect(const Set& other) noexcept {
+            auto n = std::min(m_bits.size(), other.m_bits.size());
+            andWords(m_bits.data(), other.m_bits.data(), n);
+            std::fill(m_bits.begin() + n, m_bits.end(), 0);
+        }
+        // Removes all identifiers from this set which are in the other set.
+        void Difference(const Set& other) noexcept {
+            andNotWords(m_bits.data(), other.m_bits.data(), std::min(m_bits.size(), other.m_bits.size()));
+        }
+        // Returns the number of identifiers in the set.
+        size_t Count() const noexcept {
+            return countWords(m_bits.data(), m_bits.size());
+        }
+        // Returns true if there are any identifiers in the set.
+        bool Any() const noexcept {
+            return anyWords(m_bits.data(), m_bits.size());
+        }
+        // Calls fn with every identifier in the set in order.
+        template<typename Fn>
+        void ForEach(Fn&& fn) const {
+            for (size_t i = 0; i < m_bits.size(); i++) {
+                forEachBit(m_bits[i], i, fn);
+            }
+        }
+        // Calls fn in order with every identifier which is in all of the given sets,
+        // without building the intersection.
+        template<typename Fn, typename... Sets>
+        static void IntersectIterate(Fn&& fn, const Set& first, const Sets&... rest) {
+            auto n = std::min({first.m_bits.size(), rest.m_bits.size()...});
+            for (size_t i = 0; i < n; i++) {
+                auto word = (first.m_bits[i] & ... & rest.m_bits[i]);
+                forEachBit(word, i, fn);
+            }
+        }
+
         // Returns iterators for all the identifiers in the set.
         auto begin() { return Iterator(this); }
         auto end()   { return Iterator(-1); }
     private:
+        template<typename Fn>
+        static inline void forEachBit(uint64_t word, size_t wordIndex, Fn& fn) {
+            while (word != 0) {
+                fn(Identifier(id_t((wordIndex << 6) + std::countr_zero(word))));
+                word &= word - 1;
+            }
+        }
         int32_t OnAfter(int32_t index) {
-            auto max = Max();
             uint32_t start = index + 1;
-            if (start > uint32_t(max)) {
+            auto valueIndex = start >> 6;
+            auto valuesMax = m_bits.size();
+            if (valueIndex >= valuesMax) {
                 return -1;
             }
-            auto startIndex = start >> 6;
-            auto startBits = start & 63;
-            auto valueIndex = startIndex;
-            auto value = m_bits[valueIndex];
-            value &= ~((1 << startBits) - 1);
-            auto valuesMax = m_bits.size();
+            auto value = m_bits[valueIndex] & (~uint64_t(0) << (start & 63));
             while (value == 0) {
                 valueIndex++;
                 if (valueIndex == valuesMax) {
@@ -871,37 +1878,123 @@ namespace id {
                 }
                 value = m_bits[valueIndex];
             }
-            auto next = (valueIndex - startIndex) << 6;
-            next += start;
-            next += TrailingZeros(value);
-            next -= startBits;
-            return int32_t(next);
+            return int32_t((valueIndex << 6) + std::countr_zero(value));
         }
         int32_t Max() {
             return (m_bits.size() << 6) - 1;
         }
-        uint32_t TrailingZeros(uint64_t n) {
-            uint32_t bits = 0;
-            uint64_t x = n;
-            if (x) {
-                if (!(x & 0x00000000FFFFFFFF)) { bits += 32; x >>= 32; }
-                if (!(x & 0x000000000000FFFF)) { bits += 16; x >>= 16; }
-                if (!(x & 0x00000000000000FF)) { bits +=  8; x >>=  8; }
-                if (!(x & 0x000000000000000F)) { bits +=  4; x >>=  4; }
-                if (!(x & 0x0000000000000003)) { bits +=  2; x >>=  2; }
-                bits += (x & 1) ^ 1;
-            }
-            return bits;
-        }
         int32_t LastOn() {
             for (int i = m_bits.size() - 1; i >= 0; --i) {
                 auto v = m_bits[i];
                 if (v != 0) {
-                    return int32_t((v << 6) + TrailingZeros(v));
+                    return int32_t((i << 6) + 63 - std::countl_zero(v));
                 }
             }
             return -1;
         }
+
+        // Word operations over whole sets, 4 words at a time with AVX2 or 2 with NEON.
+        static void orWords(uint64_t* a, const uint64_t* b, size_t n) noexcept {
+            size_t i = 0;
+        #if defined(__AVX2__)
+            for (; i + 4 <= n; i += 4) {
+                auto x = _mm256_loadu_si256((const __m256i*)(a + i));
+                auto y = _mm256_loadu_si256((const __m256i*)(b + i));
+                _mm256_storeu_si256((__m256i*)(a + i), _mm256_or_si256(x, y));
+            }
+        #elif defined(__ARM_NEON)
+            for (; i + 2 <= n; i += 2) {
+                vst1q_u64(a + i, vorrq_u64(vld1q_u64(a + i), vld1q_u64(b + i)));
+            }
+        #endif
+            for (; i < n; i++) {
+                a[i] |= b[i];
+            }
+        }
+        static void andWords(uint64_t* a, const uint64_t* b, size_t n) noexcept {
+            size_t i = 0;
+        #if defined(__AVX2__)
+            for (; i + 4 <= n; i += 4) {
+                auto x = _mm256_loadu_si256((const __m256i*)(a + i));
+                auto y = _mm256_loadu_si256((const __m256i*)(b + i));
+                _mm256_storeu_si256((__m256i*)(a + i), _mm256_and_si256(x, y));
+            }
+        #elif defined(__ARM_NEON)
+            for (; i + 2 <= n; i += 2) {
+                vst1q_u64(a + i, vandq_u64(vld1q_u64(a + i), vld1q_u64(b + i)));
+            }
+        #endif
+            for (; i < n; i++) {
+                a[i] &= b[i];
+            }
+        }
+        static void andNotWords(uint64_t* a, const uint64_t* b, size_t n) noexcept {
+            size_t i = 0;
+        #if defined(__AVX2__)
+            for (; i + 4 <= n; i += 4) {
+                auto x = _mm256_loadu_si256((const __m256i*)(a + i));
+                auto y = _mm256_loadu_si256((const __m256i*)(b + i));
+                _mm256_storeu_si256((__m256i*)(a + i), _mm256_andnot_si256(y, x));
+            }
+        #elif defined(__ARM_NEON)
+            for (; i + 2 <= n; i += 2) {
+                vst1q_u64(a + i, vbicq_u64(vld1q_u64(a + i), vld1q_u64(b + i)));
+            }
+        #endif
+            for (; i < n; i++) {
+                a[i] &= ~b[i];
+            }
+        }
+        static size_t countWords(const uint64_t* a, size_t n) noexcept {
+            size_t count = 0;
+            size_t i = 0;
+        #if defined(__AVX2__)
+            // Counts bits in each nibble with a lookup table, then sums the bytes.
+            const auto lookup = _mm256_setr_epi8(0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4, 0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4);
+            const auto low = _mm256_set1_epi8(0x0F);
+            auto sums = _mm256_setzero_si256();
+            for (; i + 4 <= n; i += 4) {
+                auto x = _mm256_loadu_si256((const __m256i*)(a + i));
+                auto bytes = _mm256_add_epi8(
+                    _mm256_shuffle_epi8(lookup, _mm256_and_si256(x, low)),
+                    _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(x, 4), low)));
+                sums = _mm256_add_epi64(sums, _mm256_sad_epu8(bytes, _mm256_setzero_si256()));
+            }
+            count += _mm256_extract_epi64(sums, 0) + _mm256_extract_epi64(sums, 1) + _mm256_extract_epi64(sums, 2) + _mm256_extract_epi64(sums, 3);
+        #elif defined(__ARM_NEON)
+            for (; i + 2 <= n; i += 2) {
+                count += vaddvq_u8(vcntq_u8(vreinterpretq_u8_u64(vld1q_u64(a + i))));
+            }
+        #endif
+            for (; i < n; i++) {
+                count += std::popcount(a[i]);
+            }
+            return count;
+        }
+        static bool anyWords(const uint64_t* a, size_t n) noexcept {
+            size_t i = 0;
+        #if defined(__AVX2__)
+            for (; i + 4 <= n; i += 4) {
+                auto x = _mm256_loadu_si256((const __m256i*)(a + i));
+                if (!_mm256_testz_si256(x, x)) {
+                    return true;
+                }
+            }
+        #elif defined(__ARM_NEON)
+            for (; i + 2 <= n; i += 2) {
+                auto x = vld1q_u64(a + i);
+                if ((vgetq_lane_u64(x, 0) | vgetq_lane_u64(x, 1)) != 0) {
+                    return true;
+                }
+            }
+        #endif
+            for (; i < n; i++) {
+                if (a[i] != 0) {
+                    return true;
+                }
+            }
+            return false;
+        }
         
         struct Iterator {
             using iterator_category = std::forward_iterator_tag;
@@ -927,50 +2020,262 @@ namespace id {
 
     // A unique unordered set of identifiers tailored for a small number of identifiers.
     // The memory usage and performance of this set are relative to the number of unique identifiers in it.
-    class SmallSet {
-        // All identifiers are stored in a vector.
-        std::vector<Identifier> m_ids;
+    // The first N identifiers are stored in the set itself with no allocation, after that they're
+    // stored in a heap array, and both are searched a few at a time with SSE2 or NEON. Once the set
+    // has more than Promote identifiers it becomes a hash table so Has & Remove stay constant time.
+    template<size_t N = 8, size_t Promote = 64>
+    class BasicSmallSet {
+        static_assert(N > 0 && Promote >= N, "A small set needs inline space and can't promote before it's full.");
+
+        // An empty slot in the hash table.
+        static constexpr id_t Vacant = 0xFFFFFFFF;
+
+        // The identifiers when there are no more than N.
+        id_t m_inline[N];
+        // The identifiers when there are more than N, either a list or a hash table.
+        id_t* m_heap;
+        // The number of identifiers in the set.
+        uint32_t m_size;
+        // The number of identifiers the heap list can hold or the number of slots in the hash table.
+        uint32_t m_capacity;
+        // Whether the heap is a hash table.
+        bool m_hashed;
 
     public:
-        // Creates an empty set that can grow based on the number of global identifiers.
-        // The bit set will only grow to fit the largest identifier used.
-        SmallSet(): m_ids() {}
+        // Creates an empty set that doesn't allocate until it has more than N identifiers.
+        BasicSmallSet(): m_heap(nullptr), m_size(0), m_capacity(N), m_hashed(false) {}
+        BasicSmallSet(const BasicSmallSet& other): m_heap(nullptr), m_size(other.m_size), m_capacity(other.m_capacity), m_hashed(other.m_hashed) {
+            if (other.m_heap != nullptr) {
+                m_heap = new id_t[m_capacity];
+                memcpy(m_heap, other.m_heap, m_capacity * sizeof(id_t));
+            } else {
+                memcpy(m_inline, other.m_inline, m_size * sizeof(id_t));
+            }
+        }
+        BasicSmallSet(BasicSmallSet&& other) noexcept: m_heap(other.m_heap), m_size(other.m_size), m_capacity(other.m_capacity), m_hashed(other.m_hashed) {
+            memcpy(m_inline, other.m_inline, (m_heap == nullptr ? m_size : 0) * sizeof(id_t));
+            other.m_heap = nullptr;
+            other.m_size = 0;
+            other.m_capacity = N;
+            other.m_hashed = false;
+        }
+        BasicSmallSet& operator=(BasicSmallSet other) noexcept {
+            std::swap(m_inline, other.m_inline);
+            std::swap(m_heap, other.m_heap);
+            std::swap(m_size, other.m_size);
+            std::swap(m_capacity, other.m_capacity);
+            std::swap(m_hashed, other.m_hashed);
+            return *this;
+        }
+        ~BasicSmallSet() {
+            delete[] m_heap;
+        }
 
         // Adds the given identifier to the set.
         void Add(Identifier id) {
-            if (!Has(id)) {
-                m_ids.push_back(id);
+            if (m_hashed) {
+                if (insertHashed(m_heap, m_capacity, id.uid)) {
+                    m_size++;
+                    if (m_size * 2 > m_capacity) {
+                        rehash(m_capacity * 2);
+                    }
+                }
+                return;
+            }
+            if (findLinear(data(), m_size, id.uid) >= 0) {
+                return;
             }
+            if (m_size == m_capacity) {
+                if (m_size >= Promote) {
+                    rehash(std::bit_ceil(uint32_t(m_size + 1) * 2));
+                    insertHashed(m_heap, m_capacity, id.uid);
+                    m_size++;
+                    return;
+                }
+                growLinear(std::min(m_capacity * 2, uint32_t(Promote)));
+            }
+            data()[m_size++] = id.uid;
         }
         // Returns true if the identifier exists in the set.
-        bool Has(IdentifierMaybe id) {
+        bool Has(IdentifierMaybe id) const noexcept {
             if (!id.Exists()) {
                 return false;
             }
-            for (auto has : m_ids) {
-                if (has.uid == id.uid) {
-                    return true;
-                }
+            if (m_hashed) {
+                return m_heap[findHashed(id.uid)] == id_t(id.uid);
             }
-            return false;
-        }   
+            return findLinear(data(), m_size, id.uid) >= 0;
+        }
         // Removes the identifier from the map if it exists.
-        void Remove(IdentifierMaybe id) {
+        void Remove(IdentifierMaybe id) noexcept {
             if (!id.Exists()) {
                 return;
             }
-            auto itr = m_ids.begin();
-            while (itr != m_ids.end()) {
-                if (itr->uid == id.uid) {
-                    m_ids.erase(itr);
+            if (m_hashed) {
+                removeHashed(id.uid);
+                return;
+            }
+            auto ids = data();
+            auto i = findLinear(ids, m_size, id.uid);
+            if (i >= 0) {
+                ids[i] = ids[--m_size];
+            }
+        }
+        // Removes all identifiers from the set, keeping any memory allocated.
+        void Clear() noexcept {
+            if (m_hashed) {
+                std::fill(m_heap, m_heap + m_capacity, Vacant);
+            }
+            m_size = 0;
+        }
+        // Returns the number of identifiers in the set.
+        inline size_t Size() const noexcept { return m_size; }
+        // Returns true if there are no identifiers in the set.
+        inline bool Empty() const noexcept { return m_size == 0; }
+
+        // Iterates the identifiers in the set, skipping vacant slots when it's a hash table.
+        struct Iterator {
+            using iterator_category = std::forward_iterator_tag;
+            using difference_type   = std::ptrdiff_t;
+            using value_type        = Identifier;
+            using pointer           = Identifier;
+            using reference         = Identifier;
+
+            const id_t* m_current;
+            const id_t* m_end;
+
+            Iterator(const id_t* current, const id_t* end): m_current(current), m_end(end) { skip(); }
+
+            reference operator*() const { return Identifier(*m_current); }
+            pointer operator->() { return Identifier(*m_current); }
+            Iterator& operator++() { m_current++; skip(); return *this; }  
+            Iterator operator++(int) { Iterator tmp = *this; ++(*this); return tmp; }
+            friend bool operator== (const Iterator& a, const Iterator& b) { return a.m_current == b.m_current; };
+            friend bool operator!= (const Iterator& a, const Iterator& b) { return a.m_current != b.m_current; };
+
+        private:
+            inline void skip() noexcept {
+                while (m_current != m_end && *m_current == Vacant) {
+                    m_current++;
+                }
+            }
+        };
+
+        // Returns iterators for all the identifiers in the set.
+        auto begin() const { return Iterator(data(), data() + slots()); }
+        auto end()   const { return Iterator(data() + slots(), data() + slots()); }
+
+    private:
+        inline id_t* data() noexcept { return m_heap == nullptr ? m_inline : m_heap; }
+        inline const id_t* data() const noexcept { return m_heap == nullptr ? m_inline : m_heap; }
+        inline size_t slots() const noexcept { return m_hashed ? m_capacity : m_size; }
+
+        // Returns the index of the uid in the list or -1, comparing 4 at a time with SSE2 or NEON.
+        static int findLinear(const id_t* ids, size_t n, id_t uid) noexcept {
+            size_t i = 0;
+        #if defined(__SSE2__)
+            auto key = _mm_set1_epi32(int(uid));
+            for (; i + 4 <= n; i += 4) {
+                auto equal = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(ids + i)), key);
+                auto mask = _mm_movemask_ps(_mm_castsi128_ps(equal));
+                if (mask != 0) {
+                    return int(i + std::countr_zero(unsigned(mask)));
+                }
+            }
+        #elif defined(__ARM_NEON)
+            auto key = vdupq_n_u32(uid);
+            for (; i + 4 <= n; i += 4) {
+                if (vmaxvq_u32(vceqq_u32(vld1q_u32(ids + i), key)) != 0) {
                     break;
                 }
             }
+        #endif
+            for (; i < n; i++) {
+                if (ids[i] == uid) {
+                    return int(i);
+                }
+            }
+            return -1;
+        }
+
+        // Moves the list to a heap list that can hold the given number of identifiers.
+        void growLinear(uint32_t capacity) {
+            auto heap = new id_t[capacity];
+            memcpy(heap, data(), m_size * sizeof(id_t));
+            delete[] m_heap;
+            m_heap = heap;
+            m_capacity = capacity;
+        }
+
+        // Returns the first slot to look at in a hash table of the given capacity (a power of 2).
+        static inline size_t homeOf(id_t uid, size_t capacity) noexcept {
+            return size_t((uint64_t(uid) * 0x9E3779B97F4A7C15ull) >> (64 - std::countr_zero(capacity)));
+        }
+        // Returns the slot the uid is in, or the vacant slot where it would go.
+        size_t findHashed(id_t uid) const noexcept {
+            auto mask = m_capacity - 1;
+            auto i = homeOf(uid, m_capacity);
+            while (m_heap[i] != Vacant && m_heap[i] != uid) {
+                i = (i + 1) & mask;
+            }
+            return i;
+        }
+        // Adds the uid to the table if it isn't there, and returns whether it was added.
+        static bool insertHashed(id_t* table, size_t capacity, id_t uid) noexcept {
+            auto mask = capacity - 1;
+            auto i = homeOf(uid, capacity);
+            while (table[i] != Vacant) {
+                if (table[i] == uid) {
+                    return false;
+                }
+                i = (i + 1) & mask;
+            }
+            table[i] = uid;
+            return true;
+        }
+        // Removes the uid from the table, moving back any identifiers after it that are
+        // out of place so no tombstones are needed.
+        void removeHashed(id_t uid) noexcept {
+            auto mask = m_capacity - 1;
+            auto hole = findHashed(uid);
+            if (m_heap[hole] == Vacant) {
+                return;
+            }
+            auto i = hole;
+            while (true) {
+                i = (i + 1) & mask;
+                auto moved = m_heap[i];
+                if (moved == Vacant) {
+                    break;
+                }
+                auto home = homeOf(moved, m_capacity);
+                if (((i - home) & mask) >= ((i - hole) & mask)) {
+                    m_heap[hole] = moved;
+                    hole = i;
+                }
+            }
+            m_heap[hole] = Vacant;
+            m_size--;
+        }
+        // Moves the identifiers into a hash table with the given number of slots (a power of 2).
+        void rehash(uint32_t capacity) {
+            auto table = new id_t[capacity];
+            std::fill(table, table + capacity, Vacant);
+            auto ids = data();
+            for (size_t i = 0; i < slots(); i++) {
+                if (ids[i] != Vacant) {
+                    insertHashed(table, capacity, ids[i]);
+                }
+            }
+            delete[] m_heap;
+            m_heap = table;
+            m_capacity = capacity;
+            m_hashed = true;
         }
-        // Returns iterators for all the identifiers in the set.
-        auto begin() { return m_ids.begin(); }
-        auto end()   { return m_ids.end(); }
     };
 
+    // A small set which keeps 8 identifiers without allocating and becomes a hash table past 64.
+    using SmallSet = BasicSmallSet<>;
+
 
 }
\ No newline at end of file
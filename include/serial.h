@@ -0,0 +1,642 @@
+#pragma once
+
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <algorithm>
+
+#include "debug.h"
+#include "types.h"
+
+// The serial namespace writes types::Value graphs into bytes and reads them back, driven by the props and
+// collections defined on each types::Type. Writing goes into a caller provided buffer and never allocates,
+// reading only allocates when the value being read into has to grow (strings, vectors, maps).
+//
+// The encoding of a value of a type is:
+// - A collection is a uint32 count followed by each element, or each key followed by its value for maps.
+// - A std::string or id::Identifier is a uint32 length followed by its characters.
+// - A trivial type is its bytes.
+// - Any other type is each of its stored props in order. Virtual & computed props are not stored.
+//
+// A delta of a value is written against a baseline, the encoding of a value of the same type written before.
+// It only has the stored props which changed since the baseline and is read into a value equal to the baseline:
+// - A type with stored props is a bit per prop followed by the delta of each prop which has its bit set.
+// - A trivial type without stored props is its bytes.
+// - A collection keyed by index is its count, a bit per element it shares with the baseline followed by the delta
+//   of each of those with its bit set, and then the encoding of each element past the baseline's count.
+// - A string, identifier or any other collection is its encoding.
+namespace serial {
+
+    // The count written before the elements of a collection or the characters of a string.
+    using count_type = uint32_t;
+
+    // Returns the address of the prop on the value of the type at data, or nullptr if the prop is not stored.
+    // A field is found by its offset, any other prop by its ref function whose result is kept in held, so the
+    // address stays valid while held is alive even when ref returns a copy.
+    inline void* Address(const types::Type* type, const types::Prop& prop, void* data, types::Value& held) {
+        if (prop.IsField()) {
+            return prop.Address(data);
+        }
+        if (prop.isVirtual || !prop.ref) {
+            return nullptr;
+        }
+        auto parent = types::Value(const_cast<types::Type*>(type), data);
+        held = prop.ref(parent);
+        return held.Data();
+    }
+
+    // Whether the collection has contiguous values keyed by their index, like a vector.
+    inline bool IsIndexed(const types::TypeCollection& c) noexcept {
+        return c.elements && c.resize;
+    }
+
+    // Whether values of the type are its bytes. Identifiers are trivial but are written with their
+    // characters, their uids are only the same in the process which created them.
+    inline bool IsRaw(const types::Type* type) noexcept {
+        return type->IsTrivial() && !type->Is<id::Identifier>();
+    }
+
+    // Sets the characters of a value of the type at data and returns true, if it's a string or an identifier.
+    inline bool Text(const types::Type* type, const void* data, const char** chars, size_t* length) noexcept {
+        if (type->Is<std::string>()) {
+            auto s = static_cast<const std::string*>(data);
+            *chars = s->data();
+            *length = s->size();
+            return true;
+        }
+        if (type->Is<id::Identifier>()) {
+            auto id = static_cast<const id::Identifier*>(data);
+            *chars = id->Empty() ? "" : id->Chars();
+            *length = strlen(*chars);
+            return true;
+        }
+        return false;
+    }
+
+    // Returns whether the type has any props that are stored.
+    inline bool HasStoredProps(const types::Type* type) noexcept {
+        for (auto& prop : type->Props()) {
+            if (prop.IsField() || (!prop.isVirtual && prop.ref)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // The fewest bytes the encoding of a value of the type can take, at least 1. A count in a buffer is checked
+    // against this before anything is allocated for that many values.
+    inline size_t MinSize(const types::Type* type) noexcept {
+        if (type->IsCollection() || type->Is<std::string>() || type->Is<id::Identifier>()) {
+            return sizeof(count_type);
+        }
+        if (type->IsTrivial()) {
+            return std::max(type->Size(), size_t(1));
+        }
+        size_t size = 0;
+        for (auto& prop : type->Props()) {
+            if (prop.IsField() || (!prop.isVirtual && prop.ref)) {
+                size += MinSize(prop.type);
+            }
+        }
+        return std::max(size, size_t(1));
+    }
+
+    // Reads values from a buffer written by a Writer. Once a read runs past the end of the buffer
+    // or finds something it can't read the reader fails and every read after returns false.
+    class Reader {
+    public:
+        Reader(const void* buffer, size_t size) noexcept:
+            m_data(static_cast<const std::byte*>(buffer)), m_size(size), m_position(0), m_failed(false) {}
+
+        constexpr const std::byte* Data() const noexcept { return m_data; }
+        constexpr size_t Size() const noexcept { return m_size; }
+        constexpr size_t Position() const noexcept { return m_position; }
+        constexpr size_t Remaining() const noexcept { return m_size - m_position; }
+        constexpr bool Failed() const noexcept { return m_failed; }
+
+        // Reads the encoding of a value of its type into it.
+        bool Read(types::Value& value) {
+            PROFILE_ZONE("serial::Reader::Read")
+            if (!value.IsValid()) {
+                return fail();
+            }
+            read(value.GetType(), value.Data());
+            return !m_failed;
+        }
+
+        // Reads a delta written with Writer::WriteDelta into a value which equals the delta's baseline.
+        bool ReadDelta(types::Value& value) {
+            PROFILE_ZONE("serial::Reader::ReadDelta")
+            auto changed = take(1);
+            if (changed == nullptr || !value.IsValid()) {
+                return fail();
+            }
+            if (*changed != std::byte{0}) {
+                readDelta(value.GetType(), value.Data());
+            }
+            return !m_failed;
+        }
+
+        // Moves past the encoding of a value of the given type.
+        bool Skip(const types::Type* type) {
+            skip(type);
+            return !m_failed;
+        }
+
+        friend class Writer;
+
+    private:
+        const std::byte* m_data;
+        size_t m_size;
+        size_t m_position;
+        bool m_failed;
+
+        bool fail() noexcept {
+            m_failed = true;
+            return false;
+        }
+
+        const std::byte* take(size_t bytes) noexcept {
+            if (m_failed || Remaining() < bytes) {
+                fail();
+                return nullptr;
+            }
+            auto p = m_data + m_position;
+            m_position += bytes;
+            return p;
+        }
+
+        size_t count() noexcept {
+            auto p = take(sizeof(count_type));
+            if (p == nullptr) {
+                return 0;
+            }
+            count_type c;
+            memcpy(&c, p, sizeof(c));
+            return c;
+        }
+
+        // The bytes for count elements of the given size, or nullptr if the buffer does not have them.
+        const std::byte* take(size_t count, size_t size) noexcept {
+            if (size != 0 && count > Remaining() / size) {
+                fail();
+                return nullptr;
+            }
+            return take(count * size);
+        }
+
+        static void fill(void* context, void* key, void* value) {
+            auto& r = *static_cast<std::pair<Reader*, const types::TypeCollection*>*>(context);
+            r.first->read(r.second->key, key);
+            r.first->read(r.second->value, value);
+        }
+
+        void read(const types::Type* type, void* data) {
+            if (m_failed) {
+                return;
+            }
+            if (type->IsCollection()) {
+                auto& c = *type->Collection();
+                auto n = count();
+                if (IsIndexed(c)) {
+                    auto stride = c.value->Size();
+                    if (IsRaw(c.value)) {
+                        auto values = take(n, stride);
+                        if (values != nullptr && n != 0) {
+                            memcpy(c.resize(data, n), values, n * stride);
+                        } else if (values != nullptr) {
+                            c.resize(data, 0);
+                        }
+                    } else if (n > Remaining() / MinSize(c.value)) {
+                        fail();
+                    } else {
+                        auto first = static_cast<std::byte*>(c.resize(data, n));
+                        for (size_t i = 0; i < n && !m_failed; i++) {
+                            read(c.value, first + i * stride);
+                        }
+                    }
+                } else if (c.insert && c.clear) {
+                    auto context = std::pair<Reader*, const types::TypeCollection*>(this, &c);
+                    c.clear(data);
+                    for (size_t i = 0; i < n && !m_failed; i++) {
+                        c.insert(data, fill, &context);
+                    }
+                } else {
+                    fail();
+                }
+            } else if (type->Is<std::string>()) {
+                auto n = count();
+                auto chars = take(n);
+                if (chars != nullptr) {
+                    static_cast<std::string*>(data)->assign(reinterpret_cast<const char*>(chars), n);
+                }
+            } else if (type->Is<id::Identifier>()) {
+                auto n = count();
+                auto chars = take(n);
+                if (chars != nullptr) {
+                    *static_cast<id::Identifier*>(data) = n == 0 ? id::Identifier() : id::Identifier(std::string_view(reinterpret_cast<const char*>(chars), n));
+                }
+            } else if (type->IsTrivial()) {
+                auto bytes = take(type->Size());
+                if (bytes != nullptr) {
+                    memcpy(data, bytes, type->Size());
+                }
+            } else if (HasStoredProps(type)) {
+                auto& props = type->Props();
+                for (int i = 0; i < props.Size() && !m_failed; i++) {
+                    auto& prop = props.At(i);
+                    auto held = types::Value();
+                    auto p = Address(type, prop, data, held);
+                    if (p != nullptr) {
+                        read(prop.type, p);
+                    }
+                }
+            } else {
+                fail();
+            }
+        }
+
+        void readDelta(const types::Type* type, void* data) {
+            if (m_failed) {
+                return;
+            }
+            if (type->IsCollection()) {
+                auto& c = *type->Collection();
+                if (!IsIndexed(c)) {
+                    read(type, data);
+                    return;
+                }
+                auto n = count();
+                size_t previous = 0;
+                c.elements(data, &previous);
+                auto shared = std::min(n, previous);
+                auto changed = take((shared + 7) / 8);
+                if (changed == nullptr) {
+                    return;
+                }
+                if (n - shared > Remaining() / MinSize(c.value)) {
+                    fail();
+                    return;
+                }
+                auto stride = c.value->Size();
+                auto first = static_cast<std::byte*>(c.resize(data, n));
+                for (size_t i = 0; i < shared && !m_failed; i++) {
+                    if ((std::to_integer<uint8_t>(changed[i / 8]) & (1 << (i % 8))) != 0) {
+                        readDelta(c.value, first + i * stride);
+                    }
+                }
+                for (size_t i = shared; i < n && !m_failed; i++) {
+                    read(c.value, first + i * stride);
+                }
+            } else if (IsRaw(type) && !HasStoredProps(type)) {
+                read(type, data);
+            } else if (IsRaw(type) || (!type->Is<std::string>() && !type->Is<id::Identifier>() && HasStoredProps(type))) {
+                auto& props = type->Props();
+                auto changed = take((props.Size() + 7) / 8);
+                for (int i = 0; changed != nullptr && i < props.Size() && !m_failed; i++) {
+                    if ((std::to_integer<uint8_t>(changed[i / 8]) & (1 << (i % 8))) == 0) {
+                        continue;
+                    }
+                    auto& prop = props.At(i);
+                    auto held = types::Value();
+                    auto p = Address(type, prop, data, held);
+                    if (p == nullptr) {
+                        fail();
+                        return;
+                    }
+                    readDelta(prop.type, p);
+                }
+            } else {
+                read(type, data);
+            }
+        }
+
+        void skip(const types::Type* type) {
+            if (m_failed) {
+                return;
+            }
+            if (type->IsCollection()) {
+                auto& c = *type->Collection();
+                auto n = count();
+                auto indexed = IsIndexed(c);
+                if (indexed && IsRaw(c.value)) {
+                    take(n, c.value->Size());
+                } else {
+                    for (size_t i = 0; i < n && !m_failed; i++) {
+                        if (!indexed) {
+                            skip(c.key);
+                        }
+                        skip(c.value);
+                    }
+                }
+            } else if (type->Is<std::string>() || type->Is<id::Identifier>()) {
+                take(count());
+            } else if (type->IsTrivial()) {
+                take(type->Size());
+            } else if (HasStoredProps(type)) {
+                auto& props = type->Props();
+                for (int i = 0; i < props.Size() && !m_failed; i++) {
+                    auto& prop = props.At(i);
+                    if (prop.IsField() || (!prop.isVirtual && prop.ref)) {
+                        skip(prop.type);
+                    }
+                }
+            } else {
+                fail();
+            }
+        }
+    };
+
+    // Writes values into a buffer given by the caller. Once a write does not fit in the buffer or finds a value
+    // it can't write the writer fails and every write after returns false.
+    class Writer {
+    public:
+        Writer(void* buffer, size_t capacity) noexcept:
+            m_data(static_cast<std::byte*>(buffer)), m_capacity(capacity), m_size(0), m_failed(false) {}
+
+        constexpr const std::byte* Data() const noexcept { return m_data; }
+        constexpr size_t Size() const noexcept { return m_size; }
+        constexpr size_t Capacity() const noexcept { return m_capacity; }
+        constexpr bool Failed() const noexcept { return m_failed; }
+
+        // Starts writing at the beginning of the buffer again.
+        void Reset() noexcept {
+            m_size = 0;
+            m_failed = false;
+        }
+
+        // Writes the encoding of the value.
+        bool Write(types::Value& value) {
+            PROFILE_ZONE("serial::Writer::Write")
+            if (!value.IsValid()) {
+                return fail();
+            }
+            write(value.GetType(), value.Data());
+            return !m_failed;
+        }
+
+        // Writes a byte with whether anything changed followed by the delta of the value against the baseline,
+        // an encoding of a value of the same type.
+        bool WriteDelta(types::Value& value, const void* baseline, size_t baselineSize) {
+            PROFILE_ZONE("serial::Writer::WriteDelta")
+            auto flag = m_size;
+            if (!value.IsValid() || reserve(1) == nullptr) {
+                return fail();
+            }
+            auto base = Reader(baseline, baselineSize);
+            auto changed = delta(value.GetType(), value.Data(), base);
+            if (base.Failed()) {
+                fail();
+            }
+            if (!m_failed) {
+                m_data[flag] = std::byte(changed ? 1 : 0);
+                if (!changed) {
+                    m_size = flag + 1;
+                }
+            }
+            return !m_failed;
+        }
+
+    private:
+        std::byte* m_data;
+        size_t m_capacity;
+        size_t m_size;
+        bool m_failed;
+
+        bool fail() noexcept {
+            m_failed = true;
+            return false;
+        }
+
+        std::byte* reserve(size_t bytes) noexcept {
+            if (m_failed || m_capacity - m_size < bytes) {
+                fail();
+                return nullptr;
+            }
+            auto p = m_data + m_size;
+            m_size += bytes;
+            return p;
+        }
+
+        void bytes(const void* source, size_t size) noexcept {
+            auto p = reserve(size);
+            if (p != nullptr && size != 0) {
+                memcpy(p, source, size);
+            }
+        }
+
+        void count(size_t n) noexcept {
+            auto c = count_type(n);
+            bytes(&c, sizeof(c));
+        }
+
+        // Reserves a bit for each of count things, they start off unset.
+        size_t bits(size_t count) noexcept {
+            auto at = m_size;
+            auto p = reserve((count + 7) / 8);
+            if (p != nullptr) {
+                memset(p, 0, (count + 7) / 8);
+            }
+            return at;
+        }
+
+        void set(size_t bits, size_t i) noexcept {
+            m_data[bits + i / 8] |= std::byte(1 << (i % 8));
+        }
+
+        struct Entries {
+            Writer* writer;
+            const types::TypeCollection* collection;
+            size_t count;
+        };
+
+        static void visit(void* context, void* key, void* value) {
+            auto& e = *static_cast<Entries*>(context);
+            e.writer->write(e.collection->key, key);
+            e.writer->write(e.collection->value, value);
+            e.count++;
+        }
+
+        void write(const types::Type* type, void* data) {
+            if (m_failed) {
+                return;
+            }
+            size_t length = 0;
+            if (type->IsCollection()) {
+                auto& c = *type->Collection();
+                if (IsIndexed(c)) {
+                    size_t n = 0;
+                    auto first = static_cast<std::byte*>(c.elements(data, &n));
+                    auto stride = c.value->Size();
+                    count(n);
+                    if (IsRaw(c.value)) {
+                        bytes(first, n * stride);
+                    } else {
+                        for (size_t i = 0; i < n && !m_failed; i++) {
+                            write(c.value, first + i * stride);
+                        }
+                    }
+                } else if (c.each) {
+                    auto at = m_size;
+                    auto entries = Entries{this, &c, 0};
+                    count(0);
+                    c.each(data, visit, &entries);
+                    if (!m_failed) {
+                        auto n = count_type(entries.count);
+                        memcpy(m_data + at, &n, sizeof(n));
+                    }
+                } else {
+                    fail();
+                }
+            } else if (const char* chars; Text(type, data, &chars, &length)) {
+                count(length);
+                bytes(chars, length);
+            } else if (type->IsTrivial()) {
+                bytes(data, type->Size());
+            } else if (HasStoredProps(type)) {
+                auto& props = type->Props();
+                for (int i = 0; i < props.Size() && !m_failed; i++) {
+                    auto& prop = props.At(i);
+                    auto held = types::Value();
+                    auto p = Address(type, prop, data, held);
+                    if (p != nullptr) {
+                        write(prop.type, p);
+                    }
+                }
+            } else {
+                fail();
+            }
+        }
+
+        // Writes the delta of the value at data against the baseline and returns whether anything changed.
+        // Nothing is left written when nothing changed. The baseline is moved past the value either way.
+        bool delta(const types::Type* type, void* data, Reader& base) {
+            if (m_failed || base.Failed()) {
+                return false;
+            }
+            if (type->IsCollection()) {
+                return deltaCollection(type, data, base);
+            }
+            if (IsRaw(type)) {
+                auto size = type->Size();
+                auto previous = base.take(size);
+                if (previous == nullptr || memcmp(previous, data, size) == 0) {
+                    return false;
+                }
+                if (!HasStoredProps(type)) {
+                    bytes(data, size);
+                    return true;
+                }
+                return deltaProps(type, data, previous, base);
+            }
+            size_t length = 0;
+            if (const char* chars; Text(type, data, &chars, &length)) {
+                auto n = base.count();
+                auto previous = base.take(n);
+                if (previous == nullptr || (n == length && memcmp(previous, chars, n) == 0)) {
+                    return false;
+                }
+                write(type, data);
+                return true;
+            }
+            if (HasStoredProps(type)) {
+                return deltaProps(type, data, nullptr, base);
+            }
+            fail();
+            return false;
+        }
+
+        // The delta of each stored prop. The props of a trivial type are compared against their place in
+        // the previous bytes of the whole value, otherwise they follow one another in the baseline.
+        bool deltaProps(const types::Type* type, void* data, const std::byte* previous, Reader& base) {
+            auto& props = type->Props();
+            auto changes = bits(props.Size());
+            auto changed = false;
+            for (int i = 0; i < props.Size() && !m_failed; i++) {
+                auto& prop = props.At(i);
+                auto held = types::Value();
+                auto p = Address(type, prop, data, held);
+                if (p == nullptr) {
+                    continue;
+                }
+                auto at = m_size;
+                auto propChanged = false;
+                if (previous != nullptr) {
+                    auto offset = static_cast<std::byte*>(p) - static_cast<std::byte*>(data);
+                    if (offset < 0 || size_t(offset) + prop.type->Size() > type->Size()) {
+                        continue;
+                    }
+                    auto field = Reader(previous + offset, type->Size() - offset);
+                    propChanged = delta(prop.type, p, field);
+                } else {
+                    propChanged = delta(prop.type, p, base);
+                }
+                if (propChanged) {
+                    set(changes, i);
+                    changed = true;
+                } else {
+                    m_size = at;
+                }
+            }
+            return changed;
+        }
+
+        bool deltaCollection(const types::Type* type, void* data, Reader& base) {
+            auto& c = *type->Collection();
+            auto start = m_size;
+            if (!IsIndexed(c)) {
+                // Written whole, and only kept if it differs from the baseline.
+                auto from = base.Position();
+                base.skip(type);
+                write(type, data);
+                auto size = m_size - start;
+                auto changed = !base.Failed() && (size != base.Position() - from || memcmp(m_data + start, base.Data() + from, size) != 0);
+                if (!changed) {
+                    m_size = start;
+                }
+                return changed;
+            }
+            size_t n = 0;
+            auto first = static_cast<std::byte*>(c.elements(data, &n));
+            auto stride = c.value->Size();
+            auto trivial = IsRaw(c.value);
+            auto previous = base.count();
+            if (trivial && n == previous) {
+                auto values = base.take(n, stride);
+                if (values == nullptr || n == 0 || memcmp(values, first, n * stride) == 0) {
+                    return false;
+                }
+                base.m_position -= n * stride;
+            }
+            auto shared = std::min(n, previous);
+            count(n);
+            auto changes = bits(shared);
+            auto changed = n != previous;
+            for (size_t i = 0; i < shared && !m_failed; i++) {
+                auto at = m_size;
+                if (delta(c.value, first + i * stride, base)) {
+                    set(changes, i);
+                    changed = true;
+                } else {
+                    m_size = at;
+                }
+            }
+            if (trivial) {
+                base.take(previous - shared, stride);
+            } else {
+                for (size_t i = shared; i < previous && !base.Failed(); i++) {
+                    base.skip(c.value);
+                }
+            }
+            for (size_t i = shared; i < n && !m_failed; i++) {
+                write(c.value, first + i * stride);
+            }
+            if (!changed) {
+                m_size = start;
+            }
+            return changed;
+        }
+    };
+
+}
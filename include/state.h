@@ -15,6 +15,7 @@
 
 #include "debug.h"
 #include "core.h"
+#include "calcs.h"
 
 // The state namespace stores a generic state machine.
 // This state machine can operate fuzzy or finite.
@@ -63,6 +64,10 @@ namespace state {
     template<typename T>
     class MachineDefinition;
 
+    // The results of transition conditions evaluated ahead of time for many instances of a machine definition.
+    template<typename T>
+    class ConditionCache;
+
     // When you define a state machine you define a traits class
     template<typename ID, typename Subject, typename Data, typename Input, typename Options, typename UpdateState, typename Effect>
     struct Types {
@@ -110,7 +115,7 @@ namespace state {
     // Produces a condition that's only true when all conditions are true
     template<typename condition_type, typename ...condition_types>
     constexpr auto And(condition_type a, condition_types... b){
-        return [a, remain = And(b...)](auto value){ return a(value) && remain(value);};
+        return [a, remain = And(b...)](const auto& input, const auto& update){ return a(input, update) && remain(input, update);};
     }
 
     // Produces a condition that's true when any condition is true
@@ -121,18 +126,492 @@ namespace state {
     // Produces a condition that's true when any condition is true
     template<typename condition_type, typename ...condition_types>
     constexpr auto Or(condition_type a, condition_types... b){
-        return [a, remain = Or(b...)](auto value){ return a(value) || remain(value);};
+        return [a, remain = Or(b...)](const auto& input, const auto& update){ return a(input, update) || remain(input, update);};
     }
 
-    // Produces a condition that's true when all conditions are false
-    template<typename condition_type>
-    constexpr auto Not(condition_type a){
-        return a;
-    }
     // Produces a condition that's true when all conditions are false
     template<typename condition_type, typename ...condition_types>
     constexpr auto Not(condition_type a, condition_types... b){
-        return [a, remain = Not(b...)](auto value){ return !(a(value) || remain(value));};
+        return [any = Or(a, b...)](const auto& input, const auto& update){ return !any(input, update);};
+    }
+
+    // A typed property in user state.
+    template<typename T>
+    struct UserStateProperty {
+        int Index;
+
+        constexpr UserStateProperty(const int i): Index(i) {}
+        constexpr UserStateProperty<T>& operator=(const int i) { Index = i; return *this; }
+    };
+
+    // A general purpose user state object that can be used for the Input or UpdateState types.
+    // You define a class with static UserStateProperty(s) and use that in the first parameters.
+    // You can add speciations for the Get & Set as long as the data type can be converted to and from a float.
+    // ```cpp
+    // struct Input {
+    //    static const inline state::UserStateProperty<bool>  Jump = 0;
+    //    static const inline state::UserStateProperty<float> Speed = 1; // -1=backwards, 0=still, 1=forwards
+    // };
+    // auto u = UserState(2);
+    // auto jumping = u.Get(Input::Jump);
+    // u.Set(Input::Speed, 0.5f);
+    // ```
+    // A UserState tracks which properties were changed by Set since the changes were last taken, and can compare itself
+    // to a copy to find which properties changed since then. Properties are tracked by a bit each in a mask, properties
+    // at index 63 and after share the last bit.
+    // When N > 0 the properties are stored inline in a fixed array of N, so the state never allocates and copies are 
+    // plain copies. UserState (N = 0) stores them in a vector of the given size.
+    template<size_t N>
+    class BasicUserState {
+    public:
+        // No user state
+        BasicUserState(): m_data(), m_changes(0) {}
+
+        // Creates a user state given the number of possible variables.
+        BasicUserState(size_t size): m_data(), m_changes(0) {
+            if constexpr (N == 0) {
+                m_data.resize(size);
+            } else if (size > N) {
+                throw std::invalid_argument("user state size is larger than its fixed capacity");
+            }
+        }
+
+        // Gets the value for the given user state property.
+        template<typename T>
+        inline T Get(UserStateProperty<T> prop) const {
+            if constexpr (std::is_same_v<T, bool>) {
+                return m_data[prop.Index] == 1.0f;
+            } else {
+                return static_cast<T>(m_data[prop.Index]);
+            }
+        }
+
+        // Sets the value for the given user state property.
+        template<typename T>
+        inline void Set(UserStateProperty<T> prop, T value) {
+            if constexpr (std::is_same_v<T, bool>) {
+                set(prop.Index, value ? 1.0f : 0.0f);
+            } else {
+                set(prop.Index, static_cast<float>(value));
+            }
+        }
+
+        // The bit of the property index in a mask of changes.
+        static constexpr uint64_t ChangeBit(int index) noexcept {
+            return uint64_t(1) << std::min(index, 63);
+        }
+        // The number of properties.
+        inline size_t Size() const noexcept { return m_data.size(); }
+        // The values of the properties by index.
+        inline const float* Data() const noexcept { return m_data.data(); }
+        // The mask of properties that changed since the changes were last taken.
+        constexpr uint64_t Changes() const noexcept { return m_changes; }
+        // Returns whether any of the properties in the mask changed since the changes were last taken.
+        constexpr bool Changed(uint64_t properties) const noexcept { return (m_changes & properties) != 0; }
+        // Returns the mask of properties that changed and clears it.
+        uint64_t TakeChanges() noexcept {
+            auto changes = m_changes;
+            m_changes = 0;
+            return changes;
+        }
+        // Returns the mask of properties with a different value than in the given state, or every property if the states
+        // are different sizes. This doesn't touch the changes, so any number of readers can each compare the state to 
+        // the last one they saw.
+        uint64_t Changes(const BasicUserState& since) const noexcept {
+            if (since.Size() != Size()) {
+                return ~uint64_t(0);
+            }
+            auto changes = uint64_t(0);
+            for (size_t i = 0; i < Size(); i++) {
+                if (m_data[i] != since.m_data[i]) {
+                    changes |= ChangeBit(int(i));
+                }
+            }
+            return changes;
+        }
+
+    private:
+        std::conditional_t<N == 0, std::vector<float>, std::array<float, N>> m_data;
+        uint64_t m_changes;
+
+        inline void set(int index, float value) {
+            if (m_data[index] != value) {
+                m_data[index] = value;
+                m_changes |= ChangeBit(index);
+            }
+        }
+    };
+    using UserState = BasicUserState<0>;
+
+    // Whether the type is a BasicUserState of any capacity.
+    template<typename I>
+    constexpr bool IsUserState = false;
+    template<size_t N>
+    constexpr bool IsUserState<BasicUserState<N>> = true;
+
+    // The mask of the given properties, for Transition::Watching & UserState::Changed.
+    template<typename... Ts>
+    constexpr uint64_t Watch(UserStateProperty<Ts>... props) noexcept {
+        return (UserState::ChangeBit(props.Index) | ... | uint64_t(0));
+    }
+
+    // How a property is compared to a value in a compiled condition.
+    enum class Compare : uint8_t { Equal, NotEqual, Less, LessEqual, Greater, GreaterEqual };
+
+    // A compiled condition, kept in two forms. One input is evaluated with a branch per test that jumps to the next
+    // test to run or to the result, so And/Or short circuit and Not costs nothing. A batch of inputs is evaluated with 
+    // the instructions in postfix order, tests push a column of results onto a stack and And/Or/Not replace the top.
+    class Program {
+    public:
+        // The deepest a program's stack can be.
+        static constexpr int MaxDepth = 64;
+        // The number of inputs evaluated together in a batch, see EvalBlock.
+        static constexpr size_t Block = 64;
+        // The most tests a program can have to be evaluated with a table of results, see Eval.
+        static constexpr int TableTests = 12;
+
+        enum class Op : uint8_t { Test, And, Or, Not };
+
+        struct Instruction {
+            Op op;
+            Compare compare;
+            int index;
+            float value;
+        };
+
+        // A test which goes to the onTrue or onFalse branch after, where a branch past the last is the result. Every
+        // comparison is a test of whether the property is in the range [min, max], which is inverted for NotEqual.
+        struct Branch {
+            int index;
+            float min;
+            float max;
+            bool invert;
+            int onTrue;
+            int onFalse;
+        };
+
+        // A program that tests a property against a value.
+        Program(int index, Compare compare, float value):
+            m_code{{Op::Test, compare, index, value}}, m_branches{branch(index, compare, value, 1, 2)}, m_properties{index}, m_watches(UserState::ChangeBit(index)), m_depth(1) {
+            tabulate();
+        }
+
+        // A program which combines the programs with And or Or.
+        static Program Combine(Op op, const std::vector<const Program*>& programs) {
+            auto combined = *programs.front();
+            for (size_t i = 1; i < programs.size(); i++) {
+                auto& next = *programs[i];
+                combined.m_code.insert(combined.m_code.end(), next.m_code.begin(), next.m_code.end());
+                combined.m_code.push_back({op, Compare::Equal, 0, 0.0f});
+                combined.m_watches |= next.m_watches;
+                for (auto index : next.m_properties) {
+                    auto at = std::lower_bound(combined.m_properties.begin(), combined.m_properties.end(), index);
+                    if (at == combined.m_properties.end() || *at != index) {
+                        combined.m_properties.insert(at, index);
+                    }
+                }
+                combined.m_depth = std::max(combined.m_depth, next.m_depth + 1);
+            }
+            if (combined.m_depth > MaxDepth) {
+                throw std::invalid_argument("condition is too deeply nested");
+            }
+            combined.link();
+            return combined;
+        }
+        // A program that's true when the given one is false.
+        Program Negate() const {
+            auto negated = *this;
+            negated.m_code.push_back({Op::Not, Compare::Equal, 0, 0.0f});
+            negated.link();
+            return negated;
+        }
+
+        // Evaluates the program against the input. A program with at most TableTests tests runs every test without a 
+        // branch and looks up the result of that combination, otherwise tests branch and short circuit (see Branch).
+        template<typename Input>
+        bool Eval(const Input& input) const noexcept {
+            auto data = input.Data();
+            auto count = int(m_branches.size());
+            if (!m_table.empty()) {
+                auto results = m_tests.invert;
+                for (int i = 0; i < m_tests.size; i += 4) {
+                    auto index = &m_tests.index[i];
+                    auto value = calc::simd::Set(data[index[0]], data[index[1]], data[index[2]], data[index[3]]);
+                    auto in = calc::simd::And(calc::simd::GreaterEqual(value, calc::simd::Load(&m_tests.min[i])), calc::simd::LessEqual(value, calc::simd::Load(&m_tests.max[i])));
+                    results ^= calc::simd::Bits(in) << i;
+                }
+                return ((m_table[results / 64] >> (results % 64)) & 1) != 0;
+            }
+            auto at = 0;
+            while (at < count) {
+                auto& branch = m_branches[at];
+                auto value = data[branch.index];
+                at = ((value >= branch.min && value <= branch.max) != branch.invert) ? branch.onTrue : branch.onFalse;
+            }
+            return at == count;
+        }
+
+        // Evaluates the program against count inputs, writing 0 or 1 for each to out. Inputs are evaluated a Block at a
+        // time, the properties read are gathered into columns (see Gather) and then evaluated with EvalBlock.
+        template<typename Input>
+        void EvalBatch(const Input* inputs, size_t count, uint8_t* out) const {
+            thread_local std::vector<float> columns;
+            if (columns.size() < Columns()) {
+                columns.resize(Columns());
+            }
+            for (size_t start = 0; start < count; start += Block) {
+                auto n = std::min(Block, count - start);
+                Gather(inputs + start, n, m_properties, columns.data());
+                auto results = EvalBlock(columns.data());
+                for (size_t i = 0; i < n; i++) {
+                    out[start + i] = uint8_t((results >> i) & 1);
+                }
+            }
+        }
+
+        // Copies the properties of up to Block inputs into columns, the values of property p start at columns[p * Block]
+        // and the column is padded with zeros after the last input.
+        template<typename Input>
+        static void Gather(const Input* inputs, size_t count, const std::vector<int>& properties, float* columns) noexcept {
+            for (auto property : properties) {
+                std::fill(columns + property * Block + count, columns + (property + 1) * Block, 0.0f);
+            }
+            for (size_t i = 0; i < count; i++) {
+                auto row = inputs[i].Data();
+                for (auto property : properties) {
+                    columns[property * Block + i] = row[property];
+                }
+            }
+        }
+
+        // Evaluates the program against a Block of inputs gathered into columns (see Gather), returning a bit per input.
+        // The instructions run in postfix order, a test compares 4 values at a time (see calc::simd) and pushes a word
+        // of results onto a stack, then And/Or/Not are one operation each on the top of the stack.
+        uint64_t EvalBlock(const float* columns) const noexcept {
+            uint64_t stack[MaxDepth];
+            // The next free word of the stack, the top is the word before it.
+            auto next = stack;
+            auto test = m_branches.data();
+            for (auto& inst : m_code) {
+                switch (inst.op) {
+                case Op::Test: {
+                    auto values = columns + test->index * Block;
+                    auto min = calc::simd::Splat(test->min);
+                    auto max = calc::simd::Splat(test->max);
+                    auto results = uint64_t(0);
+                    for (size_t i = 0; i < Block; i += 4) {
+                        auto value = calc::simd::Load(&values[i]);
+                        auto in = calc::simd::And(calc::simd::GreaterEqual(value, min), calc::simd::LessEqual(value, max));
+                        results |= uint64_t(calc::simd::Bits(in)) << i;
+                    }
+                    *next++ = test->invert ? ~results : results;
+                    test++;
+                    break;
+                }
+                case Op::And:
+                    next--;
+                    next[-1] &= *next;
+                    break;
+                case Op::Or:
+                    next--;
+                    next[-1] |= *next;
+                    break;
+                case Op::Not:
+                    next[-1] = ~next[-1];
+                    break;
+                }
+            }
+            return stack[0];
+        }
+
+        // The mask of properties the program reads, see Watch.
+        constexpr uint64_t Watches() const noexcept { return m_watches; }
+        // The number of instructions.
+        constexpr size_t Size() const noexcept { return m_code.size(); }
+        // The number of tests.
+        constexpr int Tests() const noexcept { return int(m_branches.size()); }
+        // The deepest the stack gets while evaluating.
+        constexpr int Depth() const noexcept { return m_depth; }
+        // The properties read in order.
+        constexpr auto& Properties() const noexcept { return m_properties; }
+        // The number of floats the columns of a batch need, see Gather.
+        inline size_t Columns() const noexcept { return (m_properties.back() + 1) * Block; }
+        // The instructions in postfix order.
+        constexpr auto& Code() const noexcept { return m_code; }
+        // The branches in the order of the tests.
+        constexpr auto& Branches() const noexcept { return m_branches; }
+
+    private:
+        std::vector<Instruction> m_code;
+        std::vector<Branch> m_branches;
+        // The result of every combination of test results, a bit per combination, when there are at most TableTests.
+        std::vector<uint64_t> m_table;
+        // The tests of a program with a table, the size is rounded up to a multiple of 4 with tests that read the first
+        // property and are always false.
+        struct {
+            int size;
+            int index[TableTests];
+            alignas(16) float min[TableTests];
+            alignas(16) float max[TableTests];
+            uint32_t invert;
+        } m_tests;
+        // The properties read in order.
+        std::vector<int> m_properties;
+        uint64_t m_watches;
+        int m_depth;
+
+        // An instruction with the nodes it operates on.
+        struct Node {
+            int code;
+            int left;
+            int right;
+            int tests;
+        };
+
+        // A branch for the comparison of the property to the value.
+        static Branch branch(int index, Compare compare, float value, int onTrue, int onFalse) noexcept {
+            constexpr auto inf = std::numeric_limits<float>::infinity();
+            constexpr auto nan = std::numeric_limits<float>::quiet_NaN();
+            auto above = value == inf ? nan : std::nextafter(value, inf);
+            auto below = value == -inf ? nan : std::nextafter(value, -inf);
+            switch (compare) {
+            case Compare::Equal:        return Branch{index, value, value, false, onTrue, onFalse};
+            case Compare::NotEqual:     return Branch{index, value, value, true, onTrue, onFalse};
+            case Compare::Less:         return Branch{index, -inf, below, false, onTrue, onFalse};
+            case Compare::LessEqual:    return Branch{index, -inf, value, false, onTrue, onFalse};
+            case Compare::Greater:      return Branch{index, above, inf, false, onTrue, onFalse};
+            case Compare::GreaterEqual: return Branch{index, value, inf, false, onTrue, onFalse};
+            }
+            return Branch{index, nan, nan, false, onTrue, onFalse};
+        }
+        // Builds the branches from the postfix instructions.
+        void link() {
+            auto nodes = std::vector<Node>();
+            auto stack = std::vector<int>();
+            for (int i = 0; i < int(m_code.size()); i++) {
+                auto node = Node{i, -1, -1, 1};
+                if (m_code[i].op == Op::Not) {
+                    node.left = stack.back();
+                    node.tests = nodes[node.left].tests;
+                    stack.pop_back();
+                } else if (m_code[i].op != Op::Test) {
+                    node.right = stack.back();
+                    stack.pop_back();
+                    node.left = stack.back();
+                    stack.pop_back();
+                    node.tests = nodes[node.left].tests + nodes[node.right].tests;
+                }
+                stack.push_back(int(nodes.size()));
+                nodes.push_back(node);
+            }
+            auto tests = nodes[stack.back()].tests;
+            m_branches.resize(tests);
+            link(nodes, stack.back(), 0, tests, tests + 1);
+            tabulate();
+        }
+        // Builds the table of results from the branches, or clears it when there are too many tests.
+        void tabulate() {
+            auto count = int(m_branches.size());
+            m_table.clear();
+            if (count > TableTests) {
+                return;
+            }
+            constexpr auto nan = std::numeric_limits<float>::quiet_NaN();
+            m_tests.size = (count + 3) / 4 * 4;
+            m_tests.invert = 0;
+            for (int i = 0; i < TableTests; i++) {
+                auto& test = m_branches[i < count ? i : 0];
+                m_tests.index[i] = test.index;
+                m_tests.min[i] = i < count ? test.min : nan;
+                m_tests.max[i] = i < count ? test.max : nan;
+                m_tests.invert |= uint32_t(i < count && test.invert) << i;
+            }
+            auto combinations = uint32_t(1) << count;
+            m_table.resize((combinations + 63) / 64);
+            for (uint32_t results = 0; results < combinations; results++) {
+                auto at = 0;
+                while (at < count) {
+                    at = ((results >> at) & 1) != 0 ? m_branches[at].onTrue : m_branches[at].onFalse;
+                }
+                if (at == count) {
+                    m_table[results / 64] |= uint64_t(1) << (results % 64);
+                }
+            }
+        }
+        // Builds the branches of the node, with its first test at the given branch.
+        void link(const std::vector<Node>& nodes, int node, int first, int onTrue, int onFalse) {
+            auto& n = nodes[node];
+            auto& inst = m_code[n.code];
+            auto second = n.left >= 0 ? first + nodes[n.left].tests : first;
+            switch (inst.op) {
+            case Op::Test:
+                m_branches[first] = branch(inst.index, inst.compare, inst.value, onTrue, onFalse);
+                break;
+            case Op::And:
+                link(nodes, n.left, first, second, onFalse);
+                link(nodes, n.right, second, onTrue, onFalse);
+                break;
+            case Op::Or:
+                link(nodes, n.left, first, onTrue, second);
+                link(nodes, n.right, second, onTrue, onFalse);
+                break;
+            case Op::Not:
+                link(nodes, n.left, first, onFalse, onTrue);
+                break;
+            }
+        }
+    };
+
+    // A condition on UserState properties built with When and And/Or/Not that's compiled to a Program. It can be used
+    // anywhere a condition_type can, a MachineDefinition watches the properties it reads (see Transition::Watching) and 
+    // a ConditionCache evaluates it for all inputs at once.
+    class Condition {
+    public:
+        Condition(Program program): m_program(std::make_shared<const Program>(std::move(program))) {}
+
+        // Evaluates the condition against the input.
+        template<size_t N, typename Update>
+        inline bool operator()(const BasicUserState<N>& input, const Update&) const noexcept {
+            return m_program->Eval(input);
+        }
+        // Evaluates the condition against count inputs, writing 0 or 1 for each to out.
+        template<size_t N>
+        inline void EvalBatch(const BasicUserState<N>* inputs, size_t count, uint8_t* out) const {
+            m_program->EvalBatch(inputs, count, out);
+        }
+        // The mask of properties the condition reads.
+        inline uint64_t Watches() const noexcept { return m_program->Watches(); }
+        // The compiled program.
+        inline const Program& GetProgram() const noexcept { return *m_program; }
+
+    private:
+        std::shared_ptr<const Program> m_program;
+    };
+
+    // A condition that's true when the property compares to the value.
+    template<typename T>
+    inline Condition When(UserStateProperty<T> prop, Compare compare, std::type_identity_t<T> value) {
+        return Condition(Program(prop.Index, compare, static_cast<float>(value)));
+    }
+    // A condition that's true when the bool property is true.
+    inline Condition When(UserStateProperty<bool> prop) {
+        return Condition(Program(prop.Index, Compare::Equal, 1.0f));
+    }
+
+    // Produces a compiled condition that's only true when all conditions are true
+    template<typename ...condition_types>
+    inline Condition And(const Condition& a, const condition_types&... b) requires (std::same_as<condition_types, Condition> && ...) {
+        return Condition(Program::Combine(Program::Op::And, {&a.GetProgram(), &b.GetProgram()...}));
+    }
+    // Produces a compiled condition that's true when any condition is true
+    template<typename ...condition_types>
+    inline Condition Or(const Condition& a, const condition_types&... b) requires (std::same_as<condition_types, Condition> && ...) {
+        return Condition(Program::Combine(Program::Op::Or, {&a.GetProgram(), &b.GetProgram()...}));
+    }
+    // Produces a compiled condition that's true when all conditions are false
+    template<typename ...condition_types>
+    inline Condition Not(const Condition& a, const condition_types&... b) requires (std::same_as<condition_types, Condition> && ...) {
+        return Condition(Program::Combine(Program::Op::Or, {&a.GetProgram(), &b.GetProgram()...}).Negate());
     }
 
     // If condition is true, transition from start to end.
@@ -172,7 +651,7 @@ namespace state {
         // The id of the ending state.
         constexpr auto GetEnd() const noexcept { return m_end; }
         // The condition on the transition. This is optional, and when not given it's considered to always return true.
-        constexpr auto GetCondition() const noexcept { return m_condition; }
+        constexpr auto& GetCondition() const noexcept { return m_condition; }
         // The options specified on the transition, to be passed to the start function.
         constexpr const auto& GetOptions() const noexcept { return m_options; }
         // Returns whether this transition is live. A live transition is checked each machine update. A non-live transition
@@ -180,8 +659,19 @@ namespace state {
         constexpr auto IsLive() const noexcept { return m_live; }
         // Evalutes the input and update and returns whether this transition should be done.
         constexpr auto Eval(const input_t& input, const update_t& update) const { return !m_condition || m_condition(input, update); }
+        // Declares the input properties the condition depends on (see Watch), so when the input tracks changes (like UserState)
+        // the last result is reused until one of them changes. The condition should not depend on anything else, including
+        // the update state. 0 means the condition is evaluated every time.
+        Transition<T>& Watching(uint64_t watches) noexcept { m_watches = watches; return *this; }
+        // The input properties the condition depends on, see Watching.
+        constexpr uint64_t GetWatches() const noexcept { return m_watches; }
+        // The index of the transition in the machine definition it was added to, or -1.
+        constexpr int GetIndex() const noexcept { return m_index; }
 
+        friend class MachineDefinition<T>;
     private:
+        uint64_t m_watches = 0;
+        int m_index = -1;
         const bool m_hasStart;
         const id_t m_start; // optional
         const id_t m_end; // end state
@@ -272,8 +762,25 @@ namespace state {
         // A queue of possible states are built on update, but processing isn't typically done until the next update. 
         // This allows you to process the queue right at the end of an update and updates the new active statuses.
         bool ProcessQueueImmediately;
+        // If > 0, the number of active, queued, and applicable states a machine has space for up front. Otherwise
+        // it's the number of states, so machines don't allocate as states come and go.
+        int Capacity;
     };
 
+    // Sorts the range so a is before b when less(a, b), keeping the order of equal elements. It doesn't allocate and
+    // is fast for the few states that are usually sorted.
+    template<typename It, typename Less>
+    void InsertionSort(It begin, It end, Less less) {
+        if (begin == end) {
+            return;
+        }
+        for (auto i = std::next(begin); i != end; i++) {
+            for (auto j = i; j != begin && less(*j, *std::prev(j)); j--) {
+                std::iter_swap(j, std::prev(j));
+            }
+        }
+    }
+
     // Returns the options for a finite state machine.
     template<typename T>
     MachineOptions<T> Finite() {
@@ -324,6 +831,8 @@ namespace state {
         constexpr auto& GetStates() const noexcept { return m_states; }
         // The global transitions (without a specific start) on the machine definition.
         constexpr auto& GetTransitions() const noexcept { return m_transitions; }
+        // The number of transitions added to the machine definition, global and on states.
+        constexpr size_t GetTransitionCount() const noexcept { return m_transitionCount; }
         // Adds a state to the definition.
         constexpr void AddState(Definition<T> state) {
             m_states.push_back(std::move(state));
@@ -352,6 +861,10 @@ namespace state {
             if (GetState(trans.GetEnd()) == nullptr) {
                 throw std::invalid_argument("end state of transition was not defined on the machine");
             } 
+            trans.m_index = m_transitionCount++;
+            if (auto compiled = trans.m_condition.template target<Condition>(); compiled != nullptr && trans.m_watches == 0) {
+                trans.m_watches = compiled->Watches();
+            }
             if (trans.HasStart()) {
                 auto start = GetState(trans.GetStart());
                 if (start == nullptr) {
@@ -366,6 +879,7 @@ namespace state {
     private:
         std::vector<Definition<T>> m_states;
         std::vector<Transition<T>> m_transitions;
+        size_t m_transitionCount = 0;
         const input_t m_initialInput;
         const done_t m_done;
         const start_t m_start;
@@ -373,7 +887,16 @@ namespace state {
         const MachineOptions<T> m_options;
     };
 
+    // An input that can tell which of its properties have changed since a copy of it, see UserState.
+    template<typename I>
+    concept TracksChanges = requires(const I& input) {
+        { input.Changes(input) } -> std::convertible_to<uint64_t>;
+    };
+
     // An instance of a machine for a subject.
+    // When the input tracks changes, a root machine compares the input to a copy of it from its last update and only
+    // re-evaluates the watching transitions (see Transition::Watching) of properties that changed. The input is never
+    // modified, so root machines that share an input each see every change.
     template<typename T>
     class Machine {
         using id_t        = typename T::id_type;
@@ -390,8 +913,32 @@ namespace state {
             m_parent(parent), 
             m_input(parent != nullptr ? parent->m_input : std::make_shared<input_t>(def->GetInitialInput())),
             m_active(),
-            m_activeQueue()
-        {}
+            m_activeQueue(),
+            m_cache(nullptr),
+            m_cacheBase(-1),
+            m_instance(0),
+            m_seen()
+        {
+            if (parent != nullptr && parent->m_cache != nullptr) {
+                SetConditionCache(parent->m_cache, parent->m_instance);
+            }
+            reserve();
+        }
+        // A root machine with the given definition, for the subject, with input that can be shared (see MachineBatch).
+        Machine(const MachineDefinition<T>* def, subject_t& subject, std::shared_ptr<input_t> input):
+            m_def(def), 
+            m_subject(subject), 
+            m_parent(nullptr), 
+            m_input(std::move(input)),
+            m_active(),
+            m_activeQueue(),
+            m_cache(nullptr),
+            m_cacheBase(-1),
+            m_instance(0),
+            m_seen()
+        {
+            reserve();
+        }
 
         // Returns the parent machine instance (if this is not the root machine).
         constexpr const auto GetParent() const noexcept { return m_parent; }
@@ -418,12 +965,21 @@ namespace state {
         void Update(const update_t& update);
         // Applies the applicable states to the subject with the given update state.
         void Apply(const update_t& update);
+        // Has transitions look up their condition results for the instance in the cache while it's valid,
+        // instead of evaluating them. Sub machines use the same cache and instance.
+        void SetConditionCache(const ConditionCache<T>* cache, size_t instance);
 
     private: 
         // Updates all active states.
         void UpdateActive(const update_t& update);
         // Processes the queue of potential active states.
         void ProcessQueue(const update_t& update);
+        // Evaluates the transition with the current input, or returns the cached or last result.
+        bool Eval(const Transition<T>& trans, const update_t& update);
+        // Forgets the last results of transitions watching the changed properties, here and in sub machines.
+        void Changed(uint64_t changes);
+        // Reserves space for the states based on the options, see MachineOptions::Capacity.
+        void reserve();
 
         const Machine<T>* m_parent;
         const MachineDefinition<T>* m_def;
@@ -432,6 +988,14 @@ namespace state {
         std::vector<Active<T>> m_active;
         std::vector<Active<T>> m_activeQueue;
         std::vector<Active<T>*> m_applicable;
+        const ConditionCache<T>* m_cache;
+        // The column of this definition's first transition in the cache.
+        int m_cacheBase;
+        size_t m_instance;
+        // The last result of each watching transition by index: -1 unknown, 0 false, 1 true.
+        std::vector<int8_t> m_evaluated;
+        // The input as of the last update of a root machine, to find which properties changed since.
+        input_t m_seen;
     };
 
     // An instance of a state.
@@ -479,7 +1043,8 @@ namespace state {
         // Iterates through all bottom states connected to this state. A bottom state is
         // one that does not have a sub-machine. This will traverse through all sub machines
         // and return the active states.
-        bool Iterate(std::function<bool(const Active<T>&)> fn) const {
+        template<typename Fn>
+        bool Iterate(Fn&& fn) const {
              if (HasSub()) {
                 for (auto& sub : GetSub()->GetActive()) {
                     if (!sub.Iterate(fn)) {
@@ -532,7 +1097,7 @@ namespace state {
                 continue;
             }
             auto& input = *m_input;
-            if (trans.Eval(input, update)) {
+            if (Eval(trans, update)) {
                 const auto stateDef = m_def->GetState(end);
                 LOG(info, "Machine::Transitions transition to "<<stateDef->GetID())
 
@@ -622,7 +1187,7 @@ namespace state {
                     if (options.ActivePriority) {
                         LOG(info, "Machine::Update sorting with custom priority function.")
 
-                        std::sort(m_activeQueue.begin(), m_activeQueue.end(), options.ActivePriority);
+                        InsertionSort(m_activeQueue.begin(), m_activeQueue.end(), options.ActivePriority);
                     }
                     // Chop off the unwanted states.
                     LOG(info, "Machine::Update chopping off from queue: "<<m_activeQueue.size()-remainingSpace)
@@ -680,7 +1245,7 @@ namespace state {
                 }
 
                 if (done) {
-                    m_active.erase(state);
+                    state = m_active.erase(state);
                 } else {
                     state++;
                 }
@@ -690,9 +1255,21 @@ namespace state {
 
     template<typename T>
     void Machine<T>::Update(const update_t& update) {
+        PROFILE_ZONE("state::Machine::Update")
         // Machine options
         auto& options = m_def->GetOptions();
 
+        // The root machine finds the changes to the input since its last update.
+        if constexpr (TracksChanges<input_t>) {
+            if (m_parent == nullptr) {
+                auto changes = m_input->Changes(m_seen);
+                if (changes != 0) {
+                    Changed(changes);
+                    m_seen = *m_input;
+                }
+            }
+        }
+
         // If not all are not always live, check global transitions
         if (!options.FullyActive) {
             // Do we have any states?
@@ -720,6 +1297,7 @@ namespace state {
 
     template<typename T>
     void Machine<T>::Apply(const update_t& update) {
+        PROFILE_ZONE("state::Machine::Apply")
         // If no active states, exit early.
         if (m_active.empty()) {
             return;
@@ -730,20 +1308,34 @@ namespace state {
 
         // Copy list to avoid affecting order or size of active states.
         m_applicable.clear();
-        for (auto& state : m_active) {
-            m_applicable.push_back(&state);
-        }
-        
-        // If there is a restriction on how many to apply and we are over that, lets sort and reduce it.
+
+        // If there is a restriction on how many to apply and we are over that, keep the first AppliedMax by priority.
         if (options.AppliedMax > 0 && options.AppliedMax < m_active.size()) {
-            // Sort if a priority function was supplied
-            if (options.AppliedPriority) {
-                std::sort(m_applicable.begin(), m_applicable.end(), [cmp = options.AppliedPriority](const Active<T>* a, const Active<T>*b) -> bool {
-                    return cmp(*a, *b);
+            auto& priority = options.AppliedPriority;
+            for (auto& state : m_active) {
+                // Without a priority function the order of the states is used.
+                if (!priority) {
+                    if (m_applicable.size() == options.AppliedMax) {
+                        break;
+                    }
+                    m_applicable.push_back(&state);
+                    continue;
+                }
+                // Insert after states of equal priority, so ties keep the order of the states.
+                auto at = std::upper_bound(m_applicable.begin(), m_applicable.end(), &state, [&priority](const Active<T>* a, const Active<T>* b) -> bool {
+                    return priority(*a, *b);
                 });
+                if (m_applicable.size() < options.AppliedMax) {
+                    m_applicable.insert(at, &state);
+                } else if (at != m_applicable.end()) {
+                    m_applicable.pop_back();
+                    m_applicable.insert(at, &state);
+                }
+            }
+        } else {
+            for (auto& state : m_active) {
+                m_applicable.push_back(&state);
             }
-            // Remove states off back
-            m_applicable.resize(options.AppliedMax);
         }
         
         LOG(debug, "Machine::Applying "<<m_applicable.size()<<" out of "<<m_active.size()<<" active states")
@@ -751,61 +1343,307 @@ namespace state {
         m_def->Apply(m_subject, m_applicable, update);
     }
 
-    // A typed property in user state.
     template<typename T>
-    struct UserStateProperty {
-        int Index;
+    void Machine<T>::reserve() {
+        auto& options = m_def->GetOptions();
+        auto capacity = options.Capacity > 0 ? size_t(options.Capacity) : m_def->GetStates().size();
+        m_active.reserve(capacity);
+        m_activeQueue.reserve(capacity);
+        m_applicable.reserve(capacity);
+    }
 
-        constexpr UserStateProperty(const int i): Index(i) {}
-        constexpr UserStateProperty<T>& operator=(const int i) { Index = i; return *this; }
-    };
+    template<typename T>
+    void Machine<T>::SetConditionCache(const ConditionCache<T>* cache, size_t instance) {
+        m_cacheBase = cache != nullptr ? cache->Base(m_def) : -1;
+        m_cache = m_cacheBase != -1 ? cache : nullptr;
+        m_instance = instance;
+        for (auto states : {&m_active, &m_activeQueue}) {
+            for (auto& state : *states) {
+                if (state.HasSub()) {
+                    state.GetSub()->SetConditionCache(cache, instance);
+                }
+            }
+        }
+    }
 
-    // A general purpose user state object that can be used for the Input or UpdateState types.
-    // You define a class with static UserStateProperty(s) and use that in the first parameters.
-    // You can add speciations for the Get & Set as long as the data type can be converted to and from a float.
-    // ```cpp
-    // struct Input {
-    //    static const inline state::UserStateProperty<bool>  Jump = 0;
-    //    static const inline state::UserStateProperty<float> Speed = 1; // -1=backwards, 0=still, 1=forwards
-    // };
-    // auto u = UserState(2);
-    // auto jumping = u.Get(Input::Jump);
-    // u.Set(Input::Speed, 0.5f);
-    // ```
-    class UserState {
-    public:
-        // No user state
-        UserState(): m_data() {}
+    template<typename T>
+    bool Machine<T>::Eval(const Transition<T>& trans, const update_t& update) {
+        if (m_cache != nullptr && trans.GetIndex() >= 0) {
+            auto cached = m_cache->Lookup(m_cacheBase + trans.GetIndex(), m_instance);
+            if (cached != -1) {
+                return cached == 1;
+            }
+        }
+        if constexpr (TracksChanges<input_t>) {
+            auto index = trans.GetIndex();
+            if (trans.GetWatches() != 0 && index >= 0) {
+                if (index < m_evaluated.size() && m_evaluated[index] != -1) {
+                    return m_evaluated[index] == 1;
+                }
+                auto result = trans.Eval(*m_input, update);
+                if (index >= m_evaluated.size()) {
+                    m_evaluated.resize(m_def->GetTransitionCount(), -1);
+                }
+                m_evaluated[index] = result ? 1 : 0;
+                return result;
+            }
+        }
+        return trans.Eval(*m_input, update);
+    }
 
-        // Creates a UserState given the number of possible variables.
-        UserState(size_t size): m_data(size) {}
+    template<typename T>
+    void Machine<T>::Changed(uint64_t changes) {
+        if (!m_evaluated.empty()) {
+            auto forget = [this, changes](const std::vector<Transition<T>>& transitions) {
+                for (auto& trans : transitions) {
+                    if ((trans.GetWatches() & changes) != 0 && trans.GetIndex() >= 0 && trans.GetIndex() < m_evaluated.size()) {
+                        m_evaluated[trans.GetIndex()] = -1;
+                    }
+                }
+            };
+            forget(m_def->GetTransitions());
+            for (auto& stateDef : m_def->GetStates()) {
+                forget(stateDef.GetTransitions());
+            }
+        }
+        for (auto states : {&m_active, &m_activeQueue}) {
+            for (auto& state : *states) {
+                if (state.HasSub()) {
+                    state.GetSub()->Changed(changes);
+                }
+            }
+        }
+    }
 
-        // Gets the value for the given user state property.
-        template<typename T>
-        inline T Get(UserStateProperty<T> prop) const {
-            return static_cast<T>(m_data[prop.Index]);
+    // The results of the compiled transition conditions (see Condition) in a machine definition and its sub machines,
+    // evaluated ahead of time for many UserState inputs. Each transition has a column, transitions with the same condition
+    // share its results. Inputs are evaluated a Program::Block at a time, the properties read by any of the conditions are
+    // gathered once for the block and then every condition is run against them with Program::EvalBlock. Other conditions gain nothing from being run
+    // ahead of time, so they aren't cached and are evaluated when they're needed.
+    template<typename T>
+    class ConditionCache {
+        using input_t     = typename T::input_type;
+        using update_t    = typename T::update_type;
+    public:
+        ConditionCache(const MachineDefinition<T>* def): m_columns(0), m_count(0), m_valid(false) {
+            add(def);
         }
 
-        // Sets the value for the given user state property.
-        template<typename T>
-        inline void Set(UserStateProperty<T> prop, T value) {
-            m_data[prop.Index] = static_cast<float>(value);
+        // Evaluates every compiled condition for each of the inputs, blocks are chunked across the work pool if given.
+        // The results are valid until Invalidate.
+        void Evaluate(const input_t* inputs, size_t count, const update_t&, WorkPool* work = nullptr, size_t grain = 64) {
+            m_count = count;
+            if constexpr (IsUserState<input_t>) {
+                constexpr auto Block = Program::Block;
+                auto blocks = (count + Block - 1) / Block;
+                m_results.resize(m_programs.size() * blocks);
+                auto evaluate = [&](size_t start, size_t end) {
+                    thread_local std::vector<float> columns;
+                    if (columns.size() < m_columns) {
+                        columns.resize(m_columns);
+                    }
+                    for (auto block = start; block < end; block++) {
+                        auto first = block * Block;
+                        Program::Gather(inputs + first, std::min(Block, count - first), m_properties, columns.data());
+                        for (size_t p = 0; p < m_programs.size(); p++) {
+                            m_results[p * blocks + block] = m_programs[p]->EvalBlock(columns.data());
+                        }
+                    }
+                };
+                if (work != nullptr) {
+                    work->For(blocks, std::max(size_t(1), grain / Block), evaluate);
+                } else {
+                    evaluate(0, blocks);
+                }
+            }
+            m_valid = true;
+        }
+        // Stops the results from being used, until the next Evaluate.
+        void Invalidate() noexcept {
+            m_valid = false;
+        }
+        // The column of the first transition of the definition, or -1 if none of the definition's transitions are cached.
+        // A transition's column is this plus its index (see Transition::GetIndex).
+        int Base(const MachineDefinition<T>* def) const noexcept {
+            for (auto& base : m_bases) {
+                if (base.def == def) {
+                    return base.cached ? base.column : -1;
+                }
+            }
+            return -1;
+        }
+        // Returns the cached result (0 or 1) of the transition in the column for the instance, or -1 if it's not known.
+        int Lookup(int column, size_t instance) const noexcept {
+            if (!m_valid || instance >= m_count || column < 0 || size_t(column) >= m_columnPrograms.size() || m_columnPrograms[column] == -1) {
+                return -1;
+            }
+            auto blocks = (m_count + Program::Block - 1) / Program::Block;
+            return int((m_results[m_columnPrograms[column] * blocks + instance / Program::Block] >> (instance % Program::Block)) & 1);
         }
+        // The number of columns, one for each transition of the definition and its sub machines.
+        size_t Columns() const noexcept { return m_columnPrograms.size(); }
 
     private:
-        std::vector<float> m_data;
+        // Where the columns of a definition's transitions start.
+        struct DefinitionBase {
+            const MachineDefinition<T>* def;
+            int column;
+            bool cached;
+        };
+
+        std::vector<DefinitionBase> m_bases;
+        // The distinct programs of the compiled conditions, transitions with the same condition share one.
+        std::vector<const Program*> m_programs;
+        // The program of each column, or -1 if the transition's results aren't cached.
+        std::vector<int> m_columnPrograms;
+        // The properties read by any compiled condition in order, and the number of floats their columns need.
+        std::vector<int> m_properties;
+        size_t m_columns;
+        // The results of each program, a bit per instance in words of Program::Block instances.
+        std::vector<uint64_t> m_results;
+        size_t m_count;
+        bool m_valid;
+
+        // Adds the compiled conditions of the transitions and returns whether there were any.
+        bool add(const std::vector<Transition<T>>& transitions, size_t base) {
+            auto cached = false;
+            if constexpr (IsUserState<input_t>) {
+                for (auto& trans : transitions) {
+                    auto compiled = trans.GetCondition().template target<Condition>();
+                    if (compiled != nullptr && trans.GetIndex() >= 0) {
+                        auto& program = compiled->GetProgram();
+                        auto at = std::find(m_programs.begin(), m_programs.end(), &program);
+                        m_columnPrograms[base + trans.GetIndex()] = int(at - m_programs.begin());
+                        if (at != m_programs.end()) {
+                            cached = true;
+                            continue;
+                        }
+                        m_programs.push_back(&program);
+                        for (auto property : program.Properties()) {
+                            auto at = std::lower_bound(m_properties.begin(), m_properties.end(), property);
+                            if (at == m_properties.end() || *at != property) {
+                                m_properties.insert(at, property);
+                            }
+                        }
+                        m_columns = std::max(m_columns, program.Columns());
+                        cached = true;
+                    }
+                }
+            }
+            return cached;
+        }
+        void add(const MachineDefinition<T>* def) {
+            for (auto& base : m_bases) {
+                if (base.def == def) {
+                    return;
+                }
+            }
+            auto base = m_columnPrograms.size();
+            auto index = m_bases.size();
+            m_bases.push_back({def, int(base), false});
+            m_columnPrograms.resize(base + def->GetTransitionCount(), -1);
+            auto cached = add(def->GetTransitions(), base);
+            for (auto& state : def->GetStates()) {
+                cached = add(state.GetTransitions(), base) || cached;
+                if (state.GetSub() != nullptr) {
+                    add(state.GetSub());
+                }
+            }
+            m_bases[index].cached = cached;
+        }
     };
 
-    // Get for bool
-    template<>
-    inline bool UserState::Get(UserStateProperty<bool> prop) const {
-        return m_data[prop.Index] == 1.0f;
-    }
+    // Many instances of one machine definition stepped together. Inputs are stored contiguously and compiled transition 
+    // conditions are evaluated across every input at once (see ConditionCache), then the instances are updated and 
+    // applied in parallel chunks across the work pool if given. Each instance is only touched by one thread, so as
+    // long as subjects aren't shared the results are the same as updating each machine on its own.
+    template<typename T>
+    class MachineBatch {
+        using subject_t   = typename T::subject_type;
+        using input_t     = typename T::input_type;
+        using update_t    = typename T::update_type;
+    public:
+        // A batch that can hold up to capacity instances of the definition.
+        MachineBatch(const MachineDefinition<T>* def, size_t capacity, WorkPool* work = nullptr, size_t grain = 64):
+            m_def(def), m_work(work), m_grain(grain), m_cache(def), m_inputs(std::make_shared<std::vector<input_t>>())
+        {
+            m_inputs->reserve(capacity);
+            m_machines.reserve(capacity);
+        }
+        MachineBatch(const MachineBatch&) = delete;
+        MachineBatch& operator=(const MachineBatch&) = delete;
+
+        // Adds an instance for the subject which should outlive the batch, returning its index. 
+        // If the batch is at capacity an exception is thrown.
+        size_t Add(subject_t& subject) {
+            if (m_inputs->size() == m_inputs->capacity()) {
+                throw std::length_error("machine batch is at capacity");
+            }
+            auto index = m_inputs->size();
+            m_inputs->push_back(m_def->GetInitialInput());
+            auto& machine = m_machines.emplace_back(m_def, subject, std::shared_ptr<input_t>(m_inputs, &m_inputs->back()));
+            machine.SetConditionCache(&m_cache, index);
+            return index;
+        }
+        // The number of instances in the batch.
+        size_t Size() const noexcept { return m_machines.size(); }
+        // The input of the instance at the index, the same as the machine's input.
+        input_t& Input(size_t index) noexcept { return (*m_inputs)[index]; }
+        // The inputs of all instances in order.
+        input_t* Inputs() noexcept { return m_inputs->data(); }
+        // The machine of the instance at the index.
+        Machine<T>& operator[](size_t index) noexcept { return m_machines[index]; }
+
+        // Initializes every instance, see Machine::Init.
+        void Init(const update_t& update) {
+            forEach([&update](Machine<T>& machine) { machine.Init(update); });
+        }
+        // Updates every instance, see Machine::Update.
+        void Update(const update_t& update) {
+            evaluate(update);
+            forEach([&update](Machine<T>& machine) { machine.Update(update); });
+            m_cache.Invalidate();
+        }
+        // Applies every instance, see Machine::Apply.
+        void Apply(const update_t& update) {
+            forEach([&update](Machine<T>& machine) { machine.Apply(update); });
+        }
+        // Updates then applies each instance in one pass.
+        void Step(const update_t& update) {
+            evaluate(update);
+            forEach([&update](Machine<T>& machine) { 
+                machine.Update(update);
+                machine.Apply(update);
+            });
+            m_cache.Invalidate();
+        }
 
-    // Set for bool
-    template<>
-    inline void UserState::Set(UserStateProperty<bool> prop, bool value) {
-        m_data[prop.Index] = value ? 1.0f : 0.0f;
-    }
+    private:
+        const MachineDefinition<T>* m_def;
+        WorkPool* m_work;
+        size_t m_grain;
+        ConditionCache<T> m_cache;
+        std::shared_ptr<std::vector<input_t>> m_inputs;
+        // Machines refer to their parents so they can't move, the capacity is reserved so they never do.
+        std::vector<Machine<T>> m_machines;
+
+        void evaluate(const update_t& update) {
+            m_cache.Evaluate(m_inputs->data(), m_inputs->size(), update, m_work, m_grain);
+        }
+        template<typename Fn>
+        void forEach(Fn&& fn) {
+            if (m_work == nullptr) {
+                for (auto& machine : m_machines) {
+                    fn(machine);
+                }
+                return;
+            }
+            m_work->For(m_machines.size(), m_grain, [this, &fn](size_t start, size_t end) {
+                for (auto i = start; i < end; i++) {
+                    fn(m_machines[i]);
+                }
+            });
+        }
+    };
 
 }
\ No newline at end of file
@@ -10,8 +10,21 @@
 #include <vector>
 #include <memory>
 #include <variant>
+#include <cstddef>
+#include <type_traits>
 
 #include "core.h"
+#include "id.h"
+
+// The number of bytes a types::Value can hold without allocating.
+#ifndef VALUE_INLINE_SIZE
+#define VALUE_INLINE_SIZE 32
+#endif
+
+// The alignment of the bytes a types::Value can hold without allocating.
+#ifndef VALUE_INLINE_ALIGN
+#define VALUE_INLINE_ALIGN 16
+#endif
 
 /**
  * The namespace that has the structures for defining types.
@@ -27,7 +40,10 @@
  * A value has a type, a pointer or a shared value, and flags. The type must be non-null for the value to be valid. 
  * The pointer can point to the reference of a value or a shared pointer of a value. Flags keep track of whether its reference 
  * (setting it directly will update the value in memory) or a copy, if it represents a value that is read-only, and if the value
- * was casted to another type and writing to it may result in unexpected consequences.
+ * was casted to another type and writing to it may result in unexpected consequences. Copies of small trivially copyable
+ * types (up to VALUE_INLINE_SIZE bytes) are stored inline in the value instead of the heap, copying one of those values 
+ * copies the data so setting one does not change the other, and references to its props only live as long as the value.
+ * Shared moves an inline value to the heap when its copies need to share its data.
  * 
  * A prop exists on a parent type and can return a reference to a property value, a copy, or it can set a property 
  * value.
@@ -63,6 +79,24 @@ namespace types {
         bool remove;
     };
 
+    // The contiguous values of a collection, so generic code can walk them with a pointer and a stride
+    // instead of a Value for each.
+    struct CollectionSpan {
+        void* data = nullptr;
+        size_t size = 0;
+        size_t stride = 0;
+        const Type* type = nullptr;
+
+        constexpr bool Empty() const noexcept { return size == 0; }
+        // Returns the address of the value at the index.
+        constexpr void* At(size_t index) const noexcept { return static_cast<std::byte*>(data) + index * stride; }
+        // Returns a reference to the value at the index.
+        inline Value Get(size_t index) const noexcept;
+        // Returns the values as a span of T, or an empty span if the values are not of type T.
+        template<typename T>
+        std::span<T> As() const noexcept;
+    };
+
     // A generic collection of key values.
     class Collection {
     public:
@@ -70,12 +104,16 @@ namespace types {
         using value_type = Value;
         using iter_type = KeyValue<key_type, value_type>;
 
+        virtual ~Collection() = default;
+
         virtual value_type Get(key_type key) = 0;
         virtual bool Set(key_type key, value_type& value) = 0;
         virtual bool Add(key_type key, value_type& value) = 0;
         virtual bool Contains(key_type key) = 0;
         virtual size_t Size() const = 0;
         virtual void Iterate(std::function<bool(iter_type*)> fn) = 0;
+        // The values when they're stored contiguously, otherwise an empty span.
+        virtual CollectionSpan Span() { return CollectionSpan(); }
     };
 
     const std::string& InvalidPropName = "<invalid>";
@@ -88,21 +126,40 @@ namespace types {
         using ref_type = std::function<Value(Value&)>;
         using set_type = std::function<bool(Value&,Value&)>;
     
+        // The offset of a prop which is not a field at a fixed place in its parent.
+        static constexpr size_t NoOffset = size_t(-1);
+
         Prop(): name(InvalidPropName) {}
         Prop(name_type n): name(n) {}
 
         name_type name;
-        const Type* type;
+        const Type* type = nullptr;
         get_type get;
         ref_type ref;
         set_type set;
-        bool isVirtual;
+        bool isVirtual = false;
+        // The byte offset of a field from the start of its parent, or NoOffset.
+        size_t offset = NoOffset;
 
         bool isValid() { return name != InvalidPropName; }
+        // Whether this prop is a field that can be accessed directly with Address.
+        constexpr bool IsField() const noexcept { return offset != NoOffset; }
+        // Returns the address of this field given the address of its parent.
+        constexpr void* Address(void* parent) const noexcept { return static_cast<char*>(parent) + offset; }
+        constexpr const void* Address(const void* parent) const noexcept { return static_cast<const char*>(parent) + offset; }
+    };
+
+    // A prop resolved ahead of time on a type so it can be accessed on values without a name lookup.
+    // A handle stays valid as long as no props are removed from the type.
+    struct PropHandle {
+        const Type* type = nullptr;
+        int index = -1;
+
+        constexpr bool IsValid() const noexcept { return index != -1; }
     };
 
     const std::string getTypeName(const Type* t);
-    const std::string getPropName(const Prop p);
+    const std::string getPropName(const Prop& p);
 
     // A type family holds the initial type defined for a specific type <T> and all subsequent types
     // that use the same underlying type. 
@@ -140,10 +197,27 @@ namespace types {
     }
 
     // A definition if a type has a collection of key-values.
+    // The raw functions are optional and take the address of the value which has the collection, they let code
+    // that walks many elements (like serialization) skip creating a Collection and a Value for each element.
     struct TypeCollection {
+        // Called with the addresses of a key and its value.
+        using visit_type = void(*)(void* context, void* key, void* value);
+
         const Type* key;
         const Type* value;
         const std::function<std::shared_ptr<Collection>(Value&)> create;
+        // Returns the address of the first value and sets the count, for collections with contiguous values.
+        std::function<void*(void* source, size_t* count)> elements = nullptr;
+        // Resizes a contiguous collection keyed by index and returns the address of the first value.
+        std::function<void*(void* source, size_t count)> resize = nullptr;
+        // Calls visit with each key & value of collections that are not contiguous.
+        std::function<void(void* source, visit_type visit, void* context)> each = nullptr;
+        // Calls fill with a default key & value to populate, and then adds them to a non-contiguous collection.
+        std::function<void(void* source, visit_type fill, void* context)> insert = nullptr;
+        // Removes all keys & values from a collection.
+        std::function<void(void* source)> clear = nullptr;
+        // Constructs the Collection for the value in the given storage, see LocalCollection.
+        std::function<Collection*(Value& source, void* storage)> place = nullptr;
     };
 
     // Helps define a type
@@ -160,8 +234,8 @@ namespace types {
         using fromstring_type = std::function<Value(const std::string&)>;
         using cast_type =  std::function<Value(const Value&)>;
         
-        Type(id_type id, name_type name, const size_t size, const TypeFamily* family): 
-            m_id(id), m_name(name), m_size(size), m_family(family), m_props(getPropName, true, true) {};
+        Type(id_type id, name_type name, const size_t size, const TypeFamily* family, bool trivial = false): 
+            m_id(id), m_name(name), m_size(size), m_family(family), m_trivial(trivial), m_props(getPropName, true, true) {};
         
         auto Name() const noexcept { return m_name; }
         constexpr auto ID() const noexcept { return m_id; }
@@ -170,12 +244,16 @@ namespace types {
         constexpr auto IsBase() const noexcept { return this == m_family->Base(); }
         constexpr auto IsCompatible(const Type* t) const noexcept { return m_family == t->m_family; }
         constexpr auto IsCastCompatible(const Type *t) const noexcept { return m_size == t->m_size; }
+        // Whether values of this type can be copied with memcpy.
+        constexpr bool IsTrivial() const noexcept { return m_trivial; }
         inline Value Create();
         inline std::string ToString(Value& value);
         inline Value FromString(const std::string& str);
         inline auto IsCollection() const noexcept { return !!m_collection; }
         const auto& Collection() const noexcept { return m_collection; }
-        auto Props() const noexcept { return m_props; }
+        constexpr const auto& Props() const noexcept { return m_props; }
+        // Resolves the prop with the given name to a handle, or an invalid handle if this type does not have it.
+        PropHandle Handle(std::string_view name) const noexcept { return PropHandle{this, m_props.IndexOf(name)}; }
         auto GetCast(const Type* to) const {
             auto cast = m_casts.find(to->ID());
             return cast == m_casts.end() ? cast_type() : cast->second;
@@ -198,6 +276,7 @@ namespace types {
         name_type m_name;
         const size_t m_size;
         const TypeFamily* m_family;
+        const bool m_trivial;
         NameMap<Prop> m_props;
         create_type m_create;
         tostring_type m_toString;
@@ -206,8 +285,16 @@ namespace types {
         std::unique_ptr<TypeCollection> m_collection;
     };
 
+    template<typename T>
+    std::span<T> CollectionSpan::As() const noexcept {
+        if (type == nullptr || !type->Is<std::remove_const_t<T>>() || stride != sizeof(T)) {
+            return std::span<T>();
+        }
+        return std::span<T>(static_cast<T*>(data), size);
+    }
+
     const std::string getTypeName(const Type* t) { return t->Name(); }
-    const std::string getPropName(const Prop p) { return p.name; }
+    const std::string getPropName(const Prop& p) { return p.name; }
 
     // Global types
     auto typeIds = new Incrementor<int>(0, 1);
@@ -231,17 +318,40 @@ namespace types {
             static constexpr Value::flags_type Reference = 0b00000010; // Value refers to a user-managed place in memory, setting will change it immediately
             static constexpr Value::flags_type Copy      = 0b00000100; // Value was heap-allocated and the data will be freed
             static constexpr Value::flags_type Cast      = 0b00001000; // Value was cast to a compatible type and is not the original
+            static constexpr Value::flags_type Inline    = 0b00010000; // Value is a copy stored in the value itself, copies of this value are independent
         };
 
+        // The largest trivially copyable type ValueOf will store inline instead of on the heap.
+        static constexpr size_t InlineSize = VALUE_INLINE_SIZE;
+
+        // Whether ValueOf will store T inline.
+        template<typename T>
+        static constexpr bool IsInlinable = std::is_trivially_copyable_v<T> && sizeof(T) <= InlineSize && alignof(T) <= VALUE_INLINE_ALIGN;
+
         Value(): m_type(nullptr), m_ptr(nullptr), m_copy(), m_flags(Flags::None) {} 
         Value(Type* type, data_type data, flags_type flags = Flags::None): m_type(type), m_ptr(data), m_copy(), m_flags(flags | Flags::Reference) {}
         Value(Type* type, copy_type data, flags_type flags = Flags::None): m_type(type), m_ptr(nullptr), m_copy(std::move(data)), m_flags(flags | Flags::Copy) {}
-        Value(const Value& other, flags_type addFlags): m_type(other.m_type), m_ptr(other.m_ptr), m_copy(other.m_copy), m_flags(other.m_flags | addFlags) {}
+        Value(const Value& other, flags_type addFlags): Value(other) { m_flags |= addFlags; }
         Value(const Value& other) = default;
+        Value(Value&& other) = default;
+        Value& operator=(const Value& other) = default;
+        Value& operator=(Value&& other) = default;
+
+        // A copy of the trivially copyable value stored inline.
+        template<typename T>
+        static Value Inline(Type* type, const T& value, flags_type flags = Flags::None) noexcept {
+            static_assert(IsInlinable<T>, "Value::Inline requires a small trivially copyable type");
+            auto v = Value();
+            v.m_type = type;
+            v.m_flags = flags | Flags::Copy | Flags::Inline;
+            memcpy(v.m_inline, &value, sizeof(T));
+            return v;
+        }
 
         constexpr auto IsReference() const noexcept { return (m_flags & Flags::Reference) != 0; }
         constexpr bool IsCopy() const noexcept { return (m_flags & Flags::Copy ) != 0; }
         constexpr bool IsCast() const noexcept { return (m_flags & Flags::Cast ) != 0; }
+        constexpr bool IsInline() const noexcept { return (m_flags & Flags::Inline) != 0; }
         constexpr auto IsValid() const noexcept { return m_type != nullptr && ptr() != nullptr; }
         inline auto IsCollection() const noexcept { return m_type->IsCollection(); }
         constexpr auto Data() const noexcept { return ptr(); }
@@ -255,6 +365,18 @@ namespace types {
             return c ? c->create(*this) : nullptr;
         }
 
+        // The contiguous values of this collection, or an empty span if it does not store them contiguously.
+        CollectionSpan Span() const {
+            auto& c = m_type->Collection();
+            auto p = ptr();
+            if (!c || !c->elements || p == nullptr) {
+                return CollectionSpan();
+            }
+            size_t count = 0;
+            auto data = c->elements(p, &count);
+            return CollectionSpan{data, count, c->value->Size(), c->value};
+        }
+
         explicit operator bool() const noexcept { return this->IsValid(); }
 
         template<typename T>
@@ -264,6 +386,20 @@ namespace types {
             return Value(*this, Flags::ReadOnly);
         }
 
+        // A copy of this value with its data on the heap, so copies of it share the data like values of types
+        // too large to store inline. Inline values are copied to the heap, any other value is returned as is.
+        Value Shared() const {
+            if (!IsInline()) {
+                return *this;
+            }
+            auto size = m_type->Size();
+            auto data = copy_type(::operator new(size, std::align_val_t(VALUE_INLINE_ALIGN)), [](void* p) { 
+                ::operator delete(p, std::align_val_t(VALUE_INLINE_ALIGN)); 
+            });
+            memcpy(data.get(), m_inline, size);
+            return Value(m_type, std::move(data), flags_type(m_flags & ~Flags::Inline));
+        }
+
         Value StaticCast(const Type* otherType) const {
             auto caster = m_type->GetCast(otherType);
             if (caster) {
@@ -274,28 +410,31 @@ namespace types {
 
         Value ReinterpretCast(Type* otherType) const noexcept {
             if (m_type->IsCastCompatible(otherType)) {
-                if (IsReference()) {
-                    return Value(otherType, m_ptr, m_flags | Flags::Cast);
-                } else {
-                    return Value(otherType, m_copy, m_flags | Flags::Cast);
-                }
+                auto cast = Value(*this, Flags::Cast);
+                cast.m_type = otherType;
+                return cast;
             }
             return Value::Invalid();
         }
 
-        Value Prop(const Prop::name_type& name) {
+        Value Prop(std::string_view name) {
             if (this->IsValid()) {
-                const auto& prop = m_type->Props().Get(name);
-                if (prop.ref) {
-                    return prop.ref(*this);
-                }
-                if (prop.get) {
-                    return prop.get(*this);
+                auto prop = m_type->Props().Ptr(name);
+                if (prop != nullptr) {
+                    return access(*prop);
                 }
             }
             return Value::Invalid();
         }
 
+        // Returns the prop the handle was resolved to, the handle must come from the type of this value.
+        Value Prop(const PropHandle& handle) {
+            if (this->IsValid() && handle.type == m_type && handle.IsValid()) {
+                return access(m_type->Props().At(handle.index));
+            }
+            return Value::Invalid();
+        }
+
         template<typename T>
         bool Set(const T& v) const {
             auto p = ptr();
@@ -342,12 +481,78 @@ namespace types {
         data_type m_ptr;
         copy_type m_copy;
         flags_type m_flags;
+        alignas(VALUE_INLINE_ALIGN) mutable std::byte m_inline[InlineSize];
+
+        Value access(const types::Prop& prop) {
+            if (prop.IsField()) {
+                return Value(const_cast<Type*>(prop.type), prop.Address(ptr()), Flags::Reference);
+            }
+            if (prop.ref) {
+                return prop.ref(*this);
+            }
+            if (prop.get) {
+                return prop.get(*this);
+            }
+            return Value::Invalid();
+        }
 
         constexpr data_type ptr() const noexcept { 
-            return m_ptr != nullptr ? m_ptr : m_copy.get(); 
+            if (m_ptr != nullptr) {
+                return m_ptr;
+            }
+            return (m_flags & Flags::Inline) != 0 ? (data_type)m_inline : m_copy.get(); 
+        }
+    };
+
+    inline Value CollectionSpan::Get(size_t index) const noexcept {
+        return Value(const_cast<Type*>(type), At(index), Value::Flags::Reference);
+    }
+
+    // The Collection of a value constructed in place instead of on the heap, so walking the collections
+    // of many values does not allocate. It lives as long as the value it was created from.
+    class LocalCollection {
+    public:
+        // The most bytes a Collection can take to be stored in place.
+        static constexpr size_t Capacity = 64;
+
+        LocalCollection(Value& value): m_collection(nullptr) {
+            auto& c = value.GetType()->Collection();
+            if (c && value.IsValid()) {
+                if (c->place) {
+                    m_collection = c->place(value, m_storage);
+                } else {
+                    m_shared = c->create(value);
+                    m_collection = m_shared.get();
+                }
+            }
+        }
+        ~LocalCollection() {
+            if (m_collection != nullptr && !m_shared) {
+                m_collection->~Collection();
+            }
         }
+        LocalCollection(const LocalCollection&) = delete;
+        LocalCollection& operator=(const LocalCollection&) = delete;
+
+        constexpr types::Collection* Get() const noexcept { return m_collection; }
+        constexpr types::Collection* operator->() const noexcept { return m_collection; }
+        constexpr types::Collection& operator*() const noexcept { return *m_collection; }
+        explicit operator bool() const noexcept { return m_collection != nullptr; }
+
+    private:
+        alignas(std::max_align_t) std::byte m_storage[Capacity];
+        types::Collection* m_collection;
+        // Used for collections defined without a place function.
+        std::shared_ptr<types::Collection> m_shared;
     };
 
+    // Constructs the collection C in the storage of a LocalCollection.
+    template<typename C, typename... Args>
+    Collection* PlaceCollection(void* storage, Args&&... args) {
+        static_assert(sizeof(C) <= LocalCollection::Capacity && alignof(C) <= alignof(std::max_align_t), "collection does not fit in a LocalCollection");
+        return new (storage) C(std::forward<Args>(args)...);
+    }
+
     template<>
     bool Value::Set(const Value& v) const {
         if (!m_type->IsCompatible(v.m_type)) {
@@ -362,7 +567,11 @@ namespace types {
         if (specificType == nullptr) {
             specificType = FamilyFor<T>()->Base();
         }
-        return Value(specificType, std::make_shared<T>(value), Value::Flags::Copy);
+        if constexpr (Value::IsInlinable<T>) {
+            return Value::Inline(specificType, value);
+        } else {
+            return Value(specificType, std::make_shared<T>(value), Value::Flags::Copy);
+        }
     }
 
     template<typename T>
@@ -376,7 +585,7 @@ namespace types {
     template<typename T>
     Type* New(Type::name_type name) {
         auto family = FamilyFor<T>();
-        auto t = new Type(typeIds->Get(), name, sizeof(T), family);
+        auto t = new Type(typeIds->Get(), name, sizeof(T), family, std::is_trivially_copyable_v<T>);
     
         types.Add(t);
         family->Add(t);
@@ -427,12 +636,12 @@ namespace types {
         size_t Size() const {
             return m_values->size();
         }
+        // Iterates with the value referencing each element, or a copy of it for std::vector<bool>.
         void Iterate(std::function<bool(iter_type*)> fn) {
-            auto kv = iter_type{ValueOf(0), ValueOf<E>(E()), false};
-            for (int i = 0; i < m_values->size(); i++) {
-                kv.key.Set(i);
-                kv.value.Set(m_values->at(i));
-                kv.remove = false;
+            auto key = ValueOf(0);
+            for (int i = 0; i < int(m_values->size()); i++) {
+                key.Set(i);
+                auto kv = iter_type{key, element(i), false};
                 auto stop = !fn(&kv);
                 if (kv.remove) {
                     m_values->erase(m_values->begin()+i);
@@ -443,9 +652,25 @@ namespace types {
                 }
             }
         }
+        CollectionSpan Span() {
+            if constexpr (std::is_same_v<E, bool>) {
+                return CollectionSpan();
+            } else {
+                return CollectionSpan{m_values->data(), m_values->size(), sizeof(E), m_value};
+            }
+        }
     private:
         std::vector<E>* m_values;
         Type* m_value;
+
+        // std::vector<bool> elements are proxies without an address.
+        Value element(int i) {
+            if constexpr (std::is_same_v<E, bool>) {
+                return ValueOf<bool>((*m_values)[i], m_value);
+            } else {
+                return Value(m_value, (void*)&(*m_values)[i]);
+            }
+        }
     };
     
     template<typename K, typename V>
@@ -483,15 +708,16 @@ namespace types {
         size_t Size() const {
             return m_values->size();
         }
+        // Iterates with the key & value referencing each entry, the key is read only.
         void Iterate(std::function<bool(iter_type*)> fn) {
-            auto kv = iter_type{ValueOf(K(), m_key), ValueOf<V>(V(), m_value), false};
-            for (auto& pair : m_values) {
-                kv.key.Set(pair->first);
-                kv.value.Set(pair->second);
-                kv.remove = false;
+            for (auto pair = m_values->begin(); pair != m_values->end();) {
+                auto key = Value(m_key, (void*)&pair->first, Value::Flags::ReadOnly);
+                auto kv = iter_type{key, Value(m_value, (void*)&pair->second), false};
                 auto stop = !fn(&kv);
                 if (kv.remove) {
-                    m_values->erase(pair);
+                    pair = m_values->erase(pair);
+                } else {
+                    pair++;
                 }
                 if (stop) {
                     break;
@@ -504,6 +730,73 @@ namespace types {
         Type* m_value;
     };
 
+    // A collection of an id::DenseKeyMap, its keys are id::Identifiers and its values are contiguous.
+    template<typename V, typename aid_t, typename lid_t>
+    class DenseMapCollection : public Collection {
+    public:
+        using map_type = id::DenseKeyMap<V, aid_t, lid_t>;
+
+        DenseMapCollection(map_type* values, Type* key, Type* value): 
+            m_values(values), m_key(key), m_value(value) {}
+
+        value_type Get(key_type key) {
+            if (key.IsValid() && key.Is<id::Identifier>()) {
+                auto p = m_values->Ptr(key.Get<id::Identifier>());
+                if (p != nullptr) {
+                    return ValueOf(*p, m_value);
+                }
+            }
+            return Value::Invalid();
+        }
+        bool Set(key_type key, value_type& value) {
+            return Add(key, value);
+        }
+        bool Add(key_type key, value_type& value) {
+            if (key.IsValid() && key.Is<id::Identifier>()) {
+                m_values->Set(key.Get<id::Identifier>(), value.Get<V>());
+                return true;
+            }
+            return false;
+        }
+        bool Contains(key_type key) {
+            return key.IsValid() && key.Is<id::Identifier>() && m_values->Ptr(key.Get<id::Identifier>()) != nullptr;
+        }
+        size_t Size() const {
+            return m_values->Size();
+        }
+        // Iterates with the key & value referencing each entry, the key is read only.
+        // Removed values keep their place until the iteration is done.
+        void Iterate(std::function<bool(iter_type*)> fn) {
+            auto& keys = m_values->Keys();
+            auto removed = false;
+            for (size_t i = 0; i < keys.size(); i++) {
+                if (m_values->IsRemoved(i)) {
+                    continue;
+                }
+                auto key = Value(m_key, (void*)&keys[i], Value::Flags::ReadOnly);
+                auto kv = iter_type{key, Value(m_value, (void*)&m_values->Values()[i]), false};
+                auto stop = !fn(&kv);
+                if (kv.remove) {
+                    removed = m_values->RemoveLater(keys[i]) || removed;
+                }
+                if (stop) {
+                    break;
+                }
+            }
+            if (removed) {
+                m_values->Compact();
+            }
+        }
+        // The values including those removed but waiting for a Compact, see id::DenseMap::IsRemoved.
+        CollectionSpan Span() {
+            return CollectionSpan{m_values->Values().data(), m_values->Values().size(), sizeof(V), m_value};
+        }
+    private:
+        map_type* m_values;
+        Type* m_key;
+        Type* m_value;
+    };
+
     
     // The class that holds definition. It can be applied to more than one type, and the calls
     // can be chained. Each chained call returns a copy so it doesn't affect the previous calls.
@@ -553,6 +846,48 @@ namespace types {
                 d->m_props.Add(p);
             });
         }
+        // A prop which is a member stored in T. The value is accessed directly by its offset
+        // instead of through a function.
+        template<typename V, typename C>
+        requires std::is_same_v<C, T>
+        Def<T> Field(Prop::name_type name, Type* type, V C::* member) {
+            prop_type p(name);
+            p.type = type;
+            p.offset = offsetOf(member);
+            auto offset = p.offset;
+            p.ref = [offset, type](const Value& s) -> Value {
+                auto sp = s.Ptr<T>();
+                if (sp == nullptr) {
+                    return Value::Invalid();
+                }
+                return ValueTo((V*)((char*)sp + offset), type);
+            };
+            p.get = [offset, type](const Value& s) -> Value {
+                auto sp = s.Ptr<T>();
+                if (sp == nullptr) {
+                    return Value::Invalid();
+                }
+                return ValueOf<V>(*(V*)((char*)sp + offset), type);
+            };
+            p.set = [offset](const Value& s, const Value& v) -> bool {
+                auto sp = s.Ptr<T>();
+                if (sp == nullptr) {
+                    return false;
+                }
+                *(V*)((char*)sp + offset) = v.Get<V>();
+                return true;
+            };
+
+            return apply([p](Type* d) {
+                d->m_props.Add(p);
+            });
+        }
+        // A field of the base type defined for V.
+        template<typename V, typename C>
+        requires std::is_same_v<C, T>
+        Def<T> Field(Prop::name_type name, V C::* member) {
+            return Field(name, FamilyFor<V>()->Base(), member);
+        }
         template<typename V>
         Def<T> Virtual(Prop::name_type name, Type *type, std::function<V(T*)> get, std::function<bool(T*,V)> set) {
             prop_type p(name);
@@ -630,6 +965,24 @@ namespace types {
         template<typename E>
         Def<T> Vector(Type* key, Type* value, std::function<std::vector<E>*(T*)> get) {
             return apply([key, value, get](Type* d) {
+                auto elements = std::function<void*(void*, size_t*)>(nullptr);
+                auto resize = std::function<void*(void*, size_t)>(nullptr);
+                // std::vector<bool> does not store its elements contiguously.
+                if constexpr (!std::is_same_v<E, bool>) {
+                    elements = [get](void* source, size_t* count) -> void* {
+                        auto v = get((T*)source);
+                        *count = v == nullptr ? 0 : v->size();
+                        return v == nullptr ? nullptr : v->data();
+                    };
+                    resize = [get](void* source, size_t count) -> void* {
+                        auto v = get((T*)source);
+                        if (v == nullptr) {
+                            return nullptr;
+                        }
+                        v->resize(count);
+                        return v->data();
+                    };
+                }
                 d->m_collection = std::make_unique<TypeCollection>(std::move(TypeCollection{
                     key,
                     value,
@@ -645,6 +998,21 @@ namespace types {
                             return empty;
                         }
                         return std::make_shared<VectorCollection<E>>(v, value);
+                    },
+                    elements,
+                    resize,
+                    nullptr,
+                    nullptr,
+                    [get](void* source) {
+                        auto v = get((T*)source);
+                        if (v != nullptr) {
+                            v->clear();
+                        }
+                    },
+                    [value, get](Value& source, void* storage) -> collection_type* {
+                        auto s = source.Ptr<T>();
+                        auto v = s == nullptr ? nullptr : get(s);
+                        return v == nullptr ? nullptr : PlaceCollection<VectorCollection<E>>(storage, v, value);
                     }
                 }));
             });
@@ -667,6 +1035,89 @@ namespace types {
                             return empty;
                         }
                         return std::make_shared<MapCollection<K, V>>(v, key, value);
+                    },
+                    nullptr,
+                    nullptr,
+                    [get](void* source, TypeCollection::visit_type visit, void* context) {
+                        auto v = get((T*)source);
+                        if (v != nullptr) {
+                            for (auto& pair : *v) {
+                                visit(context, (void*)&pair.first, &pair.second);
+                            }
+                        }
+                    },
+                    [get](void* source, TypeCollection::visit_type fill, void* context) {
+                        auto v = get((T*)source);
+                        if (v != nullptr) {
+                            auto key = K();
+                            auto value = V();
+                            fill(context, &key, &value);
+                            (*v)[std::move(key)] = std::move(value);
+                        }
+                    },
+                    [get](void* source) {
+                        auto v = get((T*)source);
+                        if (v != nullptr) {
+                            v->clear();
+                        }
+                    },
+                    [key, value, get](Value& source, void* storage) -> collection_type* {
+                        auto s = source.Ptr<T>();
+                        auto v = s == nullptr ? nullptr : get(s);
+                        return v == nullptr ? nullptr : PlaceCollection<MapCollection<K, V>>(storage, v, key, value);
+                    }
+                }));
+            });
+        }
+        // A map of id::Identifier keys to contiguous values. The key type must be a type of id::Identifier.
+        template<typename V, typename aid_t = id::id_t, typename lid_t = uint16_t>
+        Def<T> DenseMap(Type* key, Type* value, std::type_identity_t<std::function<id::DenseKeyMap<V, aid_t, lid_t>*(T*)>> get) {
+            using collection = DenseMapCollection<V, aid_t, lid_t>;
+            return apply([key, value, get](Type* d) {
+                d->m_collection = std::make_unique<TypeCollection>(std::move(TypeCollection{
+                    key,
+                    value,
+                    [key, value, get](Value& source) -> std::shared_ptr<collection_type> {
+                        auto s = source.Ptr<T>();
+                        auto v = s == nullptr ? nullptr : get(s);
+                        return v == nullptr ? std::shared_ptr<collection_type>(nullptr) : std::make_shared<collection>(v, key, value);
+                    },
+                    [get](void* source, size_t* count) -> void* {
+                        auto v = get((T*)source);
+                        *count = v == nullptr ? 0 : v->Values().size();
+                        return v == nullptr ? nullptr : v->Values().data();
+                    },
+                    nullptr,
+                    [get](void* source, TypeCollection::visit_type visit, void* context) {
+                        auto v = get((T*)source);
+                        if (v != nullptr) {
+                            auto& keys = v->Keys();
+                            for (size_t i = 0; i < keys.size(); i++) {
+                                if (!v->IsRemoved(i)) {
+                                    visit(context, &keys[i], &v->Values()[i]);
+                                }
+                            }
+                        }
+                    },
+                    [get](void* source, TypeCollection::visit_type fill, void* context) {
+                        auto v = get((T*)source);
+                        if (v != nullptr) {
+                            auto key = id::Identifier();
+                            auto value = V();
+                            fill(context, &key, &value);
+                            v->Set(key, std::move(value));
+                        }
+                    },
+                    [get](void* source) {
+                        auto v = get((T*)source);
+                        if (v != nullptr) {
+                            v->Clear();
+                        }
+                    },
+                    [key, value, get](Value& source, void* storage) -> collection_type* {
+                        auto s = source.Ptr<T>();
+                        auto v = s == nullptr ? nullptr : get(s);
+                        return v == nullptr ? nullptr : PlaceCollection<collection>(storage, v, key, value);
                     }
                 }));
             });
@@ -688,6 +1139,14 @@ namespace types {
     private:
         std::vector<apply_type> m_appliers;
 
+        // The byte offset of the member in T, measured on uninitialized storage so T needs no constructor.
+        template<typename V, typename C>
+        static size_t offsetOf(V C::* member) noexcept {
+            alignas(T) static char storage[sizeof(T)];
+            auto base = reinterpret_cast<T*>(storage);
+            return size_t(reinterpret_cast<char*>(&(base->*member)) - storage);
+        }
+
         Def<T> apply(apply_type apply) {
             m_appliers.push_back(apply);
             return *this;
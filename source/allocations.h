@@ -0,0 +1,28 @@
+#pragma once
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Counts heap allocations to test what should not allocate. Every form of new and delete is replaced so they
+// stay a matched set, and delete is kept out of line so the compiler doesn't see free called on memory from new.
+inline std::atomic<size_t> Allocations = 0;
+
+#if defined(__GNUC__) || defined(__clang__)
+#define ALLOCATIONS_NOINLINE __attribute__((noinline))
+#else
+#define ALLOCATIONS_NOINLINE
+#endif
+
+void* operator new(size_t size) {
+    Allocations++;
+    if (auto p = malloc(size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size) { return operator new(size); }
+ALLOCATIONS_NOINLINE void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { operator delete(p); }
+void operator delete(void* p, size_t) noexcept { operator delete(p); }
+void operator delete[](void* p, size_t) noexcept { operator delete(p); }
@@ -1,6 +1,7 @@
 // #define LOG_ENABLED true
 
 #include "../include/anim.h"
+#include "allocations.h"
 
 // Inputs that can drive the effect and condition functions.
 struct Input {
@@ -51,6 +52,20 @@ anim::Animation Load(const std::string& name, float dataStart = 0) {
     };
 }
 
+// Loads an animation with many points and mixed easings
+anim::Animation LoadLong(const std::string& name, int points) {
+    auto animation = anim::Animation{
+        .name = name,
+        .options = {.duration = 4.0f, .repeat = -1},
+        .attributes = {{.attribute = "position"}}
+    };
+    for (int i = 0; i < points; i++) {
+        auto easing = i % 3 == 0 ? anim::Easing(anim::Quad) : i % 3 == 1 ? anim::Easing([](float d) -> float { return d * d * d; }) : anim::Easing();
+        animation.attributes[0].points.push_back({.time=float(i) / (points - 1), .easing=easing, .data=TFloat->New(float(i % 7))});
+    }
+    return animation;
+}
+
 // Helper functions
 template<typename T>
 T Abs(T value) {
@@ -86,13 +101,47 @@ anim::AnimationOptions LeftEffect(const state::UserState& i, const state::UserSt
     auto speed = i.Get(Input::SideSpeed) < 0 ? -i.Get(Input::SideSpeed) : 0;
     return anim::AnimationOptions{ .scale = speed };
 }
-// Transition conditions
-bool Jumped(const state::UserState& i, const state::UserState& u) { return i.Get(Input::Jump); }
-bool IsFalling(const state::UserState& i, const state::UserState& u) { return i.Get(Input::FallingSpeed) < 0 && !i.Get(Input::OnGround); }
-bool OnGround(const state::UserState& i, const state::UserState& u) { return i.Get(Input::OnGround); }
-bool LedgeGrabbed(const state::UserState& i, const state::UserState& u) { return i.Get(Input::GrabbingLedge); }
-bool LedgeLetGo(const state::UserState& i, const state::UserState& u) { return !i.Get(Input::GrabbingLedge) || i.Get(Input::OnGround); }
-bool LedgePulled(const state::UserState& i, const state::UserState& u) { return i.Get(Input::PullLedge); }
+// Transition conditions, counting how many times they are evaluated
+std::atomic<size_t> Conditions = 0;
+bool Jumped(const state::UserState& i, const state::UserState& u) { Conditions++; return i.Get(Input::Jump); }
+bool IsFalling(const state::UserState& i, const state::UserState& u) { Conditions++; return i.Get(Input::FallingSpeed) < 0 && !i.Get(Input::OnGround); }
+bool OnGround(const state::UserState& i, const state::UserState& u) { Conditions++; return i.Get(Input::OnGround); }
+bool LedgeGrabbed(const state::UserState& i, const state::UserState& u) { Conditions++; return i.Get(Input::GrabbingLedge); }
+bool LedgeLetGo(const state::UserState& i, const state::UserState& u) { Conditions++; return !i.Get(Input::GrabbingLedge) || i.Get(Input::OnGround); }
+bool LedgePulled(const state::UserState& i, const state::UserState& u) { Conditions++; return i.Get(Input::PullLedge); }
+
+// Changes the input for the frame of the test script
+void Script(state::UserState& input, int i) {
+    if (i == 5) { // walk
+        input.Set(Input::ForwardSpeed, 0.5f);
+    } else if (i == 10) { // run
+        input.Set(Input::ForwardSpeed, 1.0f);
+    } else if (i == 20) { // jump
+        input.Set(Input::Jump, true);
+        input.Set(Input::FallingSpeed, 1.0f);
+        input.Set(Input::OnGround, false);
+    } else if (i > 20 && i < 30) { // up & down
+        input.Set(Input::Jump, false);
+        input.Set(Input::FallingSpeed, input.Get(Input::FallingSpeed) - 0.2f);
+    } else if (i == 30) { // land
+        input.Set(Input::OnGround, true);
+        input.Set(Input::FallingSpeed, 0.0f);
+    } else if (i == 32) { // climb up and left
+        input.Set(Input::GrabbingLedge, true);
+        input.Set(Input::OnGround, false);
+        input.Set(Input::SideSpeed, -1.0f);
+        input.Set(Input::ForwardSpeed, 1.0f);
+    } else if (i == 34) { // pause climbing
+        input.Set(Input::SideSpeed, 0.0f);
+        input.Set(Input::ForwardSpeed, 0.0f);
+    } else if (i == 35) { // pull self up
+        input.Set(Input::PullLedge, true);
+    } else if (i == 36) { // standing on ledge that I climbed up
+        input.Set(Input::PullLedge, false);
+        input.Set(Input::OnGround, true);
+        input.Set(Input::GrabbingLedge, false);
+    }
+}
 
 int main() {
     DefineTypes();
@@ -140,18 +189,29 @@ int main() {
     def.AddState(anim::StateDefinition("falling", Load("falling", 14), One));
     def.AddState(anim::StateDefinition("landing", Load("landing", 15), One));
 
-    def.AddTransition(anim::Transition("grounded", OnGround));
-    def.AddTransition(anim::Transition("falling", IsFalling));
-    def.AddTransition(anim::Transition("grounded", "jumping", Jumped, true, anim::Options{.transition={.time=0}})); // player jumped
-    def.AddTransition(anim::Transition("grounded", "falling", IsFalling, true, anim::Options{.transition={.time=0}})); // player walked off edge
-    def.AddTransition(anim::Transition("jumping", "falling", IsFalling, true, anim::Options{.transition={.time=0}})); // player reached peak of jump, starting to fall
-    def.AddTransition(anim::Transition("falling", "landing", OnGround, true, anim::Options{.transition={.time=0}})); // player hit ground, land
-    def.AddTransition(anim::Transition("landing", "grounded", false)); // land to grounded right away
-    def.AddTransition(anim::Transition("grounded", "ledgeGrab", LedgeGrabbed, true, anim::Options{.transition={.time=0}})); // player walked up to ledge
-    def.AddTransition(anim::Transition("ledgeGrab", "ledge", false)); // player now climbing
-    def.AddTransition(anim::Transition("ledge", "ledgePullUp", LedgePulled, true, anim::Options{.transition={.time=0}})); // player reached top of edge and wants to go up
-    def.AddTransition(anim::Transition("ledgePullUp", "grounded", false)); // finished getting to top of ledge, now grounded
-    def.AddTransition(anim::Transition("ledge", "landing", LedgeLetGo, true, anim::Options{.transition={.time=0}})); // player was climbing but let go
+    // The same machine without watching transitions, to compare against.
+    auto unwatchedDef = def;
+    auto addTransitions = [](anim::MachineDefinition& def, bool watch) {
+        auto watching = [watch](uint64_t watches) -> uint64_t { return watch ? watches : 0; };
+        auto onGround = watching(state::Watch(Input::OnGround));
+        auto falling = watching(state::Watch(Input::FallingSpeed, Input::OnGround));
+        auto ledge = watching(state::Watch(Input::GrabbingLedge, Input::OnGround));
+
+        def.AddTransition(anim::Transition("grounded", OnGround).Watching(onGround));
+        def.AddTransition(anim::Transition("falling", IsFalling).Watching(falling));
+        def.AddTransition(anim::Transition("grounded", "jumping", Jumped, true, anim::Options{.transition={.time=0}}).Watching(watching(state::Watch(Input::Jump)))); // player jumped
+        def.AddTransition(anim::Transition("grounded", "falling", IsFalling, true, anim::Options{.transition={.time=0}}).Watching(falling)); // player walked off edge
+        def.AddTransition(anim::Transition("jumping", "falling", IsFalling, true, anim::Options{.transition={.time=0}}).Watching(falling)); // player reached peak of jump, starting to fall
+        def.AddTransition(anim::Transition("falling", "landing", OnGround, true, anim::Options{.transition={.time=0}}).Watching(onGround)); // player hit ground, land
+        def.AddTransition(anim::Transition("landing", "grounded", false)); // land to grounded right away
+        def.AddTransition(anim::Transition("grounded", "ledgeGrab", LedgeGrabbed, true, anim::Options{.transition={.time=0}}).Watching(watching(state::Watch(Input::GrabbingLedge)))); // player walked up to ledge
+        def.AddTransition(anim::Transition("ledgeGrab", "ledge", false)); // player now climbing
+        def.AddTransition(anim::Transition("ledge", "ledgePullUp", LedgePulled, true, anim::Options{.transition={.time=0}}).Watching(watching(state::Watch(Input::PullLedge)))); // player reached top of edge and wants to go up
+        def.AddTransition(anim::Transition("ledgePullUp", "grounded", false)); // finished getting to top of ledge, now grounded
+        def.AddTransition(anim::Transition("ledge", "landing", LedgeLetGo, true, anim::Options{.transition={.time=0}}).Watching(ledge)); // player was climbing but let go
+    };
+    addTransitions(def, true);
+    addTransitions(unwatchedDef, false);
     
     auto animator = anim::Animator{};
     animator.Init("position", TFloat);
@@ -174,38 +234,8 @@ int main() {
     // [36-xx] you pulled yourself up and are standing idly
 
     for (int i = 0; i < 40; i++) {
-        auto& input = machine.GetInput();
-
-        if (i == 5) { // walk
-            input->Set(Input::ForwardSpeed, 0.5f);
-        } else if (i == 10) { // run
-            input->Set(Input::ForwardSpeed, 1.0f);
-        } else if (i == 20) { // jump
-            input->Set(Input::Jump, true);
-            input->Set(Input::FallingSpeed, 1.0f);
-            input->Set(Input::OnGround, false);
-        } else if (i > 20 && i < 30) { // up & down
-            input->Set(Input::Jump, false);
-            input->Set(Input::FallingSpeed, input->Get(Input::FallingSpeed) - 0.2f);
-        } else if (i == 30) { // land
-            input->Set(Input::OnGround, true);
-            input->Set(Input::FallingSpeed, 0.0f);
-        } else if (i == 32) { // climb up and left
-            input->Set(Input::GrabbingLedge, true);
-            input->Set(Input::OnGround, false);
-            input->Set(Input::SideSpeed, -1.0f);
-            input->Set(Input::ForwardSpeed, 1.0f);
-        } else if (i == 34) { // pause climbing
-            input->Set(Input::SideSpeed, 0.0f);
-            input->Set(Input::ForwardSpeed, 0.0f);
-        } else if (i == 35) { // pull self up
-            input->Set(Input::PullLedge, true);
-        } else if (i == 36) { // standing on ledge that I climbed up
-            input->Set(Input::PullLedge, false);
-            input->Set(Input::OnGround, true);
-            input->Set(Input::GrabbingLedge, false);
-        }
-        
+        Script(*machine.GetInput(), i);
+
         // LogLevel = i >= 33 && i <= 36 ? debug : none;
 
         machine.Update(update);
@@ -213,6 +243,350 @@ int main() {
         std::cout << "Frame[" << i << "]: " << animator << std::endl;
     }
 
+    // Compiled tracks sample the same as the points they were compiled from, sequentially and when seeking.
+    auto original = LoadLong("long", 1000);
+    auto compiled = original;
+    auto compiledCount = anim::Compile(compiled);
+    auto uncompiled = anim::Animator{};
+    auto tracked = anim::Animator{};
+    uncompiled.Init("position", TFloat);
+    tracked.Init("position", TFloat);
+    uncompiled.Play(original);
+    tracked.Play(compiled);
+    auto matches = 0;
+    auto frames = 0;
+    for (auto dt : {0.001f, 0.003f, 0.016f, 0.5f, 0.016f, 1.7f, 0.0f, 3.9f, 0.016f, 0.25f}) {
+        for (int i = 0; i < 20; i++, frames++) {
+            uncompiled.Update(dt);
+            tracked.Update(dt);
+            matches += uncompiled.Get("position").Get<float>() == tracked.Get("position").Get<float>();
+        }
+    }
+    std::cout << "[compiled track    ] expected: 1 200, actual: " << compiledCount << " " << matches << std::endl;
+    std::cout << "[compiled track not] expected: 0 0, actual: " << (anim::Track::Compile({}) != nullptr) << " " << (anim::Track::Compile({{.time=1.0f, .data=TFloat->New(1.0f)}, {.time=0.0f, .data=TFloat->New(0.0f)}}) != nullptr) << std::endl;
+
+    // Updating animators doesn't allocate, including when animators finish and are removed.
+    auto noAlloc = anim::Animator{};
+    noAlloc.Init("position", TFloat);
+    auto once = Load("once");
+    once.options.repeat = 1;
+    noAlloc.Play(compiled);
+    noAlloc.Play(original);
+    noAlloc.Play(once);
+    noAlloc.Update(0.01f);
+    size_t allocationsBefore = Allocations;
+    for (int i = 0; i < 200; i++) {
+        noAlloc.Update(0.016f);
+    }
+    std::cout << "[update no allocs  ] expected: 0 2, actual: " << (Allocations - allocationsBefore) << " " << noAlloc.attributes.GetAttribute("position")->animators.size() << std::endl;
+
+    // References from Get stay valid when more attributes are added after them.
+    auto growing = anim::Animator{};
+    growing.Init("x", TFloat);
+    auto x = growing.Get("x");
+    for (int i = 0; i < 20; i++) {
+        growing.Init("grow" + std::to_string(i), TFloat);
+    }
+    growing.Get("x").Set(3.0f);
+    std::cout << "[get after growth  ] expected: 3.00 1, actual: " << x.Get<float>() << " " << (x.Data() == growing.Get("x").Data()) << std::endl;
+
+    // Work pools run every index of a range exactly once.
+    auto work = WorkPool(4);
+    auto visits = std::vector<int>(1000);
+    work.For(visits.size(), 7, [&visits](size_t start, size_t end) {
+        for (auto i = start; i < end; i++) {
+            visits[i]++;
+        }
+    });
+    std::cout << "[work pool for     ] expected: 1 1 4, actual: " << *std::min_element(visits.begin(), visits.end()) << " " << *std::max_element(visits.begin(), visits.end()) << " " << work.Threads() << std::endl;
+
+    // Pooled animators update in parallel to the same values as animators updated one after another.
+    auto animations = std::vector<anim::Animation>{original, compiled, Load("a", 1), Load("b", 2)};
+    auto pool = anim::AnimatorPool(&work, 3);
+    auto serial = std::vector<anim::Animator>(40);
+    for (size_t i = 0; i < serial.size(); i++) {
+        auto& pooled = pool.Add();
+        pooled.Init("position", TFloat);
+        serial[i].Init("position", TFloat);
+        pooled.Play(animations[i % animations.size()]);
+        serial[i].Play(animations[i % animations.size()]);
+    }
+    pool.Group();
+    auto poolMatches = 0;
+    auto deferMatches = 0;
+    for (int frame = 0; frame < 30; frame++) {
+        auto dt = 0.01f * (frame % 5 + 1);
+        pool.Update(dt);
+        // Deferred updates (what Apply does) run in order per animator.
+        for (size_t i = 0; i < serial.size(); i += 2) {
+            pool[i].Update(dt);
+            pool[i].Update(dt * 0.5f);
+        }
+        pool.Flush();
+        for (size_t i = 0; i < serial.size(); i++) {
+            serial[i].Update(dt);
+            if (i % 2 == 0) {
+                serial[i].Update(dt);
+                serial[i].Update(dt * 0.5f);
+            }
+            auto same = pool[i].Get("position").Get<float>() == serial[i].Get("position").Get<float>();
+            poolMatches += same && i % 2 == 1;
+            deferMatches += same && i % 2 == 0;
+        }
+    }
+    std::cout << "[animator pool     ] expected: 600 600, actual: " << poolMatches << " " << deferMatches << std::endl;
+
+    // Level of detail throttles, freezes, and skips small animations while counting the work skipped.
+    auto full = anim::Animator{};
+    auto throttledAnimator = anim::Animator{};
+    auto frozen = anim::Animator{};
+    auto small = anim::Animator{};
+    for (auto lodAnimator : {&full, &throttledAnimator, &frozen, &small}) {
+        lodAnimator->Init("position", TFloat);
+        lodAnimator->Play(original, anim::AnimationOptions{.scale = lodAnimator == &small ? 0.25f : 1.0f});
+    }
+    throttledAnimator.lod.interval = 0.0625f;
+    frozen.lod.frozen = true;
+    small.SetLOD("position", anim::LevelOfDetail{.minScale = 0.5f});
+    auto lodNear = 0;
+    for (int i = 0; i < 100; i++) {
+        for (auto lodAnimator : {&full, &throttledAnimator, &frozen, &small}) {
+            lodAnimator->Update(0.015625f);
+        }
+        lodNear += i % 4 == 3 && full.Get("position").Get<float>() == throttledAnimator.Get("position").Get<float>();
+    }
+    std::cout << "[lod throttled     ] expected: 25 100 75 25, actual: " << lodNear << " " << throttledAnimator.stats.updates << " " << throttledAnimator.stats.throttled << " " << throttledAnimator.stats.samples << std::endl;
+    std::cout << "[lod frozen        ] expected: 0 100 0, actual: " << frozen.Get("position").Get<float>() << " " << frozen.stats.frozen << " " << frozen.stats.samples << std::endl;
+    std::cout << "[lod small scale   ] expected: 0 100 0, actual: " << small.Get("position").Get<float>() << " " << small.stats.skippedScale << " " << small.stats.samples << std::endl;
+
+    // Batched machines step to the same states & values as machines updated on their own.
+    const size_t batchSize = 24;
+    auto batch = anim::MachineBatch(&def, batchSize, &work, 5);
+    auto batchAnimators = std::vector<anim::Animator>(batchSize);
+    auto singleAnimators = std::vector<anim::Animator>(batchSize);
+    auto singles = std::vector<std::unique_ptr<anim::Machine>>();
+    for (size_t k = 0; k < batchSize; k++) {
+        for (auto subject : {&batchAnimators[k], &singleAnimators[k]}) {
+            subject->Init("position", TFloat);
+            subject->minTotalScale = 1.0f;
+        }
+        batch.Add(batchAnimators[k]);
+        singles.push_back(std::make_unique<anim::Machine>(&def, singleAnimators[k]));
+        singles.back()->Init(update);
+    }
+    batch.Init(update);
+    auto batchMatches = 0;
+    for (int i = 0; i < 40; i++) {
+        for (size_t k = 0; k < batchSize; k++) {
+            // Each instance runs the script starting at a different frame.
+            Script(batch.Input(k), (i + k) % 40);
+            Script(*singles[k]->GetInput(), (i + k) % 40);
+            singles[k]->Update(update);
+            singles[k]->Apply(update);
+        }
+        if (i % 2 == 0) {
+            batch.Step(update);
+        } else {
+            batch.Update(update);
+            batch.Apply(update);
+        }
+        for (size_t k = 0; k < batchSize; k++) {
+            auto batched = std::stringstream();
+            auto single = std::stringstream();
+            batched << batchAnimators[k];
+            single << singleAnimators[k];
+            batchMatches += batched.str() == single.str();
+        }
+    }
+    std::cout << "[machine batch     ] expected: 960 " << batchSize << ", actual: " << batchMatches << " " << batch.Size() << std::endl;
+
+    // Watching transitions step the same as evaluating every condition, but only re-evaluate when the input changes.
+    auto watchedAnimator = anim::Animator{};
+    auto unwatchedAnimator = anim::Animator{};
+    for (auto subject : {&watchedAnimator, &unwatchedAnimator}) {
+        subject->Init("position", TFloat);
+        subject->minTotalScale = 1.0f;
+    }
+    auto watchedMachine = anim::Machine(&def, watchedAnimator);
+    auto unwatchedMachine = anim::Machine(&unwatchedDef, unwatchedAnimator);
+    watchedMachine.Init(update);
+    unwatchedMachine.Init(update);
+    auto watchedMatches = 0;
+    size_t watchedConditions = 0;
+    size_t unwatchedConditions = 0;
+    size_t idleConditions = 0;
+    for (int i = 0; i < 50; i++) {
+        for (auto watchMachine : {&watchedMachine, &unwatchedMachine}) {
+            Script(*watchMachine->GetInput(), i);
+            size_t before = Conditions;
+            watchMachine->Update(update);
+            watchMachine->Apply(update);
+            (watchMachine == &watchedMachine ? watchedConditions : unwatchedConditions) += Conditions - before;
+            if (watchMachine == &watchedMachine && i >= 40) {
+                idleConditions += Conditions - before;
+            }
+        }
+        auto watched = std::stringstream();
+        auto unwatched = std::stringstream();
+        watched << watchedAnimator;
+        unwatched << unwatchedAnimator;
+        watchedMatches += watched.str() == unwatched.str();
+    }
+    std::cout << "[watch transitions ] expected: 50 1 0, actual: " << watchedMatches << " " << (watchedConditions < unwatchedConditions) << " " << idleConditions << std::endl;
+
+    // Once running, updating & applying machines doesn't allocate whether or not conditions are evaluated.
+    size_t machineAllocationsBefore = Allocations;
+    for (int i = 50; i < 60; i++) {
+        for (auto watchMachine : {&watchedMachine, &unwatchedMachine}) {
+            Script(*watchMachine->GetInput(), i);
+            watchMachine->Update(update);
+            watchMachine->Apply(update);
+        }
+    }
+    std::cout << "[machine no allocs ] expected: 0, actual: " << (Allocations - machineAllocationsBefore) << std::endl;
+
+    // Applying at most AppliedMax states keeps the ones with the highest priority, ties in the order of the states.
+    auto priorityDef = anim::NewDefinition(initialInput, anim::MachineOptions{
+        .AppliedMax = 2, 
+        .AppliedPriority = [](const anim::State& a, const anim::State& b) -> bool { return a.GetEffect().scale.Get(0) > b.GetEffect().scale.Get(0); },
+        .FullyActive = true
+    });
+    auto priorities = std::vector<float>{0.2f, 0.9f, 0.5f, 0.9f};
+    for (size_t k = 0; k < priorities.size(); k++) {
+        priorityDef.AddState(anim::StateDefinition(std::string(1, char('a' + k)), Load("priority", k), anim::AnimationOptions{.scale = priorities[k]}));
+    }
+    auto priorityAnimator = anim::Animator{};
+    priorityAnimator.Init("position", TFloat);
+    auto priorityMachine = anim::Machine(&priorityDef, priorityAnimator);
+    priorityMachine.Init(update);
+    priorityMachine.Update(update);
+    priorityMachine.Apply(update);
+    auto applied = std::string();
+    for (auto state : priorityMachine.GetApplicable()) {
+        applied += state->GetDefinition()->GetID();
+    }
+    std::cout << "[applied priority  ] expected: bd, actual: " << applied << std::endl;
+
+    // Fixed user states store properties inline, so copies don't allocate.
+    auto fixedInput = state::BasicUserState<8>(7);
+    fixedInput.Set(Input::OnGround, true);
+    fixedInput.Set(Input::ForwardSpeed, 0.75f);
+    auto fixedRunning = state::And(state::When(Input::OnGround), state::When(Input::ForwardSpeed, state::Compare::Greater, 0.5f));
+    size_t fixedAllocationsBefore = Allocations;
+    auto fixedCopy = fixedInput;
+    fixedCopy.Set(Input::Jump, true);
+    auto fixedResult = fixedRunning(fixedCopy, update);
+    size_t fixedAllocations = Allocations - fixedAllocationsBefore;
+    std::cout << "[fixed user state  ] expected: 0 1 1 0 1, actual: " << fixedAllocations << " " << fixedResult << " " << fixedCopy.Get(Input::Jump) << " " << fixedInput.Get(Input::Jump) << " " << (fixedCopy.Changes() == state::Watch(Input::OnGround, Input::ForwardSpeed, Input::Jump)) << std::endl;
+
+    // Compiled conditions match the same condition built from functions, one input at a time and in a batch.
+    using state::Compare;
+    auto condition = state::Or(
+        state::And(state::When(Input::OnGround), state::When(Input::ForwardSpeed, Compare::Greater, 0.5f), state::Not(state::When(Input::Jump))),
+        state::And(state::When(Input::FallingSpeed, Compare::Less, 0.0f), state::Not(state::When(Input::GrabbingLedge), state::When(Input::PullLedge))),
+        state::When(Input::SideSpeed, Compare::LessEqual, -0.5f)
+    );
+    auto is = [](auto prop) { return [prop](const state::UserState& i, const state::UserState& u) { return i.Get(prop); }; };
+    auto functions = state::Or(
+        state::And(is(Input::OnGround), [](const state::UserState& i, const state::UserState& u) { return i.Get(Input::ForwardSpeed) > 0.5f; }, state::Not(is(Input::Jump))),
+        state::And([](const state::UserState& i, const state::UserState& u) { return i.Get(Input::FallingSpeed) < 0.0f; }, state::Not(is(Input::GrabbingLedge), is(Input::PullLedge))),
+        [](const state::UserState& i, const state::UserState& u) { return i.Get(Input::SideSpeed) <= -0.5f; }
+    );
+    auto compiledDef = anim::NewDefinition(initialInput);
+    compiledDef.AddState(anim::StateDefinition("a", Load("a", 0), One));
+    compiledDef.AddState(anim::StateDefinition("b", Load("b", 1), One));
+    compiledDef.AddTransition(anim::Transition("a", "b", condition, true, anim::Options{}));
+    auto& compiledTrans = compiledDef.GetState("a")->GetTransitions()[0];
+    auto compiledInputs = std::vector<state::UserState>(256, initialInput);
+    for (size_t k = 0; k < compiledInputs.size(); k++) {
+        auto& in = compiledInputs[k];
+        in.Set(Input::OnGround, (k & 1) != 0);
+        in.Set(Input::Jump, (k & 2) != 0);
+        in.Set(Input::GrabbingLedge, (k & 4) != 0);
+        in.Set(Input::PullLedge, (k & 8) != 0);
+        in.Set(Input::ForwardSpeed, float(k % 5) * 0.25f);
+        in.Set(Input::FallingSpeed, float(k % 3) - 1.0f);
+        in.Set(Input::SideSpeed, float(k % 7) * -0.25f);
+    }
+    auto compiledCache = state::ConditionCache<anim::StateTypes>(&compiledDef);
+    compiledCache.Evaluate(compiledInputs.data(), compiledInputs.size(), update, &work, 48);
+    auto compiledColumn = compiledCache.Base(&compiledDef) + compiledTrans.GetIndex();
+    auto compiledMatches = 0;
+    auto compiledTrue = 0;
+    for (size_t k = 0; k < compiledInputs.size(); k++) {
+        auto expected = functions(compiledInputs[k], update);
+        compiledMatches += condition(compiledInputs[k], update) == expected && compiledCache.Lookup(compiledColumn, k) == int(expected);
+        compiledTrue += expected;
+    }
+    auto compiledWatches = state::Watch(Input::OnGround, Input::Jump, Input::GrabbingLedge, Input::PullLedge, Input::ForwardSpeed, Input::FallingSpeed, Input::SideSpeed);
+    std::cout << "[compiled condition] expected: 256 1 1 15 4, actual: " << compiledMatches << " " << (compiledTrue > 0 && compiledTrue < 256) << " " << (compiledTrans.GetWatches() == compiledWatches) << " " << condition.GetProgram().Size() << " " << condition.GetProgram().Depth() << std::endl;
+
+    // Batched machines with compiled conditions look up the results evaluated for the whole batch, and reach the same
+    // states as machines updated on their own.
+    auto compiledBatchDef = anim::NewDefinition(initialInput, anim::MachineOptions{.ProcessQueueImmediately = true});
+    compiledBatchDef.AddState(anim::StateDefinition("a", Load("a", 0), One));
+    compiledBatchDef.AddState(anim::StateDefinition("b", Load("b", 1), One));
+    compiledBatchDef.AddTransition(anim::Transition("a"));
+    compiledBatchDef.AddTransition(anim::Transition("a", "b", condition, true, anim::Options{}));
+    compiledBatchDef.AddTransition(anim::Transition("b", "a", state::Not(condition), true, anim::Options{}));
+    const size_t compiledBatchSize = 150;
+    auto compiledBatch = anim::MachineBatch(&compiledBatchDef, compiledBatchSize, &work, 5);
+    auto compiledBatchAnimators = std::vector<anim::Animator>(compiledBatchSize);
+    auto compiledSingleAnimators = std::vector<anim::Animator>(compiledBatchSize);
+    auto compiledSingles = std::vector<std::unique_ptr<anim::Machine>>();
+    for (size_t k = 0; k < compiledBatchSize; k++) {
+        compiledBatch.Add(compiledBatchAnimators[k]);
+        compiledSingles.push_back(std::make_unique<anim::Machine>(&compiledBatchDef, compiledSingleAnimators[k]));
+        compiledSingles.back()->Init(update);
+    }
+    compiledBatch.Init(update);
+    auto compiledBatchMatches = 0;
+    auto compiledBatchInB = 0;
+    for (int i = 0; i < 20; i++) {
+        for (size_t k = 0; k < compiledBatchSize; k++) {
+            auto& from = compiledInputs[(k * 3 + i) % compiledInputs.size()];
+            compiledBatch.Input(k) = from;
+            *compiledSingles[k]->GetInput() = from;
+            compiledSingles[k]->Update(update);
+            compiledSingles[k]->Apply(update);
+        }
+        compiledBatch.Step(update);
+        for (size_t k = 0; k < compiledBatchSize; k++) {
+            auto batched = compiledBatch[k].GetActive().back().GetDefinition()->GetID();
+            compiledBatchMatches += batched == compiledSingles[k]->GetActive().back().GetDefinition()->GetID();
+            compiledBatchInB += batched == "b";
+        }
+    }
+    auto compiledBatchCache = state::ConditionCache<anim::StateTypes>(&compiledBatchDef);
+    std::cout << "[compiled batch    ] expected: 3000 1 0 3, actual: " << compiledBatchMatches << " " << (compiledBatchInB > 0 && compiledBatchInB < 3000) << " " << compiledBatchCache.Base(&compiledBatchDef) << " " << compiledBatchCache.Columns() << std::endl;
+
+    // Root machines sharing an input each see every change to it.
+    auto sharedInput = std::make_shared<state::UserState>(compiledInputs[0]);
+    auto sharedAnimators = std::vector<anim::Animator>(2);
+    auto sharedFirst = anim::Machine(&compiledBatchDef, sharedAnimators[0], sharedInput);
+    auto sharedSecond = anim::Machine(&compiledBatchDef, sharedAnimators[1], sharedInput);
+    sharedFirst.Init(update);
+    sharedSecond.Init(update);
+    auto sharedMatches = 0;
+    for (size_t k = 0; k < compiledInputs.size(); k++) {
+        *sharedInput = compiledInputs[k];
+        auto expected = std::string(functions(compiledInputs[k], update) ? "b" : "a");
+        for (auto machine : {&sharedFirst, &sharedSecond}) {
+            machine->Update(update);
+            machine->Apply(update);
+            sharedMatches += machine->GetActive().back().GetDefinition()->GetID() == expected;
+        }
+    }
+    std::cout << "[shared input      ] expected: 512, actual: " << sharedMatches << std::endl;
+
+    // Programs with too many tests for a table of results branch instead, and agree with the table.
+    auto wideCondition = state::And(condition, condition);
+    auto wideMatches = 0;
+    for (size_t k = 0; k < compiledInputs.size(); k++) {
+        wideMatches += wideCondition(compiledInputs[k], update) == condition(compiledInputs[k], update);
+    }
+    std::cout << "[compiled wide     ] expected: 256 1, actual: " << wideMatches << " " << (wideCondition.GetProgram().Tests() > state::Program::TableTests) << std::endl;
+
     // Thoughts:
     // - I don't like many of the pointers in state.h. I tried to store defs as references but then those types couldn't be used in containers. I feel like shared_ptr is better, but it feels heavy to me.
     // - The above code uses maps. There are more efficient structures that could be used. In previous implementations something like AddState would return an identifier that could be used in AddTransition. It was a simple auto-incrementing value. But what about attributes & animations?
@@ -0,0 +1,821 @@
+// Repeatable benchmarks for id, types, calc, anim, state and serial. Every benchmark is a fixed
+// workload so results can be compared between releases. Results are written as JSON.
+//
+// Usage: bench [--filter text] [--samples n] [--out path]
+// - filter: only runs benchmarks whose name contains text.
+// - samples: how many timed samples to take of each benchmark (default 7), the median is reported.
+// - out: writes the JSON to the path instead of stdout.
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <algorithm>
+#include <memory>
+
+#include "../include/id.h"
+#include "../include/anim.h"
+#include "../include/serial.h"
+
+// Harness
+
+// Keeps the compiler from optimizing away a result.
+template<typename T>
+inline void Keep(T&& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "g"(&value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+struct BenchResult {
+    std::string name;
+    // How many operations one run of the workload does.
+    size_t ops;
+    // How many runs of the workload each sample timed.
+    size_t runs;
+    size_t samples;
+    double medianNsPerOp;
+    double minNsPerOp;
+    double maxNsPerOp;
+};
+
+struct BenchOptions {
+    std::string filter;
+    size_t samples = 7;
+    // The least amount of time a sample should take, runs are added until it does.
+    double minSampleNs = 20000000;
+};
+
+std::vector<BenchResult> results;
+BenchOptions options;
+
+// Runs the workload (which does the given number of operations per call) enough times
+// to get stable samples and records the nanoseconds per operation.
+template<typename Fn>
+void Bench(const std::string& name, size_t ops, Fn&& workload) {
+    if (!options.filter.empty() && name.find(options.filter) == std::string::npos) {
+        return;
+    }
+    auto time = [&workload](size_t runs) {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t r = 0; r < runs; r++) {
+            workload();
+        }
+        auto end = std::chrono::steady_clock::now();
+        return double(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+    };
+
+    // Warm up and find how many runs fill a sample.
+    size_t runs = 1;
+    auto elapsed = time(runs);
+    while (elapsed < options.minSampleNs && runs < (size_t(1) << 30)) {
+        runs = elapsed <= 0 ? runs * 10 : std::max(runs + 1, size_t(double(runs) * options.minSampleNs * 1.2 / elapsed));
+        elapsed = time(runs);
+    }
+
+    auto perOp = std::vector<double>();
+    for (size_t s = 0; s < options.samples; s++) {
+        perOp.push_back(time(runs) / double(runs * ops));
+    }
+    std::sort(perOp.begin(), perOp.end());
+
+    results.push_back(BenchResult{name, ops, runs, perOp.size(), perOp[perOp.size() / 2], perOp.front(), perOp.back()});
+    std::cerr << std::left << std::setw(40) << name << std::right << std::fixed << std::setprecision(2) << std::setw(12) << results.back().medianNsPerOp << " ns/op" << std::endl;
+}
+
+// Escapes the characters JSON requires in a string.
+std::string JsonString(const std::string& s) {
+    auto out = std::string("\"");
+    for (auto c : s) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            default: out += c;
+        }
+    }
+    return out + "\"";
+}
+
+void WriteJson(std::ostream& os) {
+    os << std::setprecision(4) << std::fixed;
+    os << "{" << std::endl;
+    os << "  \"context\": {" << std::endl;
+#if defined(__VERSION__)
+    os << "    \"compiler\": " << JsonString(__VERSION__) << "," << std::endl;
+#endif
+    os << "    \"samples\": " << options.samples << "," << std::endl;
+    os << "    \"page_power\": " << PAGE_POWER << std::endl;
+    os << "  }," << std::endl;
+    os << "  \"benchmarks\": [" << std::endl;
+    for (size_t i = 0; i < results.size(); i++) {
+        auto& r = results[i];
+        os << "    {\"name\": " << JsonString(r.name)
+           << ", \"ops\": " << r.ops
+           << ", \"runs\": " << r.runs
+           << ", \"samples\": " << r.samples
+           << ", \"ns_per_op\": " << r.medianNsPerOp
+           << ", \"min_ns_per_op\": " << r.minNsPerOp
+           << ", \"max_ns_per_op\": " << r.maxNsPerOp << "}"
+           << (i + 1 < results.size() ? "," : "") << std::endl;
+    }
+    os << "  ]" << std::endl;
+    os << "}" << std::endl;
+}
+
+// Types
+
+struct Vec {
+    float x, y;
+};
+
+struct Sprite {
+    float angle;
+    Vec position;
+    Vec size;
+    int frame;
+};
+
+template<>
+constexpr Vec calc::Adds(const Vec& a, const Vec& b, float scale) {
+    return Vec{.x = a.x + b.x * scale, .y = a.y + b.y * scale};
+}
+template<>
+constexpr Vec calc::Mul(const Vec& a, const Vec& b) {
+    return Vec{.x = a.x * b.x, .y = a.y * b.y};
+}
+template<>
+constexpr Vec calc::Div(const Vec& a, const Vec& b) {
+    return Vec{.x = calc::Div<float>(a.x, b.x), .y = calc::Div<float>(a.y, b.y)};
+}
+template<>
+constexpr bool calc::IsLess(const Vec& a, const Vec& b) {
+    return a.x < b.x ? true : a.y < b.y;
+}
+template<>
+constexpr float calc::Dot(const Vec& a, const Vec& b) {
+    return a.x * b.x + a.y * b.y;
+}
+template<>
+constexpr int calc::Components<Vec>() {
+    return 2;
+}
+template<>
+constexpr float calc::Get(const Vec& a, int index) {
+    switch (index) {
+        case 0: return a.x;
+        case 1: return a.y;
+    }
+    return 0.0f;
+}
+template<>
+constexpr void calc::Set(Vec& a, int index, float value) {
+    switch (index) {
+        case 0: a.x = value; break;
+        case 1: a.y = value; break;
+    }
+}
+
+auto TInt    = types::New<int>("int");
+auto TFloat  = types::New<float>("float");
+auto TVec    = types::New<Vec>("vec");
+auto TSprite = types::New<Sprite>("sprite");
+auto TSprites = types::New<std::vector<Sprite>>("sprites");
+
+void DefineTypes() {
+    TInt->Define(types::Def<int>()
+        .DefaultCreate()
+    );
+    TFloat->Define(types::Def<float>()
+        .DefaultCreate()
+        .ToString([](float s) -> std::string { return std::to_string(s); })
+    );
+    TVec->Define(types::Def<Vec>()
+        .DefaultCreate()
+        .Prop<float>("x", TFloat, [](auto v) -> auto { return &v->x; })
+        .Prop<float>("y", TFloat, [](auto v) -> auto { return &v->y; })
+    );
+    TSprite->Define(types::Def<Sprite>()
+        .DefaultCreate()
+        .Field("angle",    TFloat, &Sprite::angle)
+        .Field("position", TVec,   &Sprite::position)
+        .Field("size",     TVec,   &Sprite::size)
+        .Prop<int>("frame", TInt,  [](auto v) -> auto { return &v->frame; })
+    );
+    TSprites->Define(types::Def<std::vector<Sprite>>()
+        .DefaultCreate()
+        .Vector<Sprite>(TInt, TSprite, [](std::vector<Sprite>* s) -> std::vector<Sprite>* { return s; })
+    );
+
+    calc::Register<float>(TFloat);
+    calc::Register<Vec>(TVec);
+}
+
+// Workloads
+
+const size_t keyCount = 1024;
+std::vector<std::string> names;
+std::vector<id::Identifier> keys;
+
+void PopulateKeys() {
+    for (size_t i = 0; i < keyCount; i++) {
+        names.push_back("bench/key/" + std::to_string(i));
+        keys.push_back(names.back());
+    }
+}
+
+void BenchId() {
+    Bench("id/intern_new", keyCount, []() {
+        auto memory = id::Memory(PAGE_POWER);
+        for (auto& name : names) {
+            Keep(memory.Translate(name));
+        }
+    });
+    Bench("id/intern_existing", keyCount, []() {
+        for (auto& name : names) {
+            Keep(id::memory.Translate(name));
+        }
+    });
+    Bench("id/densemap_set", keyCount, []() {
+        auto m = id::DenseMap16<int>();
+        for (size_t i = 0; i < keyCount; i++) {
+            m.Set(keys[i], int(i));
+        }
+        Keep(m);
+    });
+    auto dense = id::DenseMap16<int>();
+    for (size_t i = 0; i < keyCount; i++) {
+        dense.Set(keys[i], int(i));
+    }
+    Bench("id/densemap_get", keyCount, [&dense]() {
+        auto sum = 0;
+        for (auto& key : keys) {
+            sum += dense.Get(key);
+        }
+        Keep(sum);
+    });
+    Bench("id/densemap_iterate", keyCount, [&dense]() {
+        auto sum = 0;
+        for (auto value : dense) {
+            sum += value;
+        }
+        Keep(sum);
+    });
+    Bench("id/densemap_set_remove", keyCount * 2, [&dense]() {
+        for (size_t i = 0; i < keyCount; i++) {
+            dense.Remove(keys[i], false);
+        }
+        for (size_t i = 0; i < keyCount; i++) {
+            dense.Set(keys[i], int(i));
+        }
+    });
+    Bench("id/densemap_set_remove_ordered", keyCount * 2, [&dense]() {
+        for (size_t i = 0; i < keyCount; i++) {
+            dense.Remove(keys[(i * 7) % keyCount], true);
+        }
+        for (size_t i = 0; i < keyCount; i++) {
+            dense.Set(keys[i], int(i));
+        }
+    });
+    Bench("id/sparsemap_set", keyCount, []() {
+        auto m = id::SparseMap16<int>();
+        for (size_t i = 0; i < keyCount; i++) {
+            m.Set(keys[i], int(i));
+        }
+        Keep(m);
+    });
+    auto sparse = id::SparseMap16<int>();
+    for (size_t i = 0; i < keyCount; i++) {
+        sparse.Set(keys[i], int(i));
+    }
+    Bench("id/sparsemap_get", keyCount, [&sparse]() {
+        auto sum = 0;
+        for (auto& key : keys) {
+            sum += sparse.Get(key);
+        }
+        Keep(sum);
+    });
+}
+
+void BenchTypes() {
+    auto sprite = types::ValueOf(Sprite{45, Vec{1, 2}, Vec{3, 4}, 5});
+    Bench("types/value_prop_get", 1, [&sprite]() {
+        Keep(sprite.Prop("angle").Get<float>());
+    });
+    Bench("types/value_prop_nested_get", 1, [&sprite]() {
+        Keep(sprite.Prop("position").Prop("y").Get<float>());
+    });
+    auto angle = TSprite->Handle("angle");
+    Bench("types/value_prop_handle_get", 1, [&sprite, &angle]() {
+        Keep(sprite.Prop(angle).Get<float>());
+    });
+    auto frame = TSprite->Handle("frame");
+    Bench("types/value_prop_handle_get_function", 1, [&sprite, &frame]() {
+        Keep(sprite.Prop(frame).Get<int>());
+    });
+    Bench("types/value_prop_set", 1, [&sprite]() {
+        sprite.Prop("angle").Set(10.0f);
+    });
+
+    auto sprites = std::vector<Sprite>(keyCount, Sprite{45, Vec{1, 2}, Vec{3, 4}, 5});
+    auto spritesValue = types::ValueTo(&sprites, TSprites);
+    Bench("types/collection_iterate", keyCount, [&spritesValue]() {
+        auto sum = 0.0f;
+        spritesValue.Collection()->Iterate([&sum](types::Collection::iter_type* kv) -> bool {
+            sum += kv->value.Ptr<Sprite>()->angle;
+            return true;
+        });
+        Keep(sum);
+    });
+    Bench("types/collection_span", keyCount, [&spritesValue]() {
+        auto sum = 0.0f;
+        for (auto& sprite : spritesValue.Span().As<Sprite>()) {
+            sum += sprite.angle;
+        }
+        Keep(sum);
+    });
+}
+
+void BenchCalc() {
+    auto floats = calc::For(TFloat);
+    auto fa = TFloat->New(1.0f);
+    auto fb = TFloat->New(3.0f);
+    Bench("calc/lerp_float", 1, [&]() {
+        Keep(floats->Lerp(fa, fb, 0.25f));
+    });
+    auto vecs = calc::For(TVec);
+    auto va = TVec->New(Vec{1, 2});
+    auto vb = TVec->New(Vec{3, 4});
+    Bench("calc/lerp_vec", 1, [&]() {
+        Keep(vecs->Lerp(va, vb, 0.25f));
+    });
+    Bench("calc/adds_vec", 1, [&]() {
+        Keep(vecs->Adds(va, vb, 0.5f));
+    });
+
+    auto as = std::vector<Vec>(keyCount, Vec{1, 2});
+    auto bs = std::vector<Vec>(keyCount, Vec{3, 4});
+    auto ts = std::vector<float>(keyCount, 0.25f);
+    auto out = std::vector<Vec>(keyCount);
+    Bench("calc/lerp_vec_batched", keyCount, [&]() {
+        vecs->LerpN(as.data(), bs.data(), ts.data(), out.data(), keyCount);
+        Keep(out);
+    });
+    Bench("calc/adds_vec_batched", keyCount, [&]() {
+        vecs->AddsN(out.data(), bs.data(), ts.data(), out.data(), keyCount);
+        Keep(out);
+    });
+
+    // One view against many targets.
+    const size_t targetCount = 4096;
+    auto targets = std::vector<Vec>(targetCount);
+    auto radii = std::vector<float>(targetCount);
+    auto xs = std::vector<float>(targetCount), ys = std::vector<float>(targetCount);
+    for (size_t i = 0; i < targetCount; i++) {
+        targets[i] = Vec{float(int(i * 37) % 201 - 100), float(int(i * 91) % 173 - 86)};
+        radii[i] = float(i % 13) * 0.3f;
+        xs[i] = targets[i].x;
+        ys[i] = targets[i].y;
+    }
+    const float* components[2] = {xs.data(), ys.data()};
+    auto origin = Vec{0, 0};
+    auto direction = Vec{0.6f, 0.8f};
+    auto fovTan = tanf(0.5f), fovCos = cosf(0.5f);
+    auto mask = std::vector<uint64_t>(calc::MaskWords(targetCount));
+    Bench("calc/circle_in_view_single", targetCount, [&]() {
+        auto count = 0;
+        for (size_t i = 0; i < targetCount; i++) {
+            count += calc::IsCircleInView(origin, direction, fovTan, fovCos, targets[i], radii[i], false);
+        }
+        Keep(count);
+    });
+    Bench("calc/circles_in_view", targetCount, [&]() {
+        Keep(calc::CirclesInView(origin, direction, fovTan, fovCos, targets.data(), radii.data(), targetCount, false, mask.data()));
+    });
+    Bench("calc/circles_in_view_soa", targetCount, [&]() {
+        Keep(calc::CirclesInViewN<2>(&origin.x, &direction.x, fovTan, fovCos, components, radii.data(), targetCount, false, mask.data()));
+    });
+    Bench("calc/points_in_view_soa", targetCount, [&]() {
+        Keep(calc::PointsInViewN<2>(&origin.x, &direction.x, fovCos, components, targetCount, mask.data()));
+    });
+
+    // Sampling a spline many times.
+    float catmullRom[4][4] = {
+        { 0.0f,  1.0f,  0.0f,  0.0f},
+        {-0.5f,  0.0f,  0.5f,  0.0f},
+        { 1.0f, -2.5f,  2.0f, -0.5f},
+        {-0.5f,  1.5f, -1.5f,  0.5f},
+    };
+    auto splinePoints = std::vector<Vec>();
+    auto splineValues = std::vector<types::Value>();
+    for (int i = 0; i < 16; i++) {
+        splinePoints.push_back(Vec{float(i), float(i * 7 % 5)});
+        splineValues.push_back(TVec->New(splinePoints.back()));
+    }
+    auto splineDeltas = std::vector<float>(keyCount);
+    for (size_t i = 0; i < keyCount; i++) {
+        splineDeltas[i] = float(i) / float(keyCount);
+    }
+    Bench("calc/parametric_cubic_curve", keyCount, [&]() {
+        for (auto d : splineDeltas) {
+            Keep(calc::ParametricCubicCurve(d, splinePoints, catmullRom, 1.0f, false, false));
+        }
+    });
+    Bench("calc/parametric_cubic_curve_value", 1, [&]() {
+        Keep(vecs->ParametricCubicCurve(0.3f, splineValues, catmullRom, 1.0f, false, false));
+    });
+    auto compiled = calc::CompiledCurve<Vec>(splinePoints, catmullRom, 1.0f, false, false);
+    auto splineOut = std::vector<Vec>(keyCount);
+    Bench("calc/compiled_curve_batched", keyCount, [&]() {
+        compiled.EvaluateN(splineDeltas.data(), splineOut.data(), keyCount);
+        Keep(splineOut);
+    });
+
+    // Many pursuers leading their targets.
+    auto interceptors = std::vector<Vec>(targetCount);
+    auto velocities = std::vector<Vec>(targetCount);
+    auto speeds = std::vector<float>(targetCount);
+    auto vxs = std::vector<float>(targetCount), vys = std::vector<float>(targetCount);
+    auto zeros = std::vector<float>(targetCount, 0.0f);
+    for (size_t i = 0; i < targetCount; i++) {
+        velocities[i] = Vec{float(int(i * 3) % 9 - 4), float(int(i * 5) % 7 - 3)};
+        vxs[i] = velocities[i].x;
+        vys[i] = velocities[i].y;
+        speeds[i] = float(i % 6);
+    }
+    const float* interceptorComponents[2] = {zeros.data(), zeros.data()};
+    const float* velocityComponents[2] = {vxs.data(), vys.data()};
+    auto times = std::vector<float>(targetCount);
+    Bench("calc/intercept_time_single", targetCount, [&]() {
+        for (size_t i = 0; i < targetCount; i++) {
+            times[i] = calc::InterceptTime(interceptors[i], speeds[i], targets[i], velocities[i]);
+        }
+        Keep(times);
+    });
+    Bench("calc/intercept_times", targetCount, [&]() {
+        calc::InterceptTimes(interceptors.data(), speeds.data(), targets.data(), velocities.data(), times.data(), targetCount);
+        Keep(times);
+    });
+    Bench("calc/intercept_time_soa", targetCount, [&]() {
+        calc::InterceptTimeN<2>(interceptorComponents, speeds.data(), components, velocityComponents, times.data(), targetCount);
+        Keep(times);
+    });
+}
+
+// An animation of every attribute that loops forever.
+anim::Animation NewAnimation(const std::string& name, size_t attributeCount) {
+    auto animation = anim::Animation{
+        .name = name,
+        .options = {
+            .duration = 1.0f,
+            .repeat = -1,
+        },
+    };
+    for (size_t a = 0; a < attributeCount; a++) {
+        animation.attributes.push_back(anim::AnimationAttribute{
+            .attribute = "attribute" + std::to_string(a),
+            .points = {
+                {.time=0.0f, .data=TFloat->New(0.0f)},
+                {.time=0.5f, .data=TFloat->New(1.0f)},
+                {.time=1.0f, .data=TFloat->New(0.5f)}
+            }
+        });
+    }
+    return animation;
+}
+
+void BenchAnimatorUpdate(size_t attributeCount) {
+    auto animation = NewAnimation("loop", attributeCount);
+    auto animator = anim::Animator{};
+    for (auto& attr : animation.attributes) {
+        animator.Init(attr.attribute, TFloat);
+    }
+    animator.Play(animation);
+    Bench("anim/animator_update/" + std::to_string(attributeCount), attributeCount, [&animator]() {
+        animator.Update(1.0f / 60.0f);
+    });
+}
+
+void BenchAnimatorTrack(size_t pointCount, bool compile) {
+    auto animation = anim::Animation{
+        .name = "track",
+        .options = {.duration = 10.0f, .repeat = -1},
+        .attributes = {{.attribute = "attribute0"}},
+    };
+    for (size_t i = 0; i < pointCount; i++) {
+        animation.attributes[0].points.push_back({.time=float(i) / (pointCount - 1), .data=TFloat->New(float(i % 5))});
+    }
+    if (compile) {
+        anim::Compile(animation);
+    }
+    auto animator = anim::Animator{};
+    animator.Init("attribute0", TFloat);
+    animator.Play(animation);
+    Bench("anim/animator_track" + std::string(compile ? "_compiled/" : "/") + std::to_string(pointCount), 1, [&animator]() {
+        animator.Update(1.0f / 60.0f);
+    });
+}
+
+void BenchAnimatorPool(size_t animatorCount, size_t threads, bool lod = false) {
+    auto animation = NewAnimation("loop", 4);
+    auto work = WorkPool(threads);
+    auto pool = anim::AnimatorPool(&work, 64);
+    for (size_t i = 0; i < animatorCount; i++) {
+        auto& animator = pool.Add();
+        for (auto& attr : animation.attributes) {
+            animator.Init(attr.attribute, TFloat);
+        }
+        animator.Play(animation);
+        // A quarter of the animators are near and update every frame, half are further and update less often, and the rest are frozen.
+        if (lod) {
+            animator.lod = i % 4 == 0 ? anim::LevelOfDetail{} : i % 4 == 3 ? anim::LevelOfDetail{.frozen = true} : anim::LevelOfDetail{.interval = 0.1f};
+        }
+    }
+    auto name = std::string(lod ? "anim/animator_pool_update_lod/" : "anim/animator_pool_update/");
+    Bench(name + std::to_string(animatorCount) + "x" + std::to_string(work.Threads()), animatorCount, [&pool]() {
+        pool.Update(1.0f / 60.0f);
+    });
+}
+
+// Inputs of the benchmark machines.
+struct Input {
+    static const inline state::UserStateProperty<bool>  Moving = 0;
+    static const inline state::UserStateProperty<float> Speed = 1;
+};
+
+// How the benchmark machines are updated: one at a time, with their animators in a pool, or in a batch.
+enum class MachineMode { Single, Pooled, Batched };
+
+void BenchMachineUpdate(size_t machineCount, MachineMode mode = MachineMode::Single) {
+    auto idle = NewAnimation("idle", 2);
+    auto walk = NewAnimation("walk", 2);
+    auto input = state::UserState(2);
+    auto update = anim::NewUpdate();
+    update.Set(anim::Update::DeltaTime, 1.0f / 60.0f);
+
+    auto One = anim::AnimationOptions{ .scale = 1.0f };
+    auto def = anim::NewDefinition(input, anim::MachineOptions{.ProcessQueueImmediately = true});
+    def.AddState(anim::StateDefinition("idle", idle, One));
+    def.AddState(anim::StateDefinition("walk", walk, [](const state::UserState& i, const state::UserState& u) {
+        return anim::AnimationOptions{ .scale = i.Get(Input::Speed) };
+    }, true));
+    def.AddTransition(anim::Transition("idle"));
+    def.AddTransition(anim::Transition("idle", "walk", [](const state::UserState& i, const state::UserState& u) { return i.Get(Input::Moving); }, true, anim::Options{}));
+    def.AddTransition(anim::Transition("walk", "idle", [](const state::UserState& i, const state::UserState& u) { return !i.Get(Input::Moving); }, true, anim::Options{}));
+
+    auto work = WorkPool();
+    auto pool = anim::AnimatorPool(&work, 16);
+    auto batch = anim::MachineBatch(&def, machineCount, &work, 16);
+    auto animators = std::vector<anim::Animator>(mode == MachineMode::Pooled ? 0 : machineCount);
+    auto machines = std::vector<std::unique_ptr<anim::Machine>>();
+    for (size_t m = 0; m < machineCount; m++) {
+        auto& animator = mode == MachineMode::Pooled ? pool.Add() : animators[m];
+        for (auto& attr : idle.attributes) {
+            animator.Init(attr.attribute, TFloat);
+        }
+        animator.minTotalScale = 1.0f;
+        if (mode == MachineMode::Batched) {
+            batch.Add(animator);
+        } else {
+            machines.push_back(std::make_unique<anim::Machine>(&def, animator));
+            machines.back()->Init(update);
+        }
+    }
+    batch.Init(update);
+
+    // Machines switch between idle & walking every so often, at different times.
+    auto setInput = [](state::UserState& in, size_t frame, size_t m) {
+        in.Set(Input::Moving, ((frame + m) / 30) % 2 == 1);
+        in.Set(Input::Speed, float((frame + m) % 30) / 30.0f);
+    };
+    size_t frame = 0;
+    auto name = std::string(mode == MachineMode::Pooled ? "state/machine_update_pooled/" : mode == MachineMode::Batched ? "state/machine_update_batched/" : "state/machine_update/");
+    Bench(name + std::to_string(machineCount), machineCount, [&]() {
+        if (mode == MachineMode::Batched) {
+            for (size_t m = 0; m < batch.Size(); m++) {
+                setInput(batch.Input(m), frame, m);
+            }
+            batch.Step(update);
+        } else {
+            for (size_t m = 0; m < machines.size(); m++) {
+                auto& machine = *machines[m];
+                setInput(*machine.GetInput(), frame, m);
+                machine.Update(update);
+                machine.Apply(update);
+            }
+            pool.Flush();
+        }
+        frame++;
+    });
+}
+
+// Machines with 5 states that can each transition to any other on a compiled condition of 8 properties, updated one
+// at a time or in a batch where the conditions are evaluated together (see state::ConditionCache). The properties
+// change every frame, so every live transition of the active state is evaluated on every update.
+void BenchCompiledMachineUpdate(size_t machineCount, bool batched) {
+    using state::Compare;
+    auto p = [](int i) { return state::UserStateProperty<float>(i); };
+    auto input = state::UserState(8);
+    auto update = anim::NewUpdate();
+    update.Set(anim::Update::DeltaTime, 1.0f / 60.0f);
+
+    auto One = anim::AnimationOptions{ .scale = 1.0f };
+    auto def = anim::NewDefinition(input, anim::MachineOptions{.ProcessQueueImmediately = true});
+    auto names = std::vector<std::string>{"idle", "walk", "run", "jump", "fall"};
+    // The first property picks one of the states, so only one condition is true at a time.
+    auto band = [&p](int k) { return state::And(state::When(p(0), Compare::GreaterEqual, k * 0.2f), state::When(p(0), Compare::Less, (k + 1) * 0.2f)); };
+    auto conditions = std::vector<state::Condition>{
+        state::And(band(0), state::Or(state::When(p(1), Compare::Less, 0.5f), state::Not(state::When(p(2), Compare::Greater, 0.8f)))),
+        state::And(band(1), state::Or(state::When(p(3), Compare::Less, 0.5f), state::When(p(4), Compare::Greater, 0.1f))),
+        state::And(band(2), state::Or(state::When(p(4), Compare::Greater, 0.3f), state::When(p(5), Compare::Less, 0.7f))),
+        state::And(band(3), state::Or(state::When(p(6), Compare::Less, 0.5f), state::Not(state::When(p(7), Compare::Greater, 0.9f)))),
+        state::And(band(4), state::Or(state::When(p(7), Compare::Greater, 0.2f), state::When(p(3), Compare::GreaterEqual, 0.5f))),
+    };
+    auto animations = std::vector<anim::Animation>();
+    for (auto& name : names) {
+        animations.push_back(NewAnimation(name, 2));
+        def.AddState(anim::StateDefinition(name, animations.back(), One));
+    }
+    def.AddTransition(anim::Transition("idle"));
+    for (size_t from = 0; from < names.size(); from++) {
+        for (size_t to = 0; to < names.size(); to++) {
+            if (from != to) {
+                def.AddTransition(anim::Transition(names[from], names[to], conditions[to], true, anim::Options{}));
+            }
+        }
+    }
+
+    auto work = WorkPool();
+    auto batch = anim::MachineBatch(&def, machineCount, &work, 64);
+    auto animators = std::vector<anim::Animator>(machineCount);
+    auto machines = std::vector<std::unique_ptr<anim::Machine>>();
+    for (size_t m = 0; m < machineCount; m++) {
+        auto& animator = animators[m];
+        for (auto& attr : animations[0].attributes) {
+            animator.Init(attr.attribute, TFloat);
+        }
+        animator.minTotalScale = 1.0f;
+        if (batched) {
+            batch.Add(animator);
+        } else {
+            machines.push_back(std::make_unique<anim::Machine>(&def, animator));
+            machines.back()->Init(update);
+        }
+    }
+    batch.Init(update);
+
+    auto setInput = [&p](state::UserState& in, size_t frame, size_t m) {
+        for (int k = 0; k < 8; k++) {
+            in.Set(p(k), float((frame + m * 7 + k * 29) % 240) / 240.0f);
+        }
+    };
+    size_t frame = 0;
+    auto name = std::string(batched ? "state/machine_update_compiled_batched/" : "state/machine_update_compiled/");
+    Bench(name + std::to_string(machineCount), machineCount, [&]() {
+        if (batched) {
+            for (size_t m = 0; m < batch.Size(); m++) {
+                setInput(batch.Input(m), frame, m);
+            }
+            batch.Step(update);
+        } else {
+            for (size_t m = 0; m < machines.size(); m++) {
+                auto& machine = *machines[m];
+                setInput(*machine.GetInput(), frame, m);
+                machine.Update(update);
+                machine.Apply(update);
+            }
+        }
+        frame++;
+    });
+}
+
+// How the benchmark conditions are evaluated: nested functions, a compiled program, or a compiled program in a batch.
+enum class ConditionMode { Functions, Compiled, Batched };
+
+// A 10 term condition on 8 properties evaluated for many inputs.
+void BenchConditions(size_t inputCount, ConditionMode mode) {
+    using state::Compare;
+    using condition_type = anim::StateTypes::condition_type;
+    auto p = [](int i) { return state::UserStateProperty<float>(i); };
+    auto greater = [](int i, float v) -> condition_type { return [i, v](const state::UserState& in, const state::UserState& u) { return in.Get(state::UserStateProperty<float>(i)) > v; }; };
+    auto less = [](int i, float v) -> condition_type { return [i, v](const state::UserState& in, const state::UserState& u) { return in.Get(state::UserStateProperty<float>(i)) < v; }; };
+    auto functions = condition_type(state::Or(
+        state::And(greater(0, 0.5f), less(1, 0.5f), greater(2, 0.25f), state::Not(greater(3, 0.75f))),
+        state::And(less(4, 0.5f), state::Not(greater(5, 0.5f), less(6, 0.1f))),
+        state::And(greater(7, 0.9f), less(0, 0.2f), greater(1, 0.3f))
+    ));
+    auto compiled = state::Or(
+        state::And(state::When(p(0), Compare::Greater, 0.5f), state::When(p(1), Compare::Less, 0.5f), state::When(p(2), Compare::Greater, 0.25f), state::Not(state::When(p(3), Compare::Greater, 0.75f))),
+        state::And(state::When(p(4), Compare::Less, 0.5f), state::Not(state::When(p(5), Compare::Greater, 0.5f), state::When(p(6), Compare::Less, 0.1f))),
+        state::And(state::When(p(7), Compare::Greater, 0.9f), state::When(p(0), Compare::Less, 0.2f), state::When(p(1), Compare::Greater, 0.3f))
+    );
+    auto compiledCondition = condition_type(compiled);
+
+    auto inputs = std::vector<state::UserState>(inputCount, state::UserState(8));
+    for (size_t i = 0; i < inputCount; i++) {
+        for (int k = 0; k < 8; k++) {
+            inputs[i].Set(p(k), float((i * 7 + k * 13) % 17) / 16.0f);
+        }
+    }
+    auto update = anim::NewUpdate();
+    auto results = std::vector<uint8_t>(inputCount);
+    auto name = std::string(mode == ConditionMode::Functions ? "state/condition_functions/" : mode == ConditionMode::Compiled ? "state/condition_compiled/" : "state/condition_compiled_batched/");
+    Bench(name + std::to_string(inputCount), inputCount, [&]() {
+        if (mode == ConditionMode::Batched) {
+            compiled.EvalBatch(inputs.data(), inputCount, results.data());
+        } else {
+            auto& condition = mode == ConditionMode::Functions ? functions : compiledCondition;
+            for (size_t i = 0; i < inputCount; i++) {
+                results[i] = condition(inputs[i], update);
+            }
+        }
+        Keep(results);
+    });
+}
+
+// Writes many sprites whole, and then as a delta against that baseline after every 16th sprite moved.
+void BenchSerial(size_t spriteCount) {
+    auto sprites = std::vector<Sprite>(spriteCount);
+    for (size_t i = 0; i < spriteCount; i++) {
+        sprites[i] = Sprite{float(i), Vec{float(i % 7), float(i % 11)}, Vec{1, 1}, int(i)};
+    }
+    auto value = types::ValueTo(&sprites, TSprites);
+    auto buffer = std::vector<std::byte>(spriteCount * sizeof(Sprite) * 2 + 64);
+    auto writer = serial::Writer(buffer.data(), buffer.size());
+    auto count = std::to_string(spriteCount);
+    Bench("serial/write/" + count, spriteCount, [&]() {
+        writer.Reset();
+        writer.Write(value);
+        Keep(writer);
+    });
+    auto baseline = std::vector<std::byte>(writer.Data(), writer.Data() + writer.Size());
+    for (size_t i = 0; i < spriteCount; i += 16) {
+        sprites[i].position.x += 1;
+    }
+    Bench("serial/write_delta/" + count, spriteCount, [&]() {
+        writer.Reset();
+        writer.WriteDelta(value, baseline.data(), baseline.size());
+        Keep(writer);
+    });
+    auto applied = std::vector<Sprite>();
+    auto appliedValue = types::ValueTo(&applied, TSprites);
+    Bench("serial/read_delta/" + count, spriteCount, [&]() {
+        auto base = serial::Reader(baseline.data(), baseline.size());
+        base.Read(appliedValue);
+        auto reader = serial::Reader(writer.Data(), writer.Size());
+        reader.ReadDelta(appliedValue);
+        Keep(applied);
+    });
+}
+
+int main(int argc, char** argv) {
+    auto out = std::string();
+    for (int i = 1; i + 1 < argc; i += 2) {
+        auto arg = std::string(argv[i]);
+        if (arg == "--filter") {
+            options.filter = argv[i + 1];
+        } else if (arg == "--samples") {
+            options.samples = std::max(1, std::stoi(argv[i + 1]));
+        } else if (arg == "--out") {
+            out = argv[i + 1];
+        }
+    }
+
+    DefineTypes();
+    PopulateKeys();
+
+    BenchId();
+    BenchTypes();
+    BenchCalc();
+    BenchAnimatorUpdate(1);
+    BenchAnimatorUpdate(16);
+    BenchAnimatorTrack(1024, false);
+    BenchAnimatorTrack(1024, true);
+    BenchAnimatorPool(1024, 1);
+    BenchAnimatorPool(1024, 1, true);
+    if (std::thread::hardware_concurrency() > 1) {
+        BenchAnimatorPool(1024, 0);
+    }
+    BenchMachineUpdate(1);
+    BenchMachineUpdate(64);
+    BenchMachineUpdate(64, MachineMode::Pooled);
+    BenchMachineUpdate(64, MachineMode::Batched);
+    BenchCompiledMachineUpdate(64, false);
+    BenchCompiledMachineUpdate(64, true);
+    BenchConditions(1024, ConditionMode::Functions);
+    BenchConditions(1024, ConditionMode::Compiled);
+    BenchConditions(1024, ConditionMode::Batched);
+    BenchSerial(1024);
+
+    if (out.empty()) {
+        WriteJson(std::cout);
+    } else {
+        auto file = std::ofstream(out);
+        WriteJson(file);
+    }
+
+    return 0;
+}
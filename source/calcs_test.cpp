@@ -54,6 +54,30 @@ constexpr void calc::Set(Vec& a, int index, float value) {
     }
 }
 
+// Packed types only need to declare their size to get SIMD versions of the calc functions.
+struct PackedVec {
+    float x, y;
+};
+struct Vec3 {
+    float x, y, z;
+};
+struct Quat {
+    float x, y, z, w;
+};
+template<> struct calc::Packed<PackedVec> { static constexpr int Size = 2; };
+template<> struct calc::Packed<Vec3> { static constexpr int Size = 3; };
+template<> struct calc::Packed<Quat> { static constexpr int Size = 4; };
+
+auto TVec3 = types::New<Vec3>("vec3");
+
+// Returns whether the packed value matches the generic value within tolerance.
+bool near(float a, float b) {
+    return fabsf(a - b) <= 0.0001f * std::max(1.0f, fabsf(a));
+}
+bool near(const PackedVec& p, const Vec& v) {
+    return near(p.x, v.x) && near(p.y, v.y);
+}
+
 int main() {
     // Add definition to types.
     TFloat->Define(types::Def<float>()
@@ -92,5 +116,262 @@ int main() {
     std::cout << "vec add expected 4,6; actual: " << v2.x << "," << v2.y << std::endl;
     std::cout << "vec lerp expected 2,3; actual: " << l2.x << "," << l2.y << std::endl;
 
+    // Packed tests
+    auto packedErrors = 0;
+    for (int i = 0; i < 100; i++) {
+        auto va = Vec{.x = float(i) - 50, .y = float(i % 7) * 0.5f};
+        auto vb = Vec{.x = float(i % 3), .y = 10 - float(i)};
+        auto pa = PackedVec{va.x, va.y};
+        auto pb = PackedVec{vb.x, vb.y};
+        auto t = float(i) / 100.0f;
+        packedErrors += !near(calc::Adds(pa, pb, t), calc::Adds(va, vb, t));
+        packedErrors += !near(calc::Lerp(pa, pb, t), calc::Lerp(va, vb, t));
+        packedErrors += !near(calc::Scale(pa, t), calc::Scale(va, t));
+        packedErrors += !near(calc::Div(pa, pb), calc::Div(va, vb));
+        packedErrors += !near(calc::Dot(pa, pb), calc::Dot(va, vb));
+        packedErrors += !near(calc::Length(pa), calc::Length(va));
+        packedErrors += !near(calc::Closest(pa, pb, PackedVec{t, t}, false), calc::Closest(va, vb, Vec{t, t}, false));
+        auto na = pa;
+        auto ma = va;
+        packedErrors += !near(calc::Normalize(na), calc::Normalize(ma)) || !near(na, ma);
+    }
+    auto q = calc::SlerpNormal(Quat{0, 0, 0, 1}, Quat{0, 0, 1, 0}, 0.5f);
+    auto v3 = Vec3{1, 2, 3};
+    calc::Set(v3, 2, 4);
+    std::cout << "packed vec matches generic expected 0; actual: " << packedErrors << std::endl;
+    std::cout << "packed vec3 expected 3,2,4,21; actual: " << calc::Components<Vec3>() << "," << calc::Get(v3, 1) << "," << v3.z << "," << calc::Dot(v3, v3) << std::endl;
+    std::cout << "packed quat slerp expected 0,0,0.7071,0.7071; actual: " << q.x << "," << q.y << "," << q.z << "," << q.w << std::endl;
+
+    // Packed types work through the calculators too.
+    TVec3->Define(types::Def<Vec3>().DefaultCreate());
+    calc::Register<Vec3>(TVec3);
+    auto l3 = calc::For(TVec3)->Lerp(TVec3->New(Vec3{0, 0, 0}), TVec3->New(Vec3{2, 4, 6}), 0.5f).Get<Vec3>();
+    std::cout << "packed vec3 lerp expected 1,2,3; actual: " << l3.x << "," << l3.y << "," << l3.z << std::endl;
+
+    // Structure of arrays tests
+    const size_t soa = 103;
+    auto xs = std::vector<float>(soa), ys = std::vector<float>(soa), zs = std::vector<float>(soa);
+    for (size_t i = 0; i < soa; i++) {
+        xs[i] = float(i) * 0.25f;
+        ys[i] = 3.0f - float(i % 5);
+        zs[i] = i % 11 == 0 ? 0.0f : 1.0f;
+    }
+    xs[0] = 1; ys[0] = 0; zs[0] = 0; // already normal
+    xs[1] = 0; ys[1] = 0; zs[1] = 0; // zero
+    float* components[3] = {xs.data(), ys.data(), zs.data()};
+    auto dots = std::vector<float>(soa);
+    auto soaLengths = std::vector<float>(soa);
+    auto soaErrors = 0;
+    calc::DotN<3>(components, components, dots.data(), soa);
+    for (size_t i = 0; i < soa; i++) {
+        auto v = Vec3{xs[i], ys[i], zs[i]};
+        soaErrors += !near(dots[i], calc::Dot(v, v));
+    }
+    auto originals = std::vector<Vec3>();
+    for (size_t i = 0; i < soa; i++) {
+        originals.push_back(Vec3{xs[i], ys[i], zs[i]});
+    }
+    calc::NormalizeN<3>(components, soaLengths.data(), soa);
+    for (size_t i = 0; i < soa; i++) {
+        auto v = originals[i];
+        auto length = calc::Normalize(v);
+        soaErrors += !near(length, soaLengths[i]) || !near(v.x, xs[i]) || !near(v.y, ys[i]) || !near(v.z, zs[i]);
+    }
+    std::cout << "soa dot & normalize match expected 0; actual: " << soaErrors << std::endl;
+
+    // View culling tests
+    const size_t targets = 1000;
+    auto positions = std::vector<Vec>(targets);
+    auto radii = std::vector<float>(targets);
+    auto px = std::vector<float>(targets), py = std::vector<float>(targets);
+    for (size_t i = 0; i < targets; i++) {
+        positions[i] = Vec{.x = float(int(i * 37) % 201 - 100) * 0.37f, .y = float(int(i * 91) % 173 - 86) * 0.29f};
+        radii[i] = float(i % 13) * 0.3f;
+        px[i] = positions[i].x;
+        py[i] = positions[i].y;
+    }
+    const float* soaPositions[2] = {px.data(), py.data()};
+    auto views = std::vector<calc::View<Vec>>();
+    for (int v = 0; v < 8; v++) {
+        auto angle = float(v) * 0.785f;
+        auto fov = 0.3f + float(v) * 0.1f;
+        views.push_back(calc::View<Vec>{
+            .origin = Vec{.x = float(v) - 4, .y = 2 - float(v)},
+            .direction = Vec{.x = cosf(angle), .y = sinf(angle)},
+            .fovTan = tanf(fov),
+            .fovCos = cosf(fov),
+            .fovType = calc::FieldOfView(v % 3),
+        });
+    }
+    auto viewErrors = 0;
+    auto mask = std::vector<uint64_t>(calc::MaskWords(targets));
+    auto soaMask = std::vector<uint64_t>(calc::MaskWords(targets));
+    auto indices = std::vector<uint32_t>(targets);
+    auto maskIndices = std::vector<uint32_t>(targets);
+    auto visibleTotal = size_t(0);
+    for (auto& view : views) {
+        auto origin = view.origin;
+        auto direction = view.direction;
+        auto count = calc::PointsInView(origin, direction, view.fovCos, positions.data(), targets, mask.data());
+        auto soaCount = calc::PointsInViewN<2>(&origin.x, &direction.x, view.fovCos, soaPositions, targets, soaMask.data());
+        auto indexCount = calc::PointsInViewIndices(origin, direction, view.fovCos, positions.data(), targets, indices.data());
+        auto maskCount = calc::MaskToIndices(mask.data(), targets, maskIndices.data());
+        viewErrors += count != soaCount || count != indexCount || count != maskCount || mask != soaMask;
+        viewErrors += !std::equal(indices.begin(), indices.begin() + indexCount, maskIndices.begin());
+        for (size_t i = 0; i < targets; i++) {
+            auto expected = calc::IsPointInView(origin, direction, view.fovCos, positions[i]);
+            viewErrors += expected != bool(mask[i / 64] >> (i % 64) & 1);
+        }
+        visibleTotal += count;
+        for (auto entirely : {false, true}) {
+            count = calc::CirclesInView(origin, direction, view.fovTan, view.fovCos, positions.data(), radii.data(), targets, entirely, mask.data());
+            soaCount = calc::CirclesInViewN<2>(&origin.x, &direction.x, view.fovTan, view.fovCos, soaPositions, radii.data(), targets, entirely, soaMask.data());
+            viewErrors += count != soaCount || mask != soaMask;
+            for (size_t i = 0; i < targets; i++) {
+                auto expected = calc::IsCircleInView(origin, direction, view.fovTan, view.fovCos, positions[i], radii[i], entirely);
+                viewErrors += expected != bool(mask[i / 64] >> (i % 64) & 1);
+            }
+        }
+    }
+    auto masks = std::vector<uint64_t>(views.size() * calc::MaskWords(targets));
+    auto work = WorkPool(4);
+    calc::CirclesInViews(views.data(), views.size(), positions.data(), radii.data(), targets, masks.data(), &work, 3);
+    for (size_t v = 0; v < views.size(); v++) {
+        auto& view = views[v];
+        for (size_t i = 0; i < targets; i++) {
+            auto expected = calc::IsCircleInViewType(view.origin, view.direction, view.fovTan, view.fovCos, positions[i], radii[i], view.fovType);
+            viewErrors += expected != bool(masks[v * calc::MaskWords(targets) + i / 64] >> (i % 64) & 1);
+        }
+    }
+    calc::PointsInViews(views.data(), views.size(), positions.data(), targets, masks.data());
+    auto viewsTotal = size_t(0);
+    for (auto word : masks) {
+        viewsTotal += std::popcount(word);
+    }
+    std::cout << "view culling batches match single queries expected 0; actual: " << viewErrors << std::endl;
+    std::cout << "view culling multi view points expected " << visibleTotal << "; actual: " << viewsTotal << std::endl;
+
+    // Intercept tests
+    const size_t pursuers = 203;
+    auto interceptors = std::vector<Vec>(pursuers), targetPositions = std::vector<Vec>(pursuers), targetVelocities = std::vector<Vec>(pursuers);
+    auto speeds = std::vector<float>(pursuers);
+    for (size_t i = 0; i < pursuers; i++) {
+        interceptors[i] = Vec{.x = float(int(i * 13) % 41 - 20), .y = float(int(i * 7) % 23 - 11)};
+        targetPositions[i] = Vec{.x = float(int(i * 17) % 37 - 18), .y = float(int(i * 29) % 31 - 15)};
+        targetVelocities[i] = Vec{.x = float(int(i * 3) % 9 - 4), .y = float(int(i * 5) % 7 - 3)};
+        speeds[i] = float(i % 6);
+    }
+    // equal speeds (linear), no movement at all, and a target that can't be caught
+    targetVelocities[0] = Vec{.x = -3, .y = 0}; speeds[0] = 3; targetPositions[0] = Vec{.x = interceptors[0].x + 10, .y = interceptors[0].y};
+    interceptors[1] = targetPositions[1]; targetVelocities[1] = Vec{}; speeds[1] = 0;
+    targetVelocities[2] = Vec{.x = 5, .y = 0}; speeds[2] = 1; targetPositions[2] = Vec{.x = interceptors[2].x + 1, .y = interceptors[2].y};
+    auto ix = std::vector<float>(pursuers), iy = std::vector<float>(pursuers), tx = std::vector<float>(pursuers), ty = std::vector<float>(pursuers), vx = std::vector<float>(pursuers), vy = std::vector<float>(pursuers);
+    for (size_t i = 0; i < pursuers; i++) {
+        ix[i] = interceptors[i].x; iy[i] = interceptors[i].y;
+        tx[i] = targetPositions[i].x; ty[i] = targetPositions[i].y;
+        vx[i] = targetVelocities[i].x; vy[i] = targetVelocities[i].y;
+    }
+    const float* soaInterceptors[2] = {ix.data(), iy.data()};
+    const float* soaTargets[2] = {tx.data(), ty.data()};
+    const float* soaVelocities[2] = {vx.data(), vy.data()};
+    auto times = std::vector<float>(pursuers), soaTimes = std::vector<float>(pursuers), calcTimes = std::vector<float>(pursuers);
+    calc::InterceptTimes(interceptors.data(), speeds.data(), targetPositions.data(), targetVelocities.data(), times.data(), pursuers);
+    calc::InterceptTimeN<2>(soaInterceptors, speeds.data(), soaTargets, soaVelocities, soaTimes.data(), pursuers);
+    c2->InterceptTimeN(interceptors.data(), speeds.data(), targetPositions.data(), targetVelocities.data(), calcTimes.data(), pursuers);
+    auto interceptErrors = 0;
+    auto intercepts = 0;
+    for (size_t i = 0; i < pursuers; i++) {
+        auto expected = calc::InterceptTime(interceptors[i], speeds[i], targetPositions[i], targetVelocities[i]);
+        interceptErrors += expected != times[i] || expected != soaTimes[i] || expected != calcTimes[i];
+        intercepts += expected != -1;
+    }
+    std::cout << "intercept batches match single expected 0; actual: " << interceptErrors << " (" << intercepts << " intercepts)" << std::endl;
+    std::cout << "intercept edge cases expected 1.66667,-1,-1; actual: " << times[0] << "," << times[1] << "," << times[2] << std::endl;
+
+    // Compiled curve tests
+    float catmullRom[4][4] = {
+        { 0.0f,  1.0f,  0.0f,  0.0f},
+        {-0.5f,  0.0f,  0.5f,  0.0f},
+        { 1.0f, -2.5f,  2.0f, -0.5f},
+        {-0.5f,  1.5f, -1.5f,  0.5f},
+    };
+    auto curvePoints = std::vector<Vec>{{0, 0}, {1, 3}, {4, 2}, {6, -1}, {9, 0}};
+    auto curveValues = std::vector<types::Value>();
+    for (auto& pt : curvePoints) {
+        curveValues.push_back(TVec->New(pt));
+    }
+    auto curveErrors = 0;
+    for (auto inverse : {false, true}) {
+        for (auto loop : {false, true}) {
+            auto curve = calc::CompiledCurve<Vec>(curvePoints, catmullRom, 0.75f, inverse, loop);
+            auto valueCurve = c2->CompileCurve(curveValues, catmullRom, 0.75f, inverse, loop);
+            auto deltas = std::vector<float>();
+            for (int i = 0; i <= 64; i++) {
+                deltas.push_back(float(i) / 64.0f);
+            }
+            auto evaluated = std::vector<Vec>(deltas.size());
+            auto valueEvaluated = std::vector<Vec>(deltas.size());
+            curve.EvaluateN(deltas.data(), evaluated.data(), deltas.size());
+            valueCurve->EvaluateN(deltas.data(), valueEvaluated.data(), deltas.size());
+            auto into = TVec->New(Vec{});
+            for (size_t i = 0; i < deltas.size(); i++) {
+                auto e = calc::ParametricCubicCurve(deltas[i], curvePoints, catmullRom, 0.75f, inverse, loop);
+                auto ev = c2->ParametricCubicCurve(deltas[i], curveValues, catmullRom, 0.75f, inverse, loop).Get<Vec>();
+                valueCurve->Evaluate(deltas[i], into);
+                auto p = PackedVec{e.x, e.y};
+                curveErrors += !near(p, evaluated[i]) || !near(p, valueEvaluated[i]) || !near(p, ev) || !near(p, into.Get<Vec>());
+                curveErrors += !near(p, valueCurve->Evaluate(deltas[i]).Get<Vec>());
+            }
+            curveErrors += curve.Segments() != 4 || valueCurve->Segments() != 4;
+        }
+    }
+    auto single = calc::CompiledCurve<Vec>(std::vector<Vec>{{2, 3}}, catmullRom, 2, false, false).Evaluate(0.5f);
+    std::cout << "compiled curve matches expected 0; actual: " << curveErrors << std::endl;
+    std::cout << "compiled curve single point expected 4,6; actual: " << single.x << "," << single.y << std::endl;
+
+    // Batched tests
+    const size_t n = 1000;
+    auto as = std::vector<Vec>(n);
+    auto bs = std::vector<Vec>(n);
+    auto ts = std::vector<float>(n);
+    for (size_t i = 0; i < n; i++) {
+        as[i] = Vec{.x = float(i), .y = 1};
+        bs[i] = Vec{.x = 3, .y = float(i) * 0.5f};
+        ts[i] = float(i % 10) / 10.0f;
+    }
+    auto out = std::vector<Vec>(n);
+    auto distances = std::vector<float>(n);
+    auto lengths = std::vector<float>(n);
+    auto batchErrors = 0;
+    c2->LerpN(as.data(), bs.data(), ts.data(), out.data(), n);
+    for (size_t i = 0; i < n; i++) {
+        auto e = c2->Lerp(TVec->New(as[i]), TVec->New(bs[i]), ts[i]).Get<Vec>();
+        batchErrors += e.x != out[i].x || e.y != out[i].y;
+    }
+    c2->AddsN(as.data(), bs.data(), ts.data(), out.data(), n);
+    for (size_t i = 0; i < n; i++) {
+        auto e = c2->Adds(TVec->New(as[i]), TVec->New(bs[i]), ts[i]).Get<Vec>();
+        batchErrors += e.x != out[i].x || e.y != out[i].y;
+    }
+    c2->ScaleN(as.data(), ts.data(), out.data(), n);
+    for (size_t i = 0; i < n; i++) {
+        auto e = c2->Scale(TVec->New(as[i]), ts[i]).Get<Vec>();
+        batchErrors += e.x != out[i].x || e.y != out[i].y;
+    }
+    c2->DistanceN(as.data(), bs.data(), distances.data(), n);
+    for (size_t i = 0; i < n; i++) {
+        batchErrors += c2->Distance(TVec->New(as[i]), TVec->New(bs[i])) != distances[i];
+    }
+    out = bs;
+    c2->NormalizeN(out.data(), lengths.data(), n);
+    for (size_t i = 0; i < n; i++) {
+        auto e = TVec->New(bs[i]);
+        auto length = c2->Normalize(e);
+        batchErrors += e.Get<Vec>().x != out[i].x || e.Get<Vec>().y != out[i].y || length != lengths[i];
+    }
+    c2->AddsN(as.data(), bs.data(), ts.data(), as.data(), n);
+    std::cout << "vec batched in place expected 1.3,1.05; actual: " << as[1].x << "," << as[1].y << std::endl;
+    std::cout << "vec batched mismatches expected 0; actual: " << batchErrors << std::endl;
+
     return 0;
 }
\ No newline at end of file
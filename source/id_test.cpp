@@ -3,6 +3,11 @@
 #include <chrono>
 #include <random>
 #include <iomanip>
+#include <thread>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <algorithm>
 
 #include "../include/id.h"
 
@@ -56,6 +61,203 @@ void testBasic() {
     }
 }
 
+void testMemory() {
+    // Identifiers are found by their characters and not where the characters live.
+    auto built = std::string("Built") + "AtRuntime";
+    auto a = id::Identifier(built.c_str());
+    auto b = id::Identifier(std::string_view("BuiltAtRuntimeAndMore").substr(0, 14));
+    std::cout << "testMemory same chars same uid: expected: 1, actual: " << (a.uid == b.uid) << std::endl;
+    std::cout << "testMemory peek string_view: expected: " << a.uid << ", actual: " << id::memory.Peek(std::string_view("BuiltAtRuntime!").substr(0, 14)) << std::endl;
+    std::cout << "testMemory peek missing: expected: -1, actual: " << id::memory.Peek(std::string_view("BuiltAtRuntime!")) << std::endl;
+
+    // A page sized identifier gets its own page.
+    auto large = std::string(5000, 'x');
+    auto l = id::Identifier(large);
+    std::cout << "testMemory large identifier: expected: 5000, actual: " << l.Len() << ", same: " << (id::memory.Peek(large) == int32_t(l.uid)) << std::endl;
+}
+
+const int internCount = 262144;
+
+void testIntern(std::string prefix) {
+    auto names = std::vector<std::string>(internCount);
+    for (int i = 0; i < internCount; i++) {
+        names[i] = "asset/name/" + std::to_string(i);
+    }
+    auto memory = id::Memory(PAGE_POWER);
+    auto start = std::chrono::steady_clock::now();
+    for (auto& name : names) {
+        memory.Translate(std::string_view(name));
+    }
+    auto end = std::chrono::steady_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds> (end - start).count();
+    std::cout << prefix << (duration * 0.000000001) << "s for interns: " << internCount << std::endl;
+}
+
+void testLiterals() {
+    using namespace id::literals;
+    // Literals are hashed at compile time with the same hash memory uses.
+    static_assert(id::Literal("Speed").hash == id::Hash("Speed"));
+
+    auto speed = "Speed"_id;
+    std::cout << "testLiterals same uid: expected: " << id::Identifier("Speed").uid << ", actual: " << speed.uid << std::endl;
+    std::cout << "testLiterals same chars: expected: Speed, actual: " << speed << std::endl;
+    std::cout << "testLiterals empty: expected: 0, actual: " << ""_id.uid << std::endl;
+
+    auto dm = id::DenseMap8<float>();
+    dm["Speed"_id] = 2.5f;
+    std::cout << "testLiterals dense map: expected: 2.5, actual: " << dm.Get("Speed"_id) << std::endl;
+}
+
+// Writes a copy of the snapshot changed by edit and returns whether fresh memory loaded it, or -1 when 
+// the failed load changed memory.
+template<typename Edit>
+int loadCorrupted(const std::string& path, Edit edit) {
+    auto bytes = std::vector<char>(std::filesystem::file_size(path));
+    auto in = std::ifstream(path, std::ios::binary);
+    in.read(bytes.data(), bytes.size());
+    in.close();
+    edit(bytes);
+    auto corruptedPath = path + ".corrupted";
+    auto out = std::ofstream(corruptedPath, std::ios::binary);
+    out.write(bytes.data(), bytes.size());
+    out.close();
+    auto memory = id::Memory(PAGE_POWER);
+    auto loaded = memory.Load(corruptedPath.c_str());
+    std::filesystem::remove(corruptedPath);
+    return !loaded && memory.Count() != 1 ? -1 : loaded;
+}
+
+// Saves many identifiers and times loading them into fresh memory.
+void testSnapshot(std::string prefix) {
+    auto path = (std::filesystem::temp_directory_path() / "id_test_snapshot.bin").string();
+    auto saved = id::Memory(PAGE_POWER);
+    for (int i = 0; i < internCount; i++) {
+        saved.Translate("asset/name/" + std::to_string(i));
+    }
+    auto large = std::string(5000, 'x');
+    saved.Translate(large);
+    auto written = saved.Save(path.c_str());
+
+    auto loaded = id::Memory(PAGE_POWER);
+    auto start = std::chrono::steady_clock::now();
+    auto read = loaded.Load(path.c_str());
+    auto end = std::chrono::steady_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds> (end - start).count();
+
+    auto same = loaded.Count() == saved.Count();
+    for (id::id_t uid = 1; same && uid < saved.Count(); uid++) {
+        same = strcmp(loaded.LookupChars(uid), saved.LookupChars(uid)) == 0 && loaded.Peek(saved.LookupChars(uid)) == int32_t(uid);
+    }
+    // New identifiers go after the loaded ones and can be found along with them.
+    auto added = loaded.Translate("added/after/load");
+    auto found = loaded.Peek("added/after/load") == int32_t(added) && loaded.Peek("asset/name/7") == saved.Peek("asset/name/7");
+
+    // Only fresh memory can load a snapshot, and a damaged one is ignored.
+    auto again = loaded.Load(path.c_str());
+    // The header stays valid but the index and character data after it are overwritten.
+    auto scrambled = loadCorrupted(path, [](std::vector<char>& bytes) {
+        std::fill(bytes.begin() + bytes.size() / 4, bytes.end(), char(0xFF));
+    });
+    // The identifiers in the last pages are no longer terminated.
+    auto unterminated = loadCorrupted(path, [](std::vector<char>& bytes) {
+        std::fill(bytes.end() - std::min(bytes.size() / 2, size_t(65536)), bytes.end(), 'x');
+    });
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) / 2);
+    auto truncated = id::Memory(PAGE_POWER);
+    auto damaged = truncated.Load(path.c_str());
+    std::filesystem::remove(path);
+
+    std::cout << prefix << (duration * 0.000000001) << "s for load of ids: " << saved.Count() 
+        << " (saved: " << written << ", loaded: " << read << ", same: " << same << ", added: " << (added == saved.Count()) << ", found: " << found
+        << ", reloaded: " << again << ", damaged: " << damaged << ", truncated count: " << truncated.Count() 
+        << ", scrambled: " << scrambled << ", unterminated: " << unterminated << ")" << std::endl;
+}
+
+
+const int threadNames = 16384;
+
+// Every thread translates the same shared names (contended hits & inserts) and its own unique names.
+void testConcurrentIntern(std::string prefix, int threadCount) {
+    auto shared = std::vector<std::string>(threadNames);
+    auto unique = std::vector<std::vector<std::string>>(threadCount, std::vector<std::string>(threadNames));
+    for (int i = 0; i < threadNames; i++) {
+        shared[i] = "shared/name/" + std::to_string(i);
+        for (int t = 0; t < threadCount; t++) {
+            unique[t][i] = "thread/" + std::to_string(t) + "/name/" + std::to_string(i);
+        }
+    }
+    auto memory = id::Memory(PAGE_POWER, true);
+    auto sharedUids = std::vector<std::vector<id::id_t>>(threadCount, std::vector<id::id_t>(threadNames));
+    auto threads = std::vector<std::thread>();
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < threadCount; t++) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < threadNames; i++) {
+                sharedUids[t][i] = memory.Translate(std::string_view(shared[(i + t * 997) % threadNames]));
+                auto uid = memory.Translate(std::string_view(unique[t][i]));
+                // Reads of published identifiers don't lock.
+                memory.LookupChars(uid);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds> (end - start).count();
+
+    // Every thread must have resolved the shared names to the same identifiers.
+    auto consistent = true;
+    for (int t = 0; t < threadCount; t++) {
+        for (int i = 0; i < threadNames; i++) {
+            auto name = (i + t * 997) % threadNames;
+            consistent = consistent && memory.Peek(std::string_view(shared[name])) == int32_t(sharedUids[t][i]);
+        }
+    }
+    auto expected = 1 + threadNames * (threadCount + 1);
+    std::cout << prefix << (duration * 0.000000001) << "s for translates: " << (threadNames * threadCount * 2) 
+        << " (threads: " << threadCount << ", ids expected: " << expected << ", actual: " << memory.Count() << ", consistent: " << consistent << ")" << std::endl;
+}
+
+// Threads translate new names while another thread reserves room for more, Reserve takes the same locks as 
+// Translate and must not deadlock with it.
+void testConcurrentReserve(std::string prefix, int threadCount) {
+    auto memory = id::Memory(PAGE_POWER, true);
+    auto done = std::atomic<int>(0);
+    auto reserves = 0;
+    auto threads = std::vector<std::thread>();
+    auto start = std::chrono::steady_clock::now();
+    threads.emplace_back([&]() {
+        while (done.load() < threadCount) {
+            memory.Reserve(memory.Count() + 4096);
+            reserves++;
+        }
+    });
+    for (int t = 0; t < threadCount; t++) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < threadNames; i++) {
+                memory.Translate("reserve/" + std::to_string(t) + "/name/" + std::to_string(i));
+            }
+            done++;
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds> (end - start).count();
+
+    auto found = true;
+    for (int t = 0; t < threadCount; t++) {
+        for (int i = 0; found && i < threadNames; i++) {
+            found = memory.Peek("reserve/" + std::to_string(t) + "/name/" + std::to_string(i)) > 0;
+        }
+    }
+    std::cout << prefix << (duration * 0.000000001) << "s for translates: " << (threadNames * threadCount) 
+        << " (threads: " << threadCount << ", reserves: " << reserves << ", ids expected: " << (1 + threadNames * threadCount) 
+        << ", actual: " << memory.Count() << ", found: " << found << ")" << std::endl;
+}
+
 const int keyCount = 1024;
 const int mapRounds = 256;
 const int accessCount = 2048;
@@ -78,6 +280,27 @@ void populateKeys() {
     }
 }
 
+// Compares looking up a dense map with string keys against identifier literals.
+void testLiteralLookup(std::string prefix, bool literal) {
+    using namespace id::literals;
+    auto dm = id::DenseMap32<float>();
+    dm["position"] = 1.0f;
+    dm["velocity"] = 2.0f;
+    dm["acceleration"] = 3.0f;
+    auto sum = 0.0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < accessCount * mapRounds; i++) {
+        if (literal) {
+            sum += dm.Get("position"_id) + dm.Get("velocity"_id) + dm.Get("acceleration"_id);
+        } else {
+            sum += dm.Get("position") + dm.Get("velocity") + dm.Get("acceleration");
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds> (end - start).count();
+    std::cout << prefix << (duration * 0.000000001) << "s for lookups: " << (accessCount * mapRounds * 3) << " (sum: " << sum << ")" << std::endl;
+}
+
 void testMapWrite(std::string prefix) {
     auto start = std::chrono::steady_clock::now();
     for (int i = 0; i < mapRounds; i++) {
@@ -211,6 +434,24 @@ void testDenseMapRemove(std::string prefix, id::Area<id::id_t, uint16_t>* area,
     std::cout << prefix << (total * 0.000000001) << "s for removes: " << (mapRounds * accessCount) << std::endl;
 }
 
+void testDenseMapRemoveLater(std::string prefix, id::Area<id::id_t, uint16_t>* area) {
+    long long total = 0;
+    for (int i = 0; i < mapRounds; i++) {
+        auto m = id::DenseMap<int, uint16_t, uint16_t>(area);
+        for (int k = 0; k < keyCount; k++) {
+            m.Set(idKeys[k], 0);
+        }
+        auto start = std::chrono::steady_clock::now();
+        for (int a = 0; a < accessCount; a++) {
+            m.RemoveLater(idKeys[updateOrder[a]]);
+        }
+        m.Compact();
+        auto end = std::chrono::steady_clock::now();
+        total += std::chrono::duration_cast<std::chrono::nanoseconds> (end - start).count();
+    }
+    std::cout << prefix << (total * 0.000000001) << "s for removes: " << (mapRounds * accessCount) << std::endl;
+}
+
 void testVectorRemove(std::string prefix, bool preserveOrder) {
     long long total = 0;
     for (int i = 0; i < mapRounds; i++) {
@@ -239,6 +480,146 @@ void testVectorRemove(std::string prefix, bool preserveOrder) {
     std::cout << prefix << (total * 0.000000001) << "s for removes: " << (mapRounds * accessCount) << std::endl;
 }
 
+// Mixes every kind of remove with adds and compares the map to a vector of the expected key & values in order.
+void testDenseMapRemoveOrder() {
+    auto m = id::DenseMap16<int>();
+    auto expected = std::vector<std::pair<int, int>>();
+    auto gen = std::mt19937(7);
+    auto matches = true;
+    for (int step = 0; step < 20000; step++) {
+        auto key = int(gen() % 64);
+        auto it = std::find_if(expected.begin(), expected.end(), [key](auto& e) { return e.first == key; });
+        switch (gen() % 5) {
+        case 0:
+        case 1:
+            m.Set(idKeys[key], step);
+            if (it == expected.end()) {
+                expected.emplace_back(key, step);
+            } else {
+                it->second = step;
+            }
+            break;
+        case 2:
+            if (m.RemoveLater(idKeys[key]) != (it != expected.end())) {
+                matches = false;
+            } else if (it != expected.end()) {
+                expected.erase(it);
+            }
+            break;
+        case 3:
+            if (m.Remove(idKeys[key], true) != (it != expected.end())) {
+                matches = false;
+            } else if (it != expected.end()) {
+                expected.erase(it);
+            }
+            break;
+        case 4:
+            m.Compact();
+            break;
+        }
+        matches = matches && m.Size() == expected.size();
+        for (auto& [k, v] : expected) {
+            auto p = m.Ptr(idKeys[k]);
+            matches = matches && p != nullptr && *p == v;
+        }
+        size_t e = 0;
+        for (size_t i = 0; matches && i < m.Values().size(); i++) {
+            if (!m.IsRemoved(i)) {
+                matches = e < expected.size() && m.Values()[i] == expected[e++].second;
+            }
+        }
+        matches = matches && e == expected.size();
+    }
+    std::cout << "testDenseMapRemoveOrder matches: expected: 1, actual: " << matches << std::endl;
+}
+
+void testDenseKeyMap() {
+    auto m = id::DenseKeyMap16<int>();
+    m["key/a"] = 1;
+    m["key/b"] = 2;
+    m["key/c"] = 3;
+    m["key/d"] = 4;
+    m.Remove("key/a", false);
+    m.RemoveLater("key/c");
+
+    std::cout << "testDenseKeyMap pairs: expected: key/d=4 key/b=2, actual:";
+    for (auto [key, value] : m.Pairs()) {
+        std::cout << " " << key << "=" << value;
+    }
+    std::cout << std::endl;
+
+    m.Compact();
+    auto matches = m.Keys().size() == m.Values().size();
+    for (size_t i = 0; i < m.Keys().size(); i++) {
+        matches = matches && m.Ptr(m.Keys()[i]) == &m.Values()[i];
+    }
+    std::cout << "testDenseKeyMap keys match values: expected: 1, actual: " << matches << ", size: " << m.Keys().size() << std::endl;
+}
+
+void testDenseSoAMap() {
+    auto m = id::DenseSoAMap16<float, int>();
+    m.Set("soa/a", 1.5f, 1);
+    m.Set("soa/b", 2.5f, 2);
+    m.Set("soa/c", 3.5f, 3);
+    *m.Ptr<1>("soa/a") = 10;
+    std::cout << "testDenseSoAMap get: expected: 2.5, actual: " << m.Get<0>("soa/b") << std::endl;
+    std::cout << "testDenseSoAMap ptr: expected: 10, actual: " << m.Get<1>("soa/a") << std::endl;
+    std::cout << "testDenseSoAMap aligned: expected: 0, actual: " << (uintptr_t(m.Field<0>().data()) % 64) << std::endl;
+
+    m.RemoveLater("soa/a");
+    m.Compact();
+    m.Remove("soa/b", true);
+    std::cout << "testDenseSoAMap remove: expected: 1 3.5 3, actual: " << m.Size() << " " << m.Field<0>()[0] << " " << m.Field<1>()[0] << std::endl;
+    std::cout << "testDenseSoAMap missing: expected: -1, actual: " << m.Index("soa/a") << std::endl;
+}
+
+const int iterateCount = 1000000;
+
+// A component like value where only the position is needed when iterating.
+struct Particle {
+    float x, y, z;
+    float vx, vy, vz;
+    float life;
+    int flags;
+};
+
+// Iterates one field of 1M values in a DenseMap of structs.
+void testDenseMapFieldIteration(std::string prefix) {
+    auto m = id::DenseMap32<Particle>();
+    for (int i = 0; i < iterateCount; i++) {
+        m.Set(id::Identifier(id::id_t(i + 1)), Particle{float(i), 0, 0, 0, 0, 0, 1, 0});
+    }
+    auto sum = 0.0f;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < 16; r++) {
+        for (auto& p : m) {
+            sum += p.x;
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds> (end - start).count();
+    std::cout << prefix << (duration * 0.000000001) << "s for iterations: " << (iterateCount * 16) << " (sum: " << sum << ")" << std::endl;
+}
+
+// Iterates one field of 1M values in a DenseSoAMap.
+void testDenseSoAMapFieldIteration(std::string prefix) {
+    auto m = id::DenseSoAMap32<float, float, float, float, float, float, float, int>();
+    m.Reserve(iterateCount);
+    for (int i = 0; i < iterateCount; i++) {
+        m.Set(id::Identifier(id::id_t(i + 1)), float(i), 0, 0, 0, 0, 0, 1, 0);
+    }
+    auto sum = 0.0f;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < 16; r++) {
+        for (auto x : m.Field<0>()) {
+            sum += x;
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds> (end - start).count();
+    std::cout << prefix << (duration * 0.000000001) << "s for iterations: " << (iterateCount * 16) << " (sum: " << sum << ")" << std::endl;
+}
+
 void testSet() {
     auto s = id::Set();
     std::cout << "testSet has maybe: expected: false, actual: " << s.Has("Should not generate identifier") << std::endl;
@@ -257,6 +638,70 @@ void testSet() {
     s.Remove("This should exist now");
 
     std::cout << "testSet has removed: expected: 0, actual: " << s.Has("This should exist now") << std::endl;
+
+    // Raw uids past the first 32 bits of a word and across words.
+    auto a = id::Set();
+    auto b = id::Set();
+    for (id::id_t uid : {3, 40, 63, 64, 100, 200}) {
+        a.Add(id::Identifier(uid));
+    }
+    for (id::id_t uid : {40, 64, 150, 200, 300}) {
+        b.Add(id::Identifier(uid));
+    }
+    std::cout << "testSet high bits: expected: 1 1 0, actual: " << a.Has(id::id_t(40)) << " " << a.Has(id::id_t(63)) << " " << a.Has(id::id_t(8)) << std::endl;
+    std::cout << "testSet iteration: expected: 3 40 63 64 100 200, actual:";
+    for (auto id : a) {
+        std::cout << " " << id.uid;
+    }
+    std::cout << std::endl;
+    std::cout << "testSet intersect iterate: expected: 40 64 200, actual:";
+    id::Set::IntersectIterate([](id::Identifier id) { std::cout << " " << id.uid; }, a, b);
+    std::cout << std::endl;
+
+    auto u = a;
+    u.Union(b);
+    auto i = a;
+    i.Intersect(b);
+    auto d = a;
+    d.Difference(b);
+    std::cout << "testSet counts: expected: 8 3 3, actual: " << u.Count() << " " << i.Count() << " " << d.Count() << std::endl;
+    std::cout << "testSet difference: expected: 3 63 100, actual:";
+    d.ForEach([](id::Identifier id) { std::cout << " " << id.uid; });
+    std::cout << std::endl;
+    d.Clear();
+    std::cout << "testSet any: expected: 1 0, actual: " << u.Any() << " " << d.Any() << std::endl;
+}
+
+const int entityCount = 65536;
+
+// Finds the entities with 3 tags by checking every entity against every tag, or a word at a time.
+void testSetQuery(std::string prefix, bool perWord) {
+    auto gen = std::mt19937(11);
+    id::Set tags[3];
+    for (auto& tag : tags) {
+        for (int e = 0; e < entityCount; e++) {
+            if (gen() % 2 == 0) {
+                tag.Add(id::Identifier(id::id_t(e)));
+            }
+        }
+    }
+    size_t found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < mapRounds; r++) {
+        if (perWord) {
+            id::Set::IntersectIterate([&found](id::Identifier) { found++; }, tags[0], tags[1], tags[2]);
+        } else {
+            for (int e = 0; e < entityCount; e++) {
+                auto id = id::IdentifierMaybe(id::id_t(e));
+                if (tags[0].Has(id) && tags[1].Has(id) && tags[2].Has(id)) {
+                    found++;
+                }
+            }
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds> (end - start).count();
+    std::cout << prefix << (duration * 0.000000001) << "s for queries: " << mapRounds << " (found: " << found << ")" << std::endl;
 }
 
 void testSmallSet() {
@@ -277,18 +722,73 @@ void testSmallSet() {
     s.Remove("This should exist now");
 
     std::cout << "testSmallSet has removed: expected: 0, actual: " << s.Has("This should exist now") << std::endl;
+
+    // Grows past the inline ids and the promotion to a hash table, then shrinks.
+    auto big = id::SmallSet();
+    auto hasAll = true;
+    for (id::id_t uid = 1; uid <= 300; uid++) {
+        big.Add(id::Identifier(uid * 7));
+        hasAll = hasAll && big.Has(id::id_t(uid * 7)) && big.Size() == uid;
+        if (uid == 5 || uid == 50) {
+            // Removing anything but the first used to never return.
+            big.Remove(id::id_t(uid * 7 - 7));
+            big.Add(id::Identifier(uid * 7 - 7));
+        }
+    }
+    auto copy = big;
+    for (id::id_t uid = 2; uid <= 300; uid += 2) {
+        big.Remove(id::id_t(uid * 7));
+    }
+    auto kept = 0;
+    for (auto id : big) {
+        kept += (id.uid / 7) % 2 == 1 && big.Has(id);
+    }
+    std::cout << "testSmallSet grow: expected: 1, actual: " << hasAll << std::endl;
+    std::cout << "testSmallSet shrink: expected: 150 150 300, actual: " << big.Size() << " " << kept << " " << copy.Size() << std::endl;
+    std::cout << "testSmallSet removed: expected: 0 1, actual: " << big.Has(id::id_t(14)) << " " << copy.Has(id::id_t(14)) << std::endl;
+}
+
+// Looks up ids in a small set holding the given number of ids, half of the lookups miss.
+void testSmallSetHas(std::string prefix, int count) {
+    auto s = id::SmallSet();
+    for (int i = 0; i < count; i++) {
+        s.Add(id::Identifier(id::id_t(i * 2)));
+    }
+    size_t found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < mapRounds * 16; r++) {
+        for (int i = 0; i < count * 2; i++) {
+            found += s.Has(id::id_t(i));
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds> (end - start).count();
+    std::cout << prefix << (duration * 0.000000001) << "s for lookups: " << (mapRounds * 16 * count * 2) << " (found: " << found << ")" << std::endl;
 }
 
 int main() {
     testBasic();
+    testMemory();
+    testLiterals();
     testSet();
     testSmallSet();
     populateKeys();
+    testDenseMapRemoveOrder();
+    testDenseKeyMap();
+    testDenseSoAMap();
 
     std::cout << std::fixed << std::setprecision(9);
 
     auto area = id::Area<id::id_t, uint16_t>(120, keyCount);
 
+    testIntern(             "testIntern:                        ");
+    testSnapshot(           "testSnapshot:                      ");
+    testConcurrentIntern(   "testConcurrentIntern (1 thread):   ", 1);
+    testConcurrentIntern(   "testConcurrentIntern (4 threads):  ", 4);
+    testConcurrentIntern(   "testConcurrentIntern (16 threads): ", 16);
+    testConcurrentReserve(  "testConcurrentReserve (4 threads): ", 4);
+    testLiteralLookup(      "testLiteralLookup (strings):       ", false);
+    testLiteralLookup(      "testLiteralLookup (literals):      ", true);
     testMapWrite(           "testMapWrite:                      ");
     testDenseMapWrite(      "testDenseMapWrite:                 ", nullptr);
     testDenseMapWrite(      "testDenseMapWrite (with area):     ", &area);
@@ -298,11 +798,20 @@ int main() {
     testMapIteration(       "testMapIteration:                  ");
     testDenseMapIteration(  "testDenseMapIteration:             ", nullptr);
     testDenseMapIteration(  "testDenseMapIteration (with area): ", &area);
+    testDenseMapFieldIteration(   "testDenseMapFieldIteration:        ");
+    testDenseSoAMapFieldIteration("testDenseSoAMapFieldIteration:     ");
+    testSetQuery(           "testSetQuery (per bit):            ", false);
+    testSetQuery(           "testSetQuery (per word):           ", true);
+    testSmallSetHas(        "testSmallSetHas (4 ids):           ", 4);
+    testSmallSetHas(        "testSmallSetHas (32 ids):          ", 32);
+    testSmallSetHas(        "testSmallSetHas (256 ids):         ", 256);
     testMapRemove(          "testMapRemove:                     ");
     testDenseMapRemove(     "testDenseMapRemove (no order):     ", nullptr, false);
     testDenseMapRemove(     "testDenseMapRemove (ordered):      ", nullptr, true);
     testDenseMapRemove(     "testDenseMapRemove (area, -order): ", &area, false);
     testDenseMapRemove(     "testDenseMapRemove (area, +order): ", &area, true);
+    testDenseMapRemoveLater("testDenseMapRemoveLater:           ", nullptr);
+    testDenseMapRemoveLater("testDenseMapRemoveLater (area):    ", &area);
     testVectorRemove(       "testVectorRemove (no order):       ", false);
     testVectorRemove(       "testVectorRemove (ordered):        ", true);
 
@@ -0,0 +1,55 @@
+#define PROFILE_ENABLED true
+
+#include <iostream>
+#include <thread>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../include/id.h"
+
+// Profiling is only enabled in this test, so the timings in id_test stay comparable with and without it.
+void testProfile() {
+    auto find = [](const std::vector<ProfileTotal>& totals, const std::string& name) -> ProfileTotal {
+        for (auto& total : totals) {
+            if (name == total.name) {
+                return total;
+            }
+        }
+        return ProfileTotal{nullptr, 0, 0, false};
+    };
+
+    Profiling = true;
+    ProfileClear();
+    auto m = id::DenseMap8<int>();
+    for (int i = 0; i < 10; i++) {
+        m.Take(id::Identifier(id::id_t(i + 1))) = i;
+    }
+    m.Remove(id::id_t(1), false);
+    m.Remove(id::id_t(2), true);
+    std::thread([]() {
+        PROFILE_ZONE("testProfile::thread")
+        PROFILE_COUNT("testProfile::count", 3)
+        PROFILE_COUNT("testProfile::count", 4)
+    }).join();
+    Profiling = false;
+    m.Take(id::Identifier(id::id_t(20))) = 20;
+
+    auto totals = ProfileTotals();
+    auto take = find(totals, "id::DenseMap::Take");
+    auto count = find(totals, "testProfile::count");
+    std::cout << "testProfile zones: expected: 10 2 1, actual: " << take.events << " " << find(totals, "id::DenseMap::Remove").events << " " << find(totals, "testProfile::thread").events << std::endl;
+    std::cout << "testProfile counts: expected: 2 7 1, actual: " << count.events << " " << count.total << " " << count.count << std::endl;
+
+    auto trace = std::stringstream();
+    auto written = ProfileTrace(trace);
+    auto json = trace.str();
+    std::cout << "testProfile trace: expected: 15 1 1 1, actual: " << written << " " << (json.rfind("{\"traceEvents\":[", 0) == 0) << " " << (json.find("\"ph\":\"C\",\"args\":{\"value\":7}") != std::string::npos) << " " << (json.find("\"name\":\"id::DenseMap::Take\",\"pid\":0,\"tid\":0") != std::string::npos) << std::endl;
+    ProfileClear();
+}
+
+int main() {
+    testProfile();
+
+    return 0;
+}
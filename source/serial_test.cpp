@@ -0,0 +1,221 @@
+#include "../include/serial.h"
+
+#include "allocations.h"
+
+// Game objects
+struct Vec {
+    float x, y;
+    Vec add(Vec v) { return Vec{this->x+v.x, this->y+v.y}; }
+    Vec sub(Vec v) { return Vec{this->x-v.x, this->y-v.y}; }
+};
+
+struct Sprite {
+    float angle;
+    Vec position;
+    Vec size;
+    int frame;
+};
+
+struct Player {
+    std::string name;
+    int level;
+    std::vector<Sprite> sprites;
+    std::map<int, float> scores;
+    std::vector<std::string> tags;
+};
+
+struct Inventory {
+    id::Identifier owner;
+    id::DenseKeyMap16<int> items;
+};
+
+// Types for Game objects
+auto TInt     = types::New<int>("int");
+auto TFloat   = types::New<float>("float");
+auto TString  = types::New<std::string>("string");
+auto TVec     = types::New<Vec>("vec");
+auto TSprite  = types::New<Sprite>("sprite");
+auto TSprites = types::New<std::vector<Sprite>>("sprites");
+auto TScores  = types::New<std::map<int, float>>("scores");
+auto TTags    = types::New<std::vector<std::string>>("tags");
+auto TPlayer  = types::New<Player>("player");
+auto TId      = types::New<id::Identifier>("identifier");
+auto TItems   = types::New<id::DenseKeyMap16<int>>("items");
+auto TInventory = types::New<Inventory>("inventory");
+
+// Define types
+void DefineTypes() {
+    TInt->Define(types::Def<int>().DefaultCreate());
+    TFloat->Define(types::Def<float>().DefaultCreate());
+    TString->Define(types::Def<std::string>().DefaultCreate());
+
+    TVec->Define(types::Def<Vec>()
+        .DefaultCreate()
+        .Field("x", TFloat, &Vec::x)
+        .Field("y", TFloat, &Vec::y)
+    );
+
+    TSprite->Define(types::Def<Sprite>()
+        .DefaultCreate()
+        .Prop<float> ("angle",       TFloat, [](auto v) -> auto { return &v->angle; })
+        .Field       ("position",    TVec,   &Sprite::position)
+        .Field       ("size",        TVec,   &Sprite::size)
+        .Prop<int>   ("frame",       TInt,   [](auto v) -> auto { return &v->frame; })
+        .Virtual<Vec>("bottomRight", TVec,
+            [](auto v) -> auto { return v->position.add(v->size); },
+            [](auto v, auto br) -> auto { v->position = br.sub(v->size); return true; }
+        )
+    );
+
+    TSprites->Define(types::Def<std::vector<Sprite>>()
+        .DefaultCreate()
+        .Computed<int>("size", TInt, [](auto s) -> auto { return s->size(); })
+        .Vector<Sprite>(TInt, TSprite, [](std::vector<Sprite>* s) -> std::vector<Sprite>* { return s; })
+    );
+
+    TScores->Define(types::Def<std::map<int, float>>()
+        .DefaultCreate()
+        .Map<int, float>(TInt, TFloat, [](std::map<int, float>* s) -> std::map<int, float>* { return s; })
+    );
+
+    TTags->Define(types::Def<std::vector<std::string>>()
+        .DefaultCreate()
+        .Vector<std::string>(TInt, TString, [](std::vector<std::string>* s) -> std::vector<std::string>* { return s; })
+    );
+
+    TPlayer->Define(types::Def<Player>()
+        .DefaultCreate()
+        .Field("name",    TString,  &Player::name)
+        .Field("level",   TInt,     &Player::level)
+        .Field("sprites", TSprites, &Player::sprites)
+        .Field("scores",  TScores,  &Player::scores)
+        .Field("tags",    TTags,    &Player::tags)
+    );
+
+    TId->Define(types::Def<id::Identifier>().DefaultCreate());
+
+    TItems->Define(types::Def<id::DenseKeyMap16<int>>()
+        .DefaultCreate()
+        .DenseMap<int>(TId, TInt, [](id::DenseKeyMap16<int>* s) -> id::DenseKeyMap16<int>* { return s; })
+    );
+
+    TInventory->Define(types::Def<Inventory>()
+        .DefaultCreate()
+        .Field("owner", TId,    &Inventory::owner)
+        .Field("items", TItems, &Inventory::items)
+    );
+}
+
+bool same(const Player& a, const Player& b) {
+    if (a.name != b.name || a.level != b.level || a.scores != b.scores || a.tags != b.tags || a.sprites.size() != b.sprites.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.sprites.size(); i++) {
+        if (memcmp(&a.sprites[i], &b.sprites[i], sizeof(Sprite)) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main() {
+    DefineTypes();
+
+    auto player = Player{"hero", 3, {Sprite{45, Vec{1, 2}, Vec{3, 4}, 5}, Sprite{90, Vec{6, 7}, Vec{8, 9}, 10}}, {{1, 0.5f}, {2, 0.25f}}, {"fast", "tall"}};
+    auto value = types::ValueTo(&player);
+
+    std::byte buffer[1024];
+    auto writer = serial::Writer(buffer, sizeof(buffer));
+    auto before = Allocations.load();
+    writer.Write(value);
+    auto allocations = Allocations - before;
+    // name + level + sprites + scores + tags
+    auto expected = (4 + 4) + 4 + (4 + 2 * sizeof(Sprite)) + (4 + 2 * 8) + (4 + 4 + 4 + 4 + 4);
+    std::cout<<"[write             ] expected: 1 "<<expected<<" 0, actual: "<<!writer.Failed()<<" "<<writer.Size()<<" "<<allocations<<std::endl;
+
+    auto read = Player{"other", 1, {Sprite{}}, {{7, 1.0f}}, {}};
+    auto readValue = types::ValueTo(&read);
+    auto reader = serial::Reader(writer.Data(), writer.Size());
+    auto ok = reader.Read(readValue);
+    std::cout<<"[read              ] expected: 1 1 0, actual: "<<ok<<" "<<same(player, read)<<" "<<reader.Remaining()<<std::endl;
+
+    std::byte small[16];
+    auto smallWriter = serial::Writer(small, sizeof(small));
+    auto truncated = serial::Reader(writer.Data(), writer.Size() - 1);
+    auto skipper = serial::Reader(writer.Data(), writer.Size());
+    std::cout<<"[out of room       ] expected: 0 0 1 0, actual: "<<smallWriter.Write(value)<<" "<<truncated.Read(readValue)<<" "<<skipper.Skip(TPlayer)<<" "<<skipper.Remaining()<<std::endl;
+
+    std::byte baseline[1024];
+    memcpy(baseline, writer.Data(), writer.Size());
+    auto baselineSize = writer.Size();
+    auto previous = player;
+
+    std::byte delta[1024];
+    auto deltaWriter = serial::Writer(delta, sizeof(delta));
+    deltaWriter.WriteDelta(value, baseline, baselineSize);
+    std::cout<<"[delta unchanged   ] expected: 1 1 0, actual: "<<!deltaWriter.Failed()<<" "<<deltaWriter.Size()<<" "<<int(delta[0])<<std::endl;
+
+    player.sprites[1].angle = 180;
+    deltaWriter.Reset();
+    before = Allocations.load();
+    deltaWriter.WriteDelta(value, baseline, baselineSize);
+    allocations = Allocations - before;
+    // changed + player bits + sprites count + sprite bits + sprite bits + angle
+    std::cout<<"[delta one prop    ] expected: 12 0, actual: "<<deltaWriter.Size()<<" "<<allocations<<std::endl;
+
+    auto applied = previous;
+    auto appliedValue = types::ValueTo(&applied);
+    auto deltaReader = serial::Reader(deltaWriter.Data(), deltaWriter.Size());
+    ok = deltaReader.ReadDelta(appliedValue);
+    std::cout<<"[read delta        ] expected: 1 1 180 0, actual: "<<ok<<" "<<same(player, applied)<<" "<<applied.sprites[1].angle<<" "<<deltaReader.Remaining()<<std::endl;
+
+    player.name = "villain";
+    player.sprites[0].size.y = 12;
+    player.sprites.push_back(Sprite{1, Vec{2, 3}, Vec{4, 5}, 6});
+    player.scores[3] = 0.75f;
+    player.tags.pop_back();
+    deltaWriter.Reset();
+    deltaWriter.WriteDelta(value, baseline, baselineSize);
+    applied = previous;
+    deltaReader = serial::Reader(deltaWriter.Data(), deltaWriter.Size());
+    ok = deltaReader.ReadDelta(appliedValue);
+    std::cout<<"[read delta many   ] expected: 1 1 villain 3 3 1, actual: "<<ok<<" "<<same(player, applied)<<" "<<applied.name<<" "<<applied.sprites.size()<<" "<<applied.scores.size()<<" "<<applied.tags.size()<<std::endl;
+
+    auto inventory = Inventory{"hero"};
+    inventory.items.Set("sword", 1);
+    inventory.items.Set("shield", 2);
+    inventory.items.Set("potion", 5);
+    inventory.items.Remove("shield", true);
+    auto inventoryValue = types::ValueTo(&inventory);
+    writer.Reset();
+    writer.Write(inventoryValue);
+    auto inventoryBaseline = std::vector<std::byte>(writer.Data(), writer.Data() + writer.Size());
+    auto loaded = Inventory{};
+    auto loadedValue = types::ValueTo(&loaded);
+    reader = serial::Reader(writer.Data(), writer.Size());
+    ok = reader.Read(loadedValue);
+    // owner + count + 2 * (key + value)
+    std::cout<<"[dense map         ] expected: 1 39 hero 2 1 5, actual: "<<ok<<" "<<writer.Size()<<" "<<loaded.owner<<" "<<loaded.items.Size()<<" "<<loaded.items.Get("sword")<<" "<<loaded.items.Get("potion")<<std::endl;
+
+    inventory.items.Set("potion", 4);
+    deltaWriter.Reset();
+    deltaWriter.WriteDelta(inventoryValue, inventoryBaseline.data(), inventoryBaseline.size());
+    deltaReader = serial::Reader(deltaWriter.Data(), deltaWriter.Size());
+    ok = deltaReader.ReadDelta(loadedValue);
+    std::cout<<"[dense map delta   ] expected: 1 4 2, actual: "<<ok<<" "<<loaded.items.Get("potion")<<" "<<loaded.items.Size()<<std::endl;
+
+    // A count far past what the rest of the buffer could hold fails before anything is allocated for it.
+    auto tags = std::vector<std::string>();
+    auto tagsValue = types::ValueTo(&tags);
+    serial::count_type huge = 0x10000000;
+    std::byte hugeCount[5] = {std::byte(1)};
+    memcpy(hugeCount + 1, &huge, sizeof(huge));
+    auto hugeReader = serial::Reader(hugeCount + 1, sizeof(huge));
+    auto hugeDeltaReader = serial::Reader(hugeCount, sizeof(hugeCount));
+    std::cout<<"[bad count         ] expected: 0 0 0, actual: "<<hugeReader.Read(tagsValue)<<" "<<hugeDeltaReader.ReadDelta(tagsValue)<<" "<<tags.size()<<std::endl;
+
+    deltaWriter.Reset();
+    std::cout<<"[delta bad baseline] expected: 0, actual: "<<deltaWriter.WriteDelta(value, baseline, 3)<<std::endl;
+
+    return 0;
+}
@@ -7,6 +7,10 @@ struct Vec {
     Vec sub(Vec v) { return Vec{this->x-v.x, this->y-v.y}; }
 };
 
+struct Point {
+    float x, y;
+};
+
 struct Sprite {
     float angle;
     Vec position;
@@ -16,6 +20,7 @@ struct Sprite {
 
 struct Game {
     std::vector<Sprite> sprites;
+    id::DenseKeyMap16<int> scores;
 };
 
 // Types for Game objects
@@ -24,9 +29,12 @@ auto TFloat   = types::New<float>("float");
 auto TAngle   = types::New<float>("angle");
 auto TString  = types::New<std::string>("string");
 auto TVec     = types::New<Vec>("vec");
+auto TPoint   = types::New<Point>("point");
 auto TSprite  = types::New<Sprite>("sprite");
 auto TSprites = types::New<std::vector<Sprite>>("sprites");
 auto TGame    = types::New<Game>("game");
+auto TId      = types::New<id::Identifier>("identifier");
+auto TScores  = types::New<id::DenseKeyMap16<int>>("scores");
 
 // Define types
 void DefineTypes() {
@@ -60,6 +68,12 @@ void DefineTypes() {
         .Prop<float>("y", TFloat, [](auto v) -> auto { return &v->y; })
     );
 
+    TPoint->Define(types::Def<Point>()
+        .DefaultCreate()
+        .Field("x", TFloat, &Point::x)
+        .Field("y", TFloat, &Point::y)
+    );
+
     TSprite->Define(types::Def<Sprite>()
         .DefaultCreate()
         .Prop<float> ("angle",       TAngle, [](auto v) -> auto { return &v->angle; })
@@ -75,6 +89,17 @@ void DefineTypes() {
     TGame->Define(types::Def<Game>()
         .DefaultCreate()
         .Prop<std::vector<Sprite>>("sprites", TSprites, [](auto s) -> auto { return &s->sprites; })
+        .Field("scores", TScores, &Game::scores)
+    );
+
+    TId->Define(types::Def<id::Identifier>()
+        .DefaultCreate()
+        .ToString([](id::Identifier s) -> std::string { return s.String(); })
+    );
+
+    TScores->Define(types::Def<id::DenseKeyMap16<int>>()
+        .DefaultCreate()
+        .DenseMap<int>(TId, TInt, [](id::DenseKeyMap16<int>* s) -> id::DenseKeyMap16<int>* { return s; })
     );
     
     TSprites->Define(types::Def<std::vector<Sprite>>()
@@ -118,6 +143,52 @@ int main() {
     v.Prop("x").Set(3.0f);
     std::cout<<"[get vec x         ] expected: 3, actual: "<<v.Prop("x").Get<float>()<<std::endl;
 
+    auto vcopy = v;
+    vcopy.Prop("y").Set(5.0f);
+    std::cout<<"[inline vec        ] expected: 1, actual: "<<v.IsInline()<<std::endl;
+    std::cout<<"[inline heap string] expected: 0, actual: "<<hw.IsInline()<<std::endl;
+    std::cout<<"[inline copy owns  ] expected: 2 5, actual: "<<v.Prop("y").Get<float>()<<" "<<vcopy.Prop("y").Get<float>()<<std::endl;
+
+    auto vref = types::ValueOf(Vec{1, 2});
+    auto vrefx = vref.Prop("x");
+    auto vrefcopy = vref;
+    vrefx.Set(9.0f);
+    std::cout<<"[inline prop ref   ] expected: 9 9 1, actual: "<<vrefx.Get<float>()<<" "<<vref.Prop("x").Get<float>()<<" "<<vrefcopy.Prop("x").Get<float>()<<std::endl;
+
+    auto vshared = vref.Shared();
+    auto vsharedcopy = vshared;
+    vsharedcopy.Prop("y").Set(7.0f);
+    std::cout<<"[inline shared     ] expected: 0 7 2, actual: "<<vshared.IsInline()<<" "<<vshared.Prop("y").Get<float>()<<" "<<vref.Prop("y").Get<float>()<<std::endl;
+    std::cout<<"[inline read only  ] expected: 0 3, actual: "<<v.ReadOnly().Prop("x").ReadOnly().Set(9.0f)<<" "<<v.Prop("x").Get<float>()<<std::endl;
+
+    auto vx = TVec->Handle("X");
+    std::cout<<"[prop handle       ] expected: 3 5, actual: "<<v.Prop(vx).Get<float>()<<" "<<vcopy.Prop(TVec->Handle("y")).Get<float>()<<std::endl;
+    std::cout<<"[prop handle wrong ] expected: 0 0, actual: "<<types::ValueOf(Sprite{}).Prop(vx).IsValid()<<" "<<TVec->Handle("z").IsValid()<<std::endl;
+    std::cout<<"[prop insensitive  ] expected: 3, actual: "<<v.Prop("X").Get<float>()<<std::endl;
+
+    auto fieldX = TPoint->Props().Ptr("x");
+    auto fieldY = TPoint->Props().Ptr("y");
+    auto raw = Point{7, 8};
+    *(float*)fieldY->Address(&raw) = 9;
+    std::cout<<"[field address     ] expected: 1 0 4 7 9, actual: "<<fieldX->IsField()<<" "<<fieldX->offset<<" "<<fieldY->offset<<" "<<*(const float*)fieldX->Address((const void*)&raw)<<" "<<raw.y<<std::endl;
+    std::cout<<"[field not prop    ] expected: 0 0, actual: "<<TSprite->Props().Ptr("bottomRight")->IsField()<<" "<<TVec->Props().Ptr("x")->IsField()<<std::endl;
+    auto point = types::ValueOf(Point{3, 4});
+    std::cout<<"[field ref         ] expected: 1 4, actual: "<<(point.Prop("x").Data() == point.Data())<<" "<<point.Prop(TPoint->Handle("y")).Get<float>()<<std::endl;
+
+    auto ordered = NameMap<std::string>([](const std::string& s) -> const std::string { return s; }, true, true);
+    auto unordered = NameMap<std::string>([](const std::string& s) -> const std::string { return s; }, false, false);
+    for (auto name : {"a", "B", "c", "D"}) {
+        ordered.Add(name);
+        unordered.Add(name);
+    }
+    ordered.RemoveName("b");
+    unordered.RemoveName("B");
+    std::cout<<"[name map ordered  ] expected: a c D 1 -1, actual: "<<ordered.At(0)<<" "<<ordered.At(1)<<" "<<ordered.At(2)<<" "<<ordered.IndexOf("C")<<" "<<ordered.IndexOf("B")<<std::endl;
+    std::cout<<"[name map unordered] expected: a D c 1 -1, actual: "<<unordered.At(0)<<" "<<unordered.At(1)<<" "<<unordered.At(2)<<" "<<unordered.IndexOf("D")<<" "<<unordered.IndexOf("d")<<std::endl;
+
+    auto angle = types::ValueOf(1.5f).ReinterpretCast(TAngle);
+    std::cout<<"[inline reinterpret] expected: angle 1.5 1, actual: "<<angle.GetType()->Name()<<" "<<angle.Get<float>()<<" "<<angle.IsInline()<<std::endl;
+
     auto g = new Game();
     g->sprites.push_back(Sprite{});
     g->sprites.push_back(Sprite{45, Vec{0.5, 0.5}, Vec{1, 1}, 0});
@@ -134,6 +205,33 @@ int main() {
         return true;
     });
 
+    auto span = gv.Prop("sprites").Span();
+    auto typed = span.As<Sprite>();
+    std::cout<<"[collection span   ] expected: 2 "<<sizeof(Sprite)<<" 1 45 45 0, actual: "<<span.size<<" "<<span.stride<<" "<<(span.type == TSprite)<<" "<<typed[1].angle<<" "<<span.Get(1).Prop("angle").Get<float>()<<" "<<span.As<Vec>().size()<<std::endl;
+
+    auto spritesValue = gv.Prop("sprites");
+    auto local = types::LocalCollection(spritesValue);
+    local->Iterate([](types::Collection::iter_type* kv) -> bool {
+        kv->value.Prop("frame").Set(7);
+        return true;
+    });
+    auto inPlace = (void*)local.Get() >= (void*)&local && (void*)local.Get() < (void*)(&local + 1);
+    std::cout<<"[local collection  ] expected: 1 2 7 7 2, actual: "<<inPlace<<" "<<local->Size()<<" "<<g->sprites[0].frame<<" "<<g->sprites[1].frame<<" "<<local->Span().size<<std::endl;
+
+    g->scores.Set("a", 1);
+    g->scores.Set("b", 2);
+    g->scores.Set("c", 3);
+    auto scoresValue = gv.Prop("scores");
+    auto scores = types::LocalCollection(scoresValue);
+    auto seen = std::string();
+    scores->Iterate([&seen](types::Collection::iter_type* kv) -> bool {
+        seen += kv->key.Get<id::Identifier>().String() + std::to_string(kv->value.Get<int>());
+        kv->remove = kv->value.Get<int>() == 2;
+        return true;
+    });
+    auto scoreSpan = scoresValue.Span().As<int>();
+    std::cout<<"[dense map         ] expected: a1b2c3 2 1 3 3 1, actual: "<<seen<<" "<<scores->Size()<<" "<<scoreSpan[0]<<" "<<scoreSpan[1]<<" "<<scores->Get(types::ValueOf(id::Identifier("c"), TId)).Get<int>()<<" "<<!scores->Contains(types::ValueOf(id::Identifier("b"), TId))<<std::endl;
+
     std::cout<<std::endl<<std::endl<<"Types:"<<std::endl;
     for (auto type : types::Types()) {
         std::cout<<"Type "<<type->Name()<<std::endl;